@@ -0,0 +1,183 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* aodv-logdump: print the binary event log written by aodvd -E in the
+   same text format as the normal log. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "evlog.h"
+
+/* Formats take %a for an IP address, %u and %d for numbers */
+struct evlog_desc {
+    char *function;
+    char *format;
+};
+
+static struct evlog_desc evlog_desc[EV_MAX] = {
+    [EV_START] = {"main", "aodvd started, pid %u"},
+    [EV_RREQ_RECV] = {"rreq_process", "ip_src=%a rreq_orig=%a rreq_dest=%a ttl=%u"},
+    [EV_RREQ_SEND] = {"rreq_send_mdest", "Sending RREQ for %a seqno=%u ttl=%u"},
+    [EV_RREQ_FWD] = {"rreq_forward", "forwarding RREQ src=%a, rreq_id=%u"},
+    [EV_RREP_RECV] = {"rrep_process", "from %a about %a->%a"},
+    [EV_RREP_SEND] = {"rrep_send", "Sending RREP to next hop %a about %a->%a"},
+    [EV_RREP_FWD] = {"rrep_forward", "Forwarding RREP to %a"},
+    [EV_RERR_RECV] = {"rerr_process", "ip_src=%a"},
+    [EV_RERR_SEND] = {"rerr_agg_timeout", "Sending RERR to %a, %u udests"},
+    [EV_HELLO_RECV] = {"hello_process", "rcvd HELLO from %a, seqno %u"},
+    [EV_NEIGHBOR_ADD] = {"neighbor_add", "%a new NEIGHBOR!"},
+    [EV_LINK_BREAK] = {"neighbor_link_break", "Link %a down!"},
+    [EV_RT_INSERT] = {"rt_table_insert", "Inserting %a next hop %a hcnt=%u"},
+    [EV_RT_INVALIDATE] = {"rt_table_invalidate", "Invalidating %a seqno=%u"},
+    [EV_NO_ROUTE] = {"route_discovery_timeout", "NO ROUTE FOUND for %a!"},
+};
+
+static void print_rec(struct evlog_rec *rec)
+{
+    struct tm *tm;
+    time_t sec = rec->sec;
+    struct in_addr addr;
+    char *p;
+    int i = 0;
+
+    tm = localtime(&sec);
+
+    printf("%02d:%02d:%02d.%03u ", tm->tm_hour, tm->tm_min, tm->tm_sec,
+	   rec->usec / 1000);
+
+    if (rec->event == 0 || rec->event >= EV_MAX ||
+	!evlog_desc[rec->event].format) {
+	printf("unknown event %u: %u %u %u %u\n", rec->event, rec->arg[0],
+	       rec->arg[1], rec->arg[2], rec->arg[3]);
+	return;
+    }
+
+    printf("%s: ", evlog_desc[rec->event].function);
+
+    for (p = evlog_desc[rec->event].format; *p; p++) {
+	if (*p != '%' || !p[1]) {
+	    putchar(*p);
+	    continue;
+	}
+	p++;
+	switch (*p) {
+	case 'a':
+	    addr.s_addr = rec->arg[i++];
+	    printf("%s", inet_ntoa(addr));
+	    break;
+	case 'u':
+	    printf("%u", rec->arg[i++]);
+	    break;
+	case 'd':
+	    printf("%d", (int) rec->arg[i++]);
+	    break;
+	default:
+	    putchar(*p);
+	}
+	if (i == EVLOG_NARGS)
+	    i--;
+    }
+    putchar('\n');
+}
+
+static void usage(char *progname)
+{
+    fprintf(stderr, "Usage: %s [-n N] [file]\n\n"
+	    "-n N  Only print the last N events.\n"
+	    "file  Event log, default %s.\n", progname, AODV_EVLOG_PATH);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    char *path = AODV_EVLOG_PATH;
+    struct evlog_hdr *hdr;
+    struct evlog_rec *recs;
+    struct stat st;
+    u_int32_t head, first, n;
+    unsigned int last = 0;
+    int fd, opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+	switch (opt) {
+	case 'n':
+	    last = atoi(optarg);
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    }
+    if (optind < argc)
+	path = argv[optind];
+
+    if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st) < 0) {
+	perror(path);
+	return 1;
+    }
+
+    if (st.st_size < EVLOG_HDR_SIZE) {
+	fprintf(stderr, "%s: not an event log\n", path);
+	return 1;
+    }
+
+    hdr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (hdr == MAP_FAILED) {
+	perror("mmap");
+	return 1;
+    }
+
+    if (memcmp(hdr->magic, EVLOG_MAGIC, sizeof(EVLOG_MAGIC)) != 0 ||
+	hdr->version != EVLOG_VERSION ||
+	hdr->rec_size != sizeof(struct evlog_rec) || hdr->nrecs == 0 ||
+	st.st_size < EVLOG_HDR_SIZE + (off_t) hdr->nrecs * hdr->rec_size) {
+	fprintf(stderr, "%s: not an event log or wrong version\n", path);
+	return 1;
+    }
+
+    recs = (struct evlog_rec *) ((char *) hdr + EVLOG_HDR_SIZE);
+    head = hdr->head;
+
+    /* Oldest record still in the ring */
+    first = head > hdr->nrecs ? head - hdr->nrecs : 0;
+
+    if (last && head - first > last)
+	first = head - last;
+
+    for (n = first; n != head; n++)
+	print_rec(&recs[n % hdr->nrecs]);
+
+    munmap(hdr, st.st_size);
+
+    return 0;
+}
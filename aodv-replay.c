@@ -0,0 +1,447 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* aodv-replay: run a recorded trace of AODV traffic through the
+ * protocol code, as fast as possible.
+ *
+ * The daemon objects are linked as is, except the netlink layer, which
+ * is replaced by the stubs in nl_stub.c, and main(), which is renamed.
+ * The linker wraps (see the Makefile) gettimeofday() onto a virtual
+ * clock that follows the trace timestamps, sendto()/setsockopt() so
+ * that nothing is actually sent, malloc()/free() to count allocations,
+ * and the message handlers to time them. */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <arpa/inet.h>
+#include <time.h>
+#include <malloc.h>
+
+#include "defs.h"
+#include "debug.h"
+#include "timer_queue.h"
+#include "routing_table.h"
+#include "seek_list.h"
+#include "aodv_socket.h"
+#include "aodv_rreq.h"
+#include "aodv_rrep.h"
+#include "aodv_rerr.h"
+#include "aodv_hello.h"
+#include "nl.h"
+
+extern int ratelimit, wait_on_reboot, bpf_rreq_filter, debug, log_level;
+extern int expanding_ring_search, local_repair, multipath, etx_metric;
+extern char *progname;
+
+/* pcap file format */
+#define PCAP_MAGIC      0xa1b2c3d4
+#define PCAP_MAGIC_NS   0xa1b23c4d	/* Nanosecond timestamps */
+#define LINKTYPE_ETHERNET 1
+#define LINKTYPE_RAW      101
+#define LINKTYPE_LINUX_SLL 113
+#define LINKTYPE_IPV4     228
+
+struct pcap_file_hdr {
+    u_int32_t magic;
+    u_int16_t version_major;
+    u_int16_t version_minor;
+    int32_t thiszone;
+    u_int32_t sigfigs;
+    u_int32_t snaplen;
+    u_int32_t linktype;
+};
+
+struct pcap_rec_hdr {
+    u_int32_t ts_sec;
+    u_int32_t ts_frac;
+    u_int32_t incl_len;
+    u_int32_t orig_len;
+};
+
+/* Handlers that are timed */
+enum {
+    H_RREQ, H_RREP, H_RERR, H_RREP_ACK, H_HELLO, H_TIMERS, H_MAX
+};
+
+static char *h_names[H_MAX] = {
+    "rreq_process", "rrep_process", "rerr_process", "rrep_ack_process",
+    "hello_process", "timers"
+};
+
+static struct {
+    unsigned long calls;
+    unsigned long long nsecs;
+    unsigned long allocs;
+} h_stats[H_MAX];
+
+static struct timeval vclock;	/* Virtual time */
+static int vclock_set = 0;
+static unsigned long n_mallocs, n_frees, n_tx, n_tx_bytes;
+static unsigned long long malloc_bytes;
+
+static unsigned long long nsecs_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Linker wrapped functions */
+
+int __real_gettimeofday(struct timeval *tv, void *tz);
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+void __real_free(void *ptr);
+
+int __wrap_gettimeofday(struct timeval *tv, void *tz)
+{
+    if (!vclock_set)
+	return __real_gettimeofday(tv, tz);
+    *tv = vclock;
+    return 0;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    n_mallocs++;
+    malloc_bytes += size;
+    return __real_malloc(size);
+}
+
+/* gcc turns malloc() followed by memset() into calloc() */
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    n_mallocs++;
+    malloc_bytes += nmemb * size;
+    return __real_calloc(nmemb, size);
+}
+
+void __wrap_free(void *ptr)
+{
+    if (ptr)
+	n_frees++;
+    __real_free(ptr);
+}
+
+ssize_t __wrap_sendto(int s, const void *buf, size_t len, int flags,
+		      const struct sockaddr *to, socklen_t tolen)
+{
+    n_tx++;
+    n_tx_bytes += len;
+    return len;
+}
+
+int __wrap_setsockopt(int s, int level, int optname, const void *optval,
+		      socklen_t optlen)
+{
+    return 0;
+}
+
+#define TIMED(h, call)							\
+	do {								\
+		unsigned long long t0 = nsecs_now();			\
+		unsigned long m0 = n_mallocs;				\
+		call;							\
+		h_stats[h].nsecs += nsecs_now() - t0;			\
+		h_stats[h].allocs += n_mallocs - m0;			\
+		h_stats[h].calls++;					\
+	} while (0)
+
+void __real_rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
+			 struct in_addr ip_dst, int ip_ttl,
+			 unsigned int ifindex);
+void __real_rrep_process(RREP * rrep, int rreplen, struct in_addr ip_src,
+			 struct in_addr ip_dst, int ip_ttl,
+			 unsigned int ifindex);
+void __real_rerr_process(RERR * rerr, int rerrlen, struct in_addr ip_src,
+			 struct in_addr ip_dst);
+void __real_rrep_ack_process(RREP_ack * rrep_ack, int rreplen,
+			     struct in_addr ip_src, struct in_addr ip_dst);
+void __real_hello_process(RREP * hello, int rreplen, unsigned int ifindex);
+
+void __wrap_rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
+			 struct in_addr ip_dst, int ip_ttl,
+			 unsigned int ifindex)
+{
+    TIMED(H_RREQ, __real_rreq_process(rreq, rreqlen, ip_src, ip_dst,
+				      ip_ttl, ifindex));
+}
+
+void __wrap_rrep_process(RREP * rrep, int rreplen, struct in_addr ip_src,
+			 struct in_addr ip_dst, int ip_ttl,
+			 unsigned int ifindex)
+{
+    TIMED(H_RREP, __real_rrep_process(rrep, rreplen, ip_src, ip_dst,
+				      ip_ttl, ifindex));
+}
+
+void __wrap_rerr_process(RERR * rerr, int rerrlen, struct in_addr ip_src,
+			 struct in_addr ip_dst)
+{
+    TIMED(H_RERR, __real_rerr_process(rerr, rerrlen, ip_src, ip_dst));
+}
+
+void __wrap_rrep_ack_process(RREP_ack * rrep_ack, int rreplen,
+			     struct in_addr ip_src, struct in_addr ip_dst)
+{
+    TIMED(H_RREP_ACK, __real_rrep_ack_process(rrep_ack, rreplen, ip_src,
+					      ip_dst));
+}
+
+void __wrap_hello_process(RREP * hello, int rreplen, unsigned int ifindex)
+{
+    TIMED(H_HELLO, __real_hello_process(hello, rreplen, ifindex));
+}
+
+/* Find the IPv4 header of a captured frame */
+static struct iphdr *frame_ip(unsigned char *frame, unsigned int len,
+			      u_int32_t linktype)
+{
+    unsigned int off;
+    u_int16_t proto;
+
+    switch (linktype) {
+    case LINKTYPE_ETHERNET:
+	off = 14;
+	if (len < off)
+	    return NULL;
+	proto = (frame[12] << 8) | frame[13];
+	if (proto == 0x8100 && len >= 18) {	/* VLAN tag */
+	    proto = (frame[16] << 8) | frame[17];
+	    off = 18;
+	}
+	break;
+    case LINKTYPE_LINUX_SLL:
+	off = 16;
+	if (len < off)
+	    return NULL;
+	proto = (frame[14] << 8) | frame[15];
+	break;
+    case LINKTYPE_RAW:
+    case LINKTYPE_IPV4:
+	off = 0;
+	proto = 0x0800;
+	break;
+    default:
+	return NULL;
+    }
+
+    if (proto != 0x0800 || len < off + sizeof(struct iphdr))
+	return NULL;
+
+    return (struct iphdr *) (frame + off);
+}
+
+static void usage(char *name)
+{
+    fprintf(stderr, "Usage: %s -a ADDR [-emLx] [-v N] trace.pcap\n\n"
+	    "-a ADDR  Address of the node the trace was taken on.\n"
+	    "-e, -m, -L, -x  As for aodvd (ETX, multipath, local repair,\n"
+	    "         no expanding ring search).\n"
+	    "-v N     Log level, default 4 (LOG_WARNING).\n", name);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    struct pcap_file_hdr fh;
+    struct pcap_rec_hdr rh;
+    struct in_addr addr, src, dst;
+    unsigned char frame[65536];
+    unsigned long n_pkts = 0, n_aodv = 0, n_own = 0, n_bad = 0;
+    unsigned long long t_start, t_total;
+    u_int32_t first_sec = 0;
+    int opt, swap = 0, nsec = 0, i;
+    FILE *f;
+
+    addr.s_addr = 0;
+    progname = "aodv-replay";
+    log_level = LOG_WARNING;
+
+    while ((opt = getopt(argc, argv, "a:emLxv:h")) != -1) {
+	switch (opt) {
+	case 'a':
+	    if (!inet_aton(optarg, &addr))
+		usage(argv[0]);
+	    break;
+	case 'e':
+	    etx_metric = 1;
+	    break;
+	case 'm':
+	    multipath = 1;
+	    break;
+	case 'L':
+	    local_repair = 1;
+	    break;
+	case 'x':
+	    expanding_ring_search = 0;
+	    break;
+	case 'v':
+	    log_level = atoi(optarg);
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    }
+
+    if (optind >= argc || addr.s_addr == 0)
+	usage(argv[0]);
+
+    if (!(f = fopen(argv[optind], "r"))) {
+	perror(argv[optind]);
+	return 1;
+    }
+
+    if (fread(&fh, sizeof(fh), 1, f) != 1) {
+	fprintf(stderr, "%s: too short\n", argv[optind]);
+	return 1;
+    }
+
+    if (fh.magic == PCAP_MAGIC_NS || fh.magic == ntohl(PCAP_MAGIC_NS))
+	nsec = 1;
+    if (fh.magic == ntohl(PCAP_MAGIC) || fh.magic == ntohl(PCAP_MAGIC_NS)) {
+	swap = 1;
+	fh.linktype = ntohl(fh.linktype);
+    } else if (fh.magic != PCAP_MAGIC && fh.magic != PCAP_MAGIC_NS) {
+	fprintf(stderr, "%s: not a pcap file\n", argv[optind]);
+	return 1;
+    }
+
+    /* Set up a single interface with the traced node's address. The
+       daemon's socket setup is skipped, except for the rate limiter.
+       Log messages go to stdout, not syslog. */
+    debug = 1;
+    wait_on_reboot = 0;
+    bpf_rreq_filter = 0;
+
+    this_host.seqno = 1;
+    this_host.rreq_id = 0;
+    this_host.nif = 1;
+    DEV_NR(0).enabled = 0;
+    DEV_NR(0).sock = -1;
+    DEV_NR(0).ifindex = 1;
+    strcpy(DEV_NR(0).ifname, "replay0");
+    DEV_NR(0).ipaddr = addr;
+    DEV_NR(0).netmask.s_addr = 0;
+    DEV_NR(0).broadcast.s_addr = AODV_BROADCAST;
+    dev_indices[0] = 1;
+
+    rt_table_init();
+    seek_list_init();
+    rreq_blacklist_init();
+
+    t_start = nsecs_now();
+
+    while (fread(&rh, sizeof(rh), 1, f) == 1) {
+	struct iphdr *ip;
+	struct udphdr *udp;
+	unsigned int hlen, len;
+
+	if (swap) {
+	    rh.ts_sec = ntohl(rh.ts_sec);
+	    rh.ts_frac = ntohl(rh.ts_frac);
+	    rh.incl_len = ntohl(rh.incl_len);
+	}
+	if (rh.incl_len > sizeof(frame) ||
+	    fread(frame, rh.incl_len, 1, f) != 1)
+	    break;
+
+	n_pkts++;
+
+	/* Advance the virtual clock and run due timers */
+	vclock.tv_sec = rh.ts_sec;
+	vclock.tv_usec = nsec ? rh.ts_frac / 1000 : rh.ts_frac;
+
+	if (!vclock_set) {
+	    vclock_set = 1;
+	    first_sec = rh.ts_sec;
+	    aodv_socket_init();
+	    DEV_NR(0).enabled = 1;
+	}
+	TIMED(H_TIMERS, timer_age_queue());
+
+	if (!(ip = frame_ip(frame, rh.incl_len, fh.linktype)) ||
+	    ip->protocol != IPPROTO_UDP)
+	    continue;
+
+	hlen = ip->ihl * 4;
+	len = (unsigned char *) ip + ntohs(ip->tot_len) > frame + rh.incl_len ?
+	    frame + rh.incl_len - (unsigned char *) ip : ntohs(ip->tot_len);
+
+	if (len < hlen + sizeof(struct udphdr)) {
+	    n_bad++;
+	    continue;
+	}
+	udp = (struct udphdr *) ((unsigned char *) ip + hlen);
+
+	if (ntohs(udp->dest) != AODV_PORT)
+	    continue;
+
+	src.s_addr = ip->saddr;
+	dst.s_addr = ip->daddr;
+
+	/* Our own messages are generated by the replay itself */
+	if (src.s_addr == addr.s_addr) {
+	    n_own++;
+	    continue;
+	}
+	len -= hlen + sizeof(struct udphdr);
+
+	if (len < sizeof(AODV_msg)) {
+	    n_bad++;
+	    continue;
+	}
+	n_aodv++;
+	aodv_socket_process_packet((AODV_msg *) (udp + 1), len, src, dst,
+				   ip->ttl, 1);
+    }
+    fclose(f);
+
+    t_total = nsecs_now() - t_start;
+
+    printf("Trace: %lu packets, %lu AODV messages processed, %lu own, "
+	   "%lu malformed, %u secs of traffic\n", n_pkts, n_aodv, n_own,
+	   n_bad, vclock_set ? (unsigned) (vclock.tv_sec - first_sec) : 0);
+    printf("Time: %.3f secs, %.0f messages/sec\n", t_total / 1e9,
+	   t_total ? n_aodv / (t_total / 1e9) : 0);
+    printf("Sent: %lu messages, %lu bytes. Kernel routes added/deleted: "
+	   "%lu/%lu, no route: %lu\n", n_tx, n_tx_bytes, nl_stub_add,
+	   nl_stub_del, nl_stub_no_route);
+    printf("Allocations: %lu malloc (%llu bytes), %lu free\n", n_mallocs,
+	   malloc_bytes, n_frees);
+    printf("Routes: %d (%d active)\n\n", rt_tbl.num_entries,
+	   rt_tbl.num_active);
+
+    printf("%-17s %10s %12s %10s %10s\n", "Handler", "calls", "total usecs",
+	   "nsecs/call", "allocs");
+    for (i = 0; i < H_MAX; i++)
+	printf("%-17s %10lu %12llu %10llu %10lu\n", h_names[i],
+	       h_stats[i].calls, h_stats[i].nsecs / 1000,
+	       h_stats[i].calls ? h_stats[i].nsecs / h_stats[i].calls : 0,
+	       h_stats[i].allocs);
+
+    return 0;
+}
@@ -0,0 +1,272 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* aodv-rtdump: rebuild the routing table from the journal written by
+   aodvd -J, as it was at a given time. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/types.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <net/if.h>
+
+#include "rtjournal.h"
+
+#define RTJ_PATH "/var/log/aodvd.rtj"
+
+static struct rtj_rec *table = NULL;
+static int nentries = 0, maxentries = 0;
+
+static char *op_str[] = {
+    "?", "INSERT", "UPDATE", "INVALIDATE", "DELETE",
+    "SNAPSHOT", "ENTRY", "END", "REFRESH"
+};
+
+static struct rtj_rec *table_find(u_int32_t dest_addr)
+{
+    int i;
+
+    for (i = 0; i < nentries; i++)
+	if (table[i].dest_addr == dest_addr)
+	    return &table[i];
+    return NULL;
+}
+
+static void table_apply(struct rtj_rec *rec)
+{
+    struct rtj_rec *e;
+
+    switch (rec->op) {
+    case RTJ_SNAP_BEGIN:
+	nentries = 0;
+	break;
+    case RTJ_DELETE:
+	if ((e = table_find(rec->dest_addr)))
+	    *e = table[--nentries];
+	break;
+    case RTJ_INSERT:
+    case RTJ_UPDATE:
+    case RTJ_REFRESH:
+    case RTJ_INVALIDATE:
+    case RTJ_SNAP_ENTRY:
+	if (!(e = table_find(rec->dest_addr))) {
+	    if (nentries == maxentries) {
+		maxentries = maxentries ? maxentries * 2 : 64;
+		table = realloc(table, maxentries * sizeof(struct rtj_rec));
+		if (!table) {
+		    fprintf(stderr, "Malloc failed!!!\n");
+		    exit(-1);
+		}
+	    }
+	    e = &table[nentries++];
+	}
+	*e = *rec;
+	break;
+    }
+}
+
+static char *addr_str(u_int32_t addr)
+{
+    struct in_addr a;
+
+    a.s_addr = addr;
+    return inet_ntoa(a);
+}
+
+static char *flags_str(u_int16_t flags)
+{
+    static char buf[sizeof(RT_FLAG_CHARS)];
+    int i, len = 0;
+
+    for (i = 0; RT_FLAG_CHARS[i]; i++)
+	if ((flags & (1 << i)) && RT_FLAG_CHARS[i] != ' ')
+	    buf[len++] = RT_FLAG_CHARS[i];
+    buf[len] = '\0';
+
+    return buf;
+}
+
+static char *time_str(u_int32_t sec, u_int32_t usec)
+{
+    static char buf[32];
+    time_t t = sec;
+    struct tm *tm = localtime(&t);
+
+    sprintf(buf, "%02d:%02d:%02d.%03u", tm->tm_hour, tm->tm_min,
+	    tm->tm_sec, usec / 1000);
+    return buf;
+}
+
+static void print_entry(struct rtj_rec *e, char *seqno_str)
+{
+    if (e->dest_seqno == 0)
+	sprintf(seqno_str, "-");
+    else
+	sprintf(seqno_str, "%u", e->dest_seqno);
+
+    printf("%-15s ", addr_str(e->dest_addr));
+    printf("%-15s %-3d %-3s %-5s", addr_str(e->next_hop), e->hcnt,
+	   e->state == VALID ? "VAL" : "INV", seqno_str);
+}
+
+/* Print the table as it was at sec.usec */
+static void print_table(u_int32_t sec, u_int32_t usec)
+{
+    char seqno_str[11];
+    long long now = (long long) sec * 1000 + usec / 1000;
+    int i, active = 0;
+
+    for (i = 0; i < nentries; i++)
+	if (table[i].state == VALID)
+	    active++;
+
+    printf("# Time: %s entries/active: %u/%u\n", time_str(sec, usec),
+	   nentries, active);
+    printf("%-15s %-15s %-3s %-3s %-5s %-6s %-5s %-5s\n",
+	   "Destination", "Next hop", "HC", "St.", "Seqno", "Expire",
+	   "Flags", "Iface");
+
+    for (i = 0; i < nentries; i++) {
+	struct rtj_rec *e = &table[i];
+	long long expire = (long long) e->sec * 1000 + e->usec / 1000 +
+	    e->expire - now;
+	char ifname[IF_NAMESIZE];
+
+	if (!if_indextoname(e->ifindex, ifname))
+	    sprintf(ifname, "%u", e->ifindex);
+
+	print_entry(e, seqno_str);
+	printf(" %-6lld %-5s %-5s\n", expire > 0 ? expire : 0,
+	       flags_str(e->flags), ifname);
+    }
+}
+
+/* Parse either seconds since the epoch or HH:MM:SS on the day of the
+   first record. */
+static int parse_time(char *str, u_int32_t first, u_int32_t * t)
+{
+    int h, m, s;
+    time_t day = first;
+    struct tm tm;
+
+    if (!strchr(str, ':')) {
+	*t = strtoul(str, NULL, 10);
+	return 0;
+    }
+    if (sscanf(str, "%d:%d:%d", &h, &m, &s) != 3)
+	return -1;
+
+    tm = *localtime(&day);
+    tm.tm_hour = h;
+    tm.tm_min = m;
+    tm.tm_sec = s;
+    *t = mktime(&tm);
+
+    return 0;
+}
+
+static void usage(char *progname)
+{
+    fprintf(stderr, "Usage: %s [-l] [-t TIME] [file]\n\n"
+	    "-l       List all journal records.\n"
+	    "-t TIME  Show the table at TIME (HH:MM:SS or secs since the epoch).\n"
+	    "         Default is the end of the journal.\n"
+	    "file     Journal, default %s.\n", progname, RTJ_PATH);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    char *path = RTJ_PATH, *at = NULL;
+    struct rtj_hdr hdr;
+    struct rtj_rec rec;
+    u_int32_t t = 0, last_sec = 0, last_usec = 0;
+    int list = 0, first = 1, opt;
+    FILE *f;
+
+    while ((opt = getopt(argc, argv, "lt:h")) != -1) {
+	switch (opt) {
+	case 'l':
+	    list = 1;
+	    break;
+	case 't':
+	    at = optarg;
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    }
+    if (optind < argc)
+	path = argv[optind];
+
+    if (!(f = fopen(path, "r"))) {
+	perror(path);
+	return 1;
+    }
+
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+	memcmp(hdr.magic, RTJ_MAGIC, sizeof(RTJ_MAGIC)) != 0 ||
+	hdr.version != RTJ_VERSION || hdr.rec_size != sizeof(rec)) {
+	fprintf(stderr, "%s: not a routing table journal or wrong version\n",
+		path);
+	return 1;
+    }
+
+    while (fread(&rec, sizeof(rec), 1, f) == 1) {
+
+	if (first && at && parse_time(at, rec.sec, &t) < 0)
+	    usage(argv[0]);
+	first = 0;
+
+	if (at && rec.sec > t)
+	    break;
+
+	if (list && rec.op != RTJ_SNAP_ENTRY && rec.op != RTJ_SNAP_END) {
+	    char seqno_str[11];
+
+	    printf("%s %-10s ", time_str(rec.sec, rec.usec),
+		   rec.op <= RTJ_REFRESH ? op_str[rec.op] : "?");
+	    if (rec.op == RTJ_SNAP_BEGIN)
+		printf("\n");
+	    else {
+		print_entry(&rec, seqno_str);
+		printf(" %-6u %-5s\n", rec.expire, flags_str(rec.flags));
+	    }
+	}
+	table_apply(&rec);
+	last_sec = rec.sec;
+	last_usec = rec.usec;
+    }
+    fclose(f);
+
+    if (!list) {
+	if (at)
+	    print_table(t, 0);
+	else
+	    print_table(last_sec, last_usec);
+    }
+    return 0;
+}
@@ -0,0 +1,201 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* aodv-stat: show the live statistics published by aodvd -S */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#include "stats.h"
+
+static char *msg_names[STATS_NTYPES] = {
+    "RREQ", "RREP", "RERR", "RREP_ACK", "HELLO"
+};
+
+/* Take a consistent copy of the segment */
+static void stats_read(struct aodv_stats *shm, struct aodv_stats *s)
+{
+    u_int32_t seq;
+
+    do {
+	while ((seq = shm->seq) & 1)
+	    usleep(10);
+	__sync_synchronize();
+	memcpy(s, shm, sizeof(struct aodv_stats));
+	__sync_synchronize();
+    } while (shm->seq != seq);
+}
+
+/* Start of the bucket holding the pct percentile of n samples */
+static long lat_pct(u_int32_t * hist, u_int32_t n, int pct)
+{
+    u_int32_t sum = 0;
+    int b;
+
+    for (b = 0; b < DISC_LAT_BUCKETS - 1; b++) {
+	sum += hist[b];
+	if (sum * 100 >= n * pct)
+	    break;
+    }
+    return disc_lat_bucket_start(b);
+}
+
+static void print_stats(struct aodv_stats *s, int routes)
+{
+    int i;
+
+    printf("aodvd pid %u\n\n", s->pid);
+    printf("%-9s %10s %10s %10s %10s %10s\n", "Type", "rx", "tx",
+	   "dropped", "ratelim", "duplicate");
+
+    for (i = 0; i < STATS_NTYPES; i++)
+	printf("%-9s %10u %10u %10u %10u %10u\n", msg_names[i],
+	       s->msg[i].rx, s->msg[i].tx, s->msg[i].dropped,
+	       s->msg[i].ratelimited, s->msg[i].duplicate);
+
+    printf("\nRoutes %u (%u active), discoveries %u, timers %u\n",
+	   s->rt_entries, s->rt_active, s->seek_entries, s->timers);
+
+    printf("\nRoute discovery latency (msecs):\n");
+    printf("  %-8s %10s %10s %10s %10s\n", "from", "first try", "retried",
+	   "failed", "cached");
+    for (i = 0; i < DISC_LAT_BUCKETS; i++) {
+	if (!s->disc_lat.outcome[DISC_FIRST_TRY][i] &&
+	    !s->disc_lat.outcome[DISC_RETRIED][i] &&
+	    !s->disc_lat.outcome[DISC_FAILED][i] &&
+	    !s->disc_lat.outcome[DISC_CACHED][i])
+	    continue;
+	printf("  %-8ld %10u %10u %10u %10u\n", disc_lat_bucket_start(i),
+	       s->disc_lat.outcome[DISC_FIRST_TRY][i],
+	       s->disc_lat.outcome[DISC_RETRIED][i],
+	       s->disc_lat.outcome[DISC_FAILED][i],
+	       s->disc_lat.outcome[DISC_CACHED][i]);
+    }
+
+    printf("\nFound routes by hop count:\n");
+    printf("  %-5s %10s %8s %8s %8s\n", "hops", "count", "p50", "p90",
+	   "p99");
+    for (i = 0; i < DISC_HOPS_MAX; i++) {
+	u_int32_t *h = s->disc_lat.hops[i];
+	u_int32_t n = 0;
+	int b;
+
+	for (b = 0; b < DISC_LAT_BUCKETS; b++)
+	    n += h[b];
+	if (!n)
+	    continue;
+	printf("  %d%-4s %10u %8ld %8ld %8ld\n", i + 1,
+	       i == DISC_HOPS_MAX - 1 ? "+" : "", n, lat_pct(h, n, 50),
+	       lat_pct(h, n, 90), lat_pct(h, n, 99));
+    }
+
+    printf("\nDiscoveries by RREQs sent:");
+    for (i = 0; i < DISC_ATTEMPTS_MAX; i++)
+	printf(" %d%s:%u", i + 1, i == DISC_ATTEMPTS_MAX - 1 ? "+" : "",
+	       s->disc_lat.attempts[i]);
+    printf("\n");
+
+    if (!routes)
+	return;
+
+    printf("\n%-15s %-15s %-3s %-3s %-10s %-5s\n", "Destination",
+	   "Next hop", "HC", "St.", "Seqno", "Flags");
+
+    for (i = 0; i < (int) s->rt_count && i < STATS_RT_MAX; i++) {
+	struct in_addr a;
+
+	a.s_addr = s->rt[i].dest_addr;
+	printf("%-15s ", inet_ntoa(a));
+	a.s_addr = s->rt[i].next_hop;
+	printf("%-15s %-3u %-3s %-10u 0x%02x\n", inet_ntoa(a),
+	       s->rt[i].hcnt, s->rt[i].state ? "VAL" : "INV",
+	       s->rt[i].dest_seqno, s->rt[i].flags);
+    }
+}
+
+static void usage(char *progname)
+{
+    fprintf(stderr, "Usage: %s [-r] [-i N]\n\n"
+	    "-r    Also show the routing table.\n"
+	    "-i N  Repeat every N msecs.\n", progname);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    struct aodv_stats *shm, s;
+    int fd, opt, routes = 0, interval = 0;
+
+    while ((opt = getopt(argc, argv, "ri:h")) != -1) {
+	switch (opt) {
+	case 'r':
+	    routes = 1;
+	    break;
+	case 'i':
+	    interval = atoi(optarg);
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    }
+
+    if ((fd = shm_open(AODV_STATS_SHM, O_RDONLY, 0)) < 0) {
+	perror("No statistics (is aodvd running with -S?)");
+	return 1;
+    }
+
+    shm = mmap(NULL, sizeof(struct aodv_stats), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (shm == MAP_FAILED) {
+	perror("mmap");
+	return 1;
+    }
+
+    if (memcmp(shm->magic, AODV_STATS_MAGIC, sizeof(AODV_STATS_MAGIC)) != 0
+	|| shm->version != AODV_STATS_VERSION
+	|| shm->size != sizeof(struct aodv_stats)) {
+	fprintf(stderr, "Statistics segment has the wrong version\n");
+	return 1;
+    }
+
+    do {
+	stats_read(shm, &s);
+	print_stats(&s, routes);
+	if (interval) {
+	    printf("\n");
+	    fflush(stdout);
+	    usleep(interval * 1000);
+	}
+    } while (interval);
+
+    return 0;
+}
@@ -33,16 +33,58 @@
 #include "timer_queue.h"
 #include "params.h"
 #include "aodv_socket.h"
+#include "aodv_neighbor.h"
 #include "defs.h"
 #include "debug.h"
+#include "evlog.h"
 
 extern int unidir_hack, receive_n_hellos, hello_jittering, optimized_hellos;
+extern int adaptive_hello, preemptive_repair;
 static struct timer hello_timer;
+static int hello_churn = 0;	/* Neighbor changes since the last hello */
+
+u_int32_t hello_ival = HELLO_INTERVAL;	/* Our current hello interval */
+
+static void hello_lq_update(rt_table_t * rt, struct timeval *now,
+			    u_int32_t interval);
+static int hello_neighbor_bloom(u_int8_t * bloom);
 
 #endif
 
 /* #define DEBUG_HELLO */
 
+/* The neighbor set is sent as a Bloom filter of len bytes (a power of
+   two). The HELLO_BLOOM_K bit positions of an address are derived from
+   one hash by double hashing. */
+static inline int hello_bloom_bit(struct in_addr *addr, int k, int len)
+{
+    u_int32_t h = hash_addr(addr);
+
+    return (h + k * ((h >> 16) | 1)) & (len * 8 - 1);
+}
+
+static void hello_bloom_add(u_int8_t * bloom, int len, struct in_addr *addr)
+{
+    int k, bit;
+
+    for (k = 0; k < HELLO_BLOOM_K; k++) {
+	bit = hello_bloom_bit(addr, k, len);
+	bloom[bit >> 3] |= 1 << (bit & 7);
+    }
+}
+
+static int hello_bloom_test(u_int8_t * bloom, int len, struct in_addr *addr)
+{
+    int k, bit;
+
+    for (k = 0; k < HELLO_BLOOM_K; k++) {
+	bit = hello_bloom_bit(addr, k, len);
+	if (!(bloom[bit >> 3] & (1 << (bit & 7))))
+	    return 0;
+    }
+    return 1;
+}
+
 
 long NS_CLASS hello_jitter()
 {
@@ -77,16 +119,78 @@ void NS_CLASS hello_stop()
     timer_remove(&hello_timer);
 }
 
+/* A neighbor came or went. With adaptive hellos this halves the hello
+   interval, at most once per hello, and brings the next hello forward
+   if needed. */
+void NS_CLASS hello_neighbor_change()
+{
+    struct timeval now;
+
+    if (!adaptive_hello || hello_churn++)
+	return;
+
+    hello_ival /= 2;
+
+    if (hello_ival < HELLO_INTERVAL_MIN)
+	hello_ival = HELLO_INTERVAL_MIN;
+
+    gettimeofday(&now, NULL);
+
+    if (hello_timer.used &&
+	timeval_diff(&hello_timer.timeout, &now) > (long) hello_ival)
+	timer_set_timeout(&hello_timer, hello_ival);
+}
+
+/* Fill in a Bloom filter of the nodes we receive hellos from, sized
+   for HELLO_BLOOM_BITS per neighbor. Returns its length in bytes, or 0
+   if we have no neighbors. */
+NS_STATIC int NS_CLASS hello_neighbor_bloom(u_int8_t * bloom)
+{
+    list_t *pos;
+    int i, n = 0, len = HELLO_BLOOM_MIN;
+
+    /* If an entry has an active hello timer, we assume that we are
+       receiving hello messages from that node... */
+    for (i = 0; i < RT_TABLESIZE; i++)
+	list_foreach(pos, &rt_tbl.tbl[i])
+	    if (((rt_table_t *) pos)->hello_timer.used)
+		n++;
+
+    if (n == 0)
+	return 0;
+
+    while (len * 8 < n * HELLO_BLOOM_BITS && len < HELLO_BLOOM_MAX)
+	len *= 2;
+
+    memset(bloom, 0, len);
+
+    for (i = 0; i < RT_TABLESIZE; i++) {
+	list_foreach(pos, &rt_tbl.tbl[i]) {
+	    rt_table_t *rt = (rt_table_t *) pos;
+
+	    if (rt->hello_timer.used) {
+#ifdef DEBUG_HELLO
+		DEBUG(LOG_INFO, 0, "Adding %s to hello neighbor set ext",
+		      ip_to_str(rt->dest_addr));
+#endif
+		hello_bloom_add(bloom, len, &rt->dest_addr);
+	    }
+	}
+    }
+    return len;
+}
+
 void NS_CLASS hello_send(void *arg)
 {
     RREP *rrep;
     AODV_ext *ext = NULL;
     u_int8_t flags = 0;
+    u_int8_t bloom[HELLO_BLOOM_MAX];
     struct in_addr dest;
     long time_diff, jitter;
     struct timeval now;
     int msg_size = RREP_SIZE;
-    int i;
+    int i, bloom_len = 0;
 
     gettimeofday(&now, NULL);
 
@@ -101,7 +205,20 @@ void NS_CLASS hello_send(void *arg)
 
     /* This check will ensure we don't send unnecessary hello msgs, in case
        we have sent other bcast msgs within HELLO_INTERVAL */
-    if (time_diff >= HELLO_INTERVAL) {
+    if (time_diff >= (long) hello_ival) {
+
+	/* A quiet neighborhood lets the interval grow slowly again */
+	if (adaptive_hello && !hello_churn) {
+	    hello_ival += hello_ival / 4;
+
+	    if (hello_ival > HELLO_INTERVAL_MAX)
+		hello_ival = HELLO_INTERVAL_MAX;
+	}
+	hello_churn = 0;
+
+	/* The neighbor set is the same on all interfaces */
+	if (unidir_hack)
+	    bloom_len = hello_neighbor_bloom(bloom);
 
 	for (i = 0; i < MAX_NR_INTERFACES; i++) {
 	    if (!DEV_NR(i).enabled)
@@ -112,54 +229,32 @@ void NS_CLASS hello_send(void *arg)
 	    rrep = rrep_create(flags, 0, 0, DEV_NR(i).ipaddr,
 			       this_host.seqno,
 			       DEV_NR(i).ipaddr,
-			       ALLOWED_HELLO_LOSS * HELLO_INTERVAL);
-
-	    /* Assemble a RREP extension which contain our neighbor set... */
-	    if (unidir_hack) {
-		int i;
-
-		if (ext)
-		    ext = AODV_EXT_NEXT(ext);
-		else
-		    ext = (AODV_ext *) ((char *) rrep + RREP_SIZE);
-
-		ext->type = RREP_HELLO_NEIGHBOR_SET_EXT;
-		ext->length = 0;
-
-		for (i = 0; i < RT_TABLESIZE; i++) {
-		    list_t *pos;
-		    list_foreach(pos, &rt_tbl.tbl[i]) {
-			rt_table_t *rt = (rt_table_t *) pos;
-			/* If an entry has an active hello timer, we assume
-			   that we are receiving hello messages from that
-			   node... */
-			if (rt->hello_timer.used) {
-#ifdef DEBUG_HELLO
-			    DEBUG(LOG_INFO, 0,
-				  "Adding %s to hello neighbor set ext",
-				  ip_to_str(rt->dest_addr));
-#endif
-			    memcpy(AODV_EXT_DATA(ext), &rt->dest_addr,
-				   sizeof(struct in_addr));
-			    ext->length += sizeof(struct in_addr);
-			}
-		    }
-		}
-		if (ext->length)
-		    msg_size = RREP_SIZE + AODV_EXT_SIZE(ext);
+			       ALLOWED_HELLO_LOSS * hello_ival);
+	    msg_size = RREP_SIZE;
+
+	    /* Neighbors must know when to expect the next hello */
+	    if (adaptive_hello || hello_ival != HELLO_INTERVAL)
+		msg_size = rrep_add_hello_ext(rrep, msg_size, hello_ival);
+
+	    /* Add our neighbor set, so that neighbors can tell if they
+	       hear us but we do not hear them... */
+	    if (bloom_len) {
+		ext = rrep_add_ext(rrep, RREP_HELLO_NEIGHBOR_BLOOM_EXT,
+				   msg_size, bloom_len, (char *) bloom);
+		msg_size += AODV_EXT_SIZE(ext);
 	    }
 	    dest.s_addr = AODV_BROADCAST;
 	    aodv_socket_send((AODV_msg *) rrep, dest, msg_size, 1, &DEV_NR(i));
 	}
 
-	timer_set_timeout(&hello_timer, HELLO_INTERVAL + jitter);
+	timer_set_timeout(&hello_timer, hello_ival + jitter);
     } else {
-	if (HELLO_INTERVAL - time_diff + jitter < 0)
+	if ((long) hello_ival - time_diff + jitter < 0)
 	    timer_set_timeout(&hello_timer,
-			      HELLO_INTERVAL - time_diff - jitter);
+			      hello_ival - time_diff - jitter);
 	else
 	    timer_set_timeout(&hello_timer,
-			      HELLO_INTERVAL - time_diff + jitter);
+			      hello_ival - time_diff + jitter);
     }
 }
 
@@ -172,7 +267,7 @@ void NS_CLASS hello_process(RREP * hello, int rreplen, unsigned int ifindex)
     struct in_addr ext_neighbor, hello_dest;
     rt_table_t *rt;
     AODV_ext *ext = NULL;
-    int i;
+    int i, new_nb;
     struct timeval now;
 
     gettimeofday(&now, NULL);
@@ -185,6 +280,8 @@ void NS_CLASS hello_process(RREP * hello, int rreplen, unsigned int ifindex)
     if (rt)
 	flags = rt->flags;
 
+    new_nb = (!rt || rt->state == INVALID || rt->hcnt != 1);
+
     if (unidir_hack)
 	flags |= RT_UNIDIR;
 
@@ -195,13 +292,25 @@ void NS_CLASS hello_process(RREP * hello, int rreplen, unsigned int ifindex)
 	switch (ext->type) {
 	case RREP_HELLO_INTERVAL_EXT:
 	    if (ext->length == 4) {
-		memcpy(&hello_interval, AODV_EXT_DATA(ext), 4);
-		hello_interval = ntohl(hello_interval);
+		u_int32_t ext_interval;
+
+		memcpy(&ext_interval, AODV_EXT_DATA(ext), 4);
+		ext_interval = ntohl(ext_interval);
 #ifdef DEBUG_HELLO
 		DEBUG(LOG_INFO, 0, "Hello extension interval=%lu!",
-		      hello_interval);
+		      ext_interval);
 #endif
-
+		/* The interval is used as a divisor, so keep it sane */
+		if (ext_interval == 0) {
+		    alog(LOG_WARNING, 0,
+			 __FUNCTION__, "Bad hello interval extension!");
+		    break;
+		}
+		if (ext_interval < HELLO_INTERVAL_MIN)
+		    ext_interval = HELLO_INTERVAL_MIN;
+		else if (ext_interval > HELLO_INTERVAL_MAX)
+		    ext_interval = HELLO_INTERVAL_MAX;
+		hello_interval = ext_interval;
 	    } else
 		alog(LOG_WARNING, 0,
 		     __FUNCTION__, "Bad hello interval extension!");
@@ -219,6 +328,17 @@ void NS_CLASS hello_process(RREP * hello, int rreplen, unsigned int ifindex)
 		    flags &= ~RT_UNIDIR;
 	    }
 	    break;
+	case RREP_HELLO_NEIGHBOR_BLOOM_EXT:
+	    /* Length must be a power of two */
+	    if (ext->length && !(ext->length & (ext->length - 1))) {
+		if (hello_bloom_test((u_int8_t *) AODV_EXT_DATA(ext),
+				     ext->length,
+				     &DEV_IFINDEX(ifindex).ipaddr))
+		    flags &= ~RT_UNIDIR;
+		break;
+	    }
+	    alog(LOG_WARNING, 0, __FUNCTION__, "Bad neighbor set extension!");
+	    break;
 	default:
 	    alog(LOG_WARNING, 0, __FUNCTION__,
 		 "Bad extension!! type=%d, length=%d", ext->type, ext->length);
@@ -236,6 +356,7 @@ void NS_CLASS hello_process(RREP * hello, int rreplen, unsigned int ifindex)
     DEBUG(LOG_DEBUG, 0, "rcvd HELLO from %s, seqno %lu",
 	  ip_to_str(hello_dest), hello_seqno);
 #endif
+    EVLOG(EV_HELLO_RECV, hello_dest.s_addr, hello_seqno, 0, 0);
     /* This neighbor should only be valid after receiving 3
        consecutive hello messages... */
     if (receive_n_hellos)
@@ -278,6 +399,15 @@ void NS_CLASS hello_process(RREP * hello, int rreplen, unsigned int ifindex)
 	}
 	rt_table_update(rt, hello_dest, 1, hello_seqno, timeout, VALID, flags);
     }
+    hello_lq_update(rt, &now, hello_interval);
+    rt->metric = rt_table_link_metric(rt);
+    rt->hello_interval = hello_interval;
+
+    if (preemptive_repair)
+	neighbor_link_quality(rt);
+
+    if (new_nb && rt->state == VALID)
+	hello_neighbor_change();
 
   hello_update:
 
@@ -286,6 +416,40 @@ void NS_CLASS hello_process(RREP * hello, int rreplen, unsigned int ifindex)
 }
 
 
+/* Update the delivery ratio of a neighbor's hellos, counting the ones
+   missed since the last one heard. Must be called before
+   last_hello_time is updated. */
+NS_STATIC void NS_CLASS hello_lq_update(rt_table_t * rt, struct timeval *now,
+					u_int32_t interval)
+{
+    long missed;
+    int old_lq = rt->lq;
+
+    /* A new link starts out in the middle */
+    if (rt->lq == 0 || rt->last_hello_time.tv_sec == 0) {
+	rt->lq = LQ_ONE / 2;
+	rt->lq_trend = 0;
+	rt->lq_degraded = 0;
+	return;
+    }
+
+    if (interval == 0)
+	interval = HELLO_INTERVAL;
+
+    missed = (timeval_diff(now, &rt->last_hello_time) + interval / 2) /
+	interval - 1;
+
+    if (missed > 2 * ALLOWED_HELLO_LOSS)
+	missed = 2 * ALLOWED_HELLO_LOSS;
+
+    while (missed-- > 0)
+	rt->lq -= rt->lq >> LQ_SHIFT;
+
+    rt->lq += (LQ_ONE - rt->lq) >> LQ_SHIFT;
+
+    rt->lq_trend += ((rt->lq - old_lq) - rt->lq_trend) / 4;
+}
+
 #define HELLO_DELAY 50		/* The extra time we should allow an hello
 				   message to take (due to processing) before
 				   assuming lost . */
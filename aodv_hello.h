@@ -34,17 +34,28 @@
 #define ROUTE_TIMEOUT_SLACK 100
 #define JITTER_INTERVAL 100
 
+/* Neighbor set Bloom filter. With 10 bits and 3 hashes per neighbor
+   about 2% of the non-neighbors are taken for neighbors. */
+#define HELLO_BLOOM_K   3
+#define HELLO_BLOOM_BITS 10	/* Per neighbor */
+#define HELLO_BLOOM_MIN 8	/* Bytes, powers of two */
+#define HELLO_BLOOM_MAX 128
+
 void hello_start();
 void hello_stop();
 void hello_send(void *arg);
 void hello_process(RREP * hello, int rreplen, unsigned int ifindex);
 void hello_process_non_hello(AODV_msg * aodv_msg, struct in_addr source,
 			     unsigned int ifindex);
+void hello_neighbor_change();
 NS_INLINE void hello_update_timeout(rt_table_t * rt, struct timeval *now,
 				    long time);
 
 #ifdef NS_PORT
 long hello_jitter();
+void hello_lq_update(rt_table_t * rt, struct timeval *now,
+		     u_int32_t interval);
+int hello_neighbor_bloom(u_int8_t * bloom);
 #endif
 #endif				/* NS_NO_DECLARATIONS */
 
@@ -27,10 +27,12 @@
 #include "aodv_rerr.h"
 #include "aodv_hello.h"
 #include "aodv_socket.h"
+#include "aodv_rreq.h"
 #include "routing_table.h"
 #include "params.h"
 #include "defs.h"
 #include "debug.h"
+#include "evlog.h"
 
 extern int llfeedback;
 #endif				/* NS_PORT */
@@ -50,6 +52,7 @@ void NS_CLASS neighbor_add(AODV_msg * aodv_msg, struct in_addr source,
 
     if (!rt) {
 	DEBUG(LOG_DEBUG, 0, "%s new NEIGHBOR!", ip_to_str(source));
+	EVLOG(EV_NEIGHBOR_ADD, source.s_addr, 0, 0, 0);
 	rt = rt_table_insert(source, source, 1, 0,
 			     ACTIVE_ROUTE_TIMEOUT, VALID, 0, ifindex);
     } else {
@@ -65,21 +68,61 @@ void NS_CLASS neighbor_add(AODV_msg * aodv_msg, struct in_addr source,
     }
 
     if (!llfeedback && rt->hello_timer.used)
-	hello_update_timeout(rt, &now, ALLOWED_HELLO_LOSS * HELLO_INTERVAL);
+	hello_update_timeout(rt, &now, ALLOWED_HELLO_LOSS *
+			     (rt->hello_interval ? rt->hello_interval :
+			      HELLO_INTERVAL));
 
     return;
 }
 
+/* Check the hello delivery ratio of a neighbor. When it is low and
+   still falling the link is likely to break soon, so routes through it
+   are switched to an alternate (multipath) or rediscovered in the
+   background while they still work. */
+void NS_CLASS neighbor_link_quality(rt_table_t * nb)
+{
+    int i;
+
+    if (nb->lq_degraded) {
+	if (nb->lq >= LQ_RECOVER)
+	    nb->lq_degraded = 0;
+	return;
+    }
+
+    if (nb->state != VALID || nb->hcnt != 1 ||
+	nb->lq >= LQ_DEGRADE || nb->lq_trend >= 0)
+	return;
+
+    nb->lq_degraded = 1;
+
+    DEBUG(LOG_DEBUG, 0, "Link %s degrading, lq=%d trend=%d",
+	  ip_to_str(nb->dest_addr), nb->lq, nb->lq_trend);
+
+    for (i = 0; i < RT_TABLESIZE; i++) {
+	list_t *pos;
+	list_foreach(pos, &rt_tbl.tbl[i]) {
+	    rt_table_t *rt_u = (rt_table_t *) pos;
+
+	    if (rt_u->state != VALID ||
+		rt_u->next_hop.s_addr != nb->dest_addr.s_addr ||
+		rt_u->dest_addr.s_addr == nb->dest_addr.s_addr)
+		continue;
+
+	    if (!rt_table_failover(rt_u))
+		rreq_preempt(rt_u);
+	}
+    }
+}
+
 void NS_CLASS neighbor_link_break(rt_table_t * rt)
 {
     /* If hopcount = 1, this is a direct neighbor and a link break has
        occured. Send a RERR with the incremented sequence number */
     RERR *rerr = NULL;
-    rt_table_t *rt_u;
-    struct in_addr rerr_unicast_dest;
+    struct rerr_targets targets;
     int i;
 
-    rerr_unicast_dest.s_addr = 0;
+    rerr_targets_init(&targets);
 
     if (!rt)
 	return;
@@ -91,6 +134,7 @@ void NS_CLASS neighbor_link_break(rt_table_t * rt)
     }
 
     DEBUG(LOG_DEBUG, 0, "Link %s down!", ip_to_str(rt->dest_addr));
+    EVLOG(EV_LINK_BREAK, rt->dest_addr.s_addr, 0, 0, 0);
 
     /* Invalidate the entry of the route that broke or timed out... */
     rt_table_invalidate(rt);
@@ -101,8 +145,7 @@ void NS_CLASS neighbor_link_break(rt_table_t * rt)
 	DEBUG(LOG_DEBUG, 0, "Added %s as unreachable, seqno=%lu",
 	      ip_to_str(rt->dest_addr), rt->dest_seqno);
 
-	if (rt->nprec == 1)
-	    rerr_unicast_dest = FIRST_PREC(rt->precursors)->neighbor;
+	rerr_targets_add(&targets, rt);
     }
 
     /* Purge precursor list: */
@@ -118,10 +161,19 @@ void NS_CLASS neighbor_link_break(rt_table_t * rt)
 	list_foreach(pos, &rt_tbl.tbl[i]) {
 	    rt_table_t *rt_u = (rt_table_t *) pos;
 
+	    /* Alternates through the lost neighbor are gone too */
+	    if (rt_u->npaths)
+		rt_table_remove_path(rt_u, rt->dest_addr);
+
 	    if (rt_u->state == VALID &&
 		rt_u->next_hop.s_addr == rt->dest_addr.s_addr &&
 		rt_u->dest_addr.s_addr != rt->dest_addr.s_addr) {
 
+		/* With multipath, switch to an alternate next hop
+		   directly instead of reporting the route as lost. */
+		if (rt_table_failover(rt_u))
+		    continue;
+
 		/* If the link that broke are marked for repair,
 		   then do the same for all additional unreachable
 		   destinations. */
@@ -140,37 +192,27 @@ void NS_CLASS neighbor_link_break(rt_table_t * rt)
 
 		if (rt_u->nprec) {
 
+		    /* Send a full RERR and continue in a new one */
+		    if (rerr && rerr->dest_count == RERR_MAX_UDEST) {
+			rerr_targets_send(&targets, rerr);
+			rerr_targets_init(&targets);
+			rerr = NULL;
+		    }
 		    if (!rerr) {
 			rerr =
 			    rerr_create(0, rt_u->dest_addr, rt_u->dest_seqno);
 
-			if (rt_u->nprec == 1)
-			    rerr_unicast_dest =
-				FIRST_PREC(rt_u->precursors)->neighbor;
-
 			DEBUG(LOG_DEBUG, 0,
 			      "Added %s as unreachable, seqno=%lu",
 			      ip_to_str(rt_u->dest_addr), rt_u->dest_seqno);
 		    } else {
-			/* Decide whether new precursors make this a non unicast
-			   RERR */
 			rerr_add_udest(rerr, rt_u->dest_addr, rt_u->dest_seqno);
 
-			if (rerr_unicast_dest.s_addr) {
-			    list_t *pos2;
-			    list_foreach(pos2, &rt_u->precursors) {
-				precursor_t *pr = (precursor_t *) pos2;
-				if (pr->neighbor.s_addr !=
-				    rerr_unicast_dest.s_addr) {
-				    rerr_unicast_dest.s_addr = 0;
-				    break;
-				}
-			    }
-			}
 			DEBUG(LOG_DEBUG, 0,
 			      "Added %s as unreachable, seqno=%lu",
 			      ip_to_str(rt_u->dest_addr), rt_u->dest_seqno);
 		    }
+		    rerr_targets_add(&targets, rt_u);
 		}
 		precursor_list_destroy(rt_u);
 	    }
@@ -180,26 +222,6 @@ void NS_CLASS neighbor_link_break(rt_table_t * rt)
     if (rerr) {
 	DEBUG(LOG_DEBUG, 0, "RERR created, %d bytes.", RERR_CALC_SIZE(rerr));
 
-	rt_u = rt_table_find(rerr_unicast_dest);
-
-	if (rt_u && rerr->dest_count == 1 && rerr_unicast_dest.s_addr)
-	    aodv_socket_send((AODV_msg *) rerr,
-			     rerr_unicast_dest,
-			     RERR_CALC_SIZE(rerr), 1,
-			     &DEV_IFINDEX(rt_u->ifindex));
-
-	else if (rerr->dest_count > 0) {
-	    /* FIXME: Should only transmit RERR on those interfaces
-	     * which have precursor nodes for the broken route */
-	    for (i = 0; i < MAX_NR_INTERFACES; i++) {
-		struct in_addr dest;
-
-		if (!DEV_NR(i).enabled)
-		    continue;
-		dest.s_addr = AODV_BROADCAST;
-		aodv_socket_send((AODV_msg *) rerr, dest,
-				 RERR_CALC_SIZE(rerr), 1, &DEV_NR(i));
-	    }
-	}
+	rerr_targets_send(&targets, rerr);
     }
 }
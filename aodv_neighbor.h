@@ -33,6 +33,7 @@
 void neighbor_add(AODV_msg * aodv_msg, struct in_addr source,
 		  unsigned int ifindex);
 void neighbor_link_break(rt_table_t * rt);
+void neighbor_link_quality(rt_table_t * nb);
 
 #endif				/* NS_NO_DECLARATIONS */
 
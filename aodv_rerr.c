@@ -31,8 +31,13 @@
 #include "aodv_timeout.h"
 #include "defs.h"
 #include "debug.h"
+#include "evlog.h"
 #include "params.h"
+#include "passive.h"
 
+static LIST(rerr_aggs);
+
+extern int rerr_agg_window, passive_learning;
 #endif
 
 RERR *NS_CLASS rerr_create(u_int8_t flags, struct in_addr dest_addr,
@@ -66,6 +71,180 @@ void NS_CLASS rerr_add_udest(RERR * rerr, struct in_addr udest,
     rerr->dest_count++;
 }
 
+/* Add the unreachable destinations of "other" to "rerr", skipping
+   those already present (but keeping the most recent sequence
+   number). "rerr" must have room for a maximum size RERR. Returns -1,
+   leaving "rerr" untouched, if the flags differ or the result would
+   not fit. */
+int NS_CLASS rerr_merge(RERR * rerr, RERR * other)
+{
+    RERR_udest *ud, *oud;
+    int i, j, nnew = 0;
+
+    if (rerr->n != other->n)
+	return -1;
+
+    oud = RERR_UDEST_FIRST(other);
+
+    for (i = 0; i < other->dest_count; i++, oud = RERR_UDEST_NEXT(oud)) {
+	ud = RERR_UDEST_FIRST(rerr);
+	for (j = 0; j < rerr->dest_count; j++, ud = RERR_UDEST_NEXT(ud))
+	    if (ud->dest_addr == oud->dest_addr)
+		break;
+	if (j == rerr->dest_count)
+	    nnew++;
+    }
+
+    if (rerr->dest_count + nnew > RERR_MAX_UDEST)
+	return -1;
+
+    oud = RERR_UDEST_FIRST(other);
+
+    for (i = 0; i < other->dest_count; i++, oud = RERR_UDEST_NEXT(oud)) {
+	ud = RERR_UDEST_FIRST(rerr);
+	for (j = 0; j < rerr->dest_count; j++, ud = RERR_UDEST_NEXT(ud))
+	    if (ud->dest_addr == oud->dest_addr)
+		break;
+
+	if (j < rerr->dest_count) {
+	    if ((int32_t) ntohl(oud->dest_seqno) >
+		(int32_t) ntohl(ud->dest_seqno))
+		ud->dest_seqno = oud->dest_seqno;
+	} else {
+	    struct in_addr dest_addr;
+
+	    dest_addr.s_addr = oud->dest_addr;
+	    rerr_add_udest(rerr, dest_addr, ntohl(oud->dest_seqno));
+	}
+    }
+    return 0;
+}
+
+
+/* Send a RERR, possibly after merging it with other RERRs to the same
+   destination and interface that are generated within
+   rerr_agg_window msecs. A link break, or a burst of data packets
+   without route, typically produces many RERRs in quick succession. */
+void NS_CLASS rerr_send(RERR * rerr, struct in_addr dst,
+			struct dev_info *dev)
+{
+    struct rerr_agg *agg;
+    list_t *pos;
+
+    if (!rerr_agg_window) {
+	aodv_socket_send((AODV_msg *) rerr, dst, RERR_CALC_SIZE(rerr), 1, dev);
+	return;
+    }
+
+    list_foreach(pos, &rerr_aggs) {
+	agg = (struct rerr_agg *) pos;
+
+	if (agg->dev != dev || agg->dst.s_addr != dst.s_addr)
+	    continue;
+
+	if (rerr_merge((RERR *) agg->msg, rerr) == 0) {
+	    DEBUG(LOG_DEBUG, 0, "Merged RERR to %s, %d udests",
+		  ip_to_str(dst), ((RERR *) agg->msg)->dest_count);
+
+	    if (((RERR *) agg->msg)->dest_count == RERR_MAX_UDEST)
+		timer_timeout_now(&agg->agg_timer);
+	    return;
+	}
+	/* Flags differ or the RERR is full, send the pending one now
+	   and start over. */
+	timer_timeout_now(&agg->agg_timer);
+	break;
+    }
+
+    if ((agg = (struct rerr_agg *) malloc(sizeof(struct rerr_agg))) == NULL) {
+	fprintf(stderr, "Malloc failed!!!\n");
+	exit(-1);
+    }
+    memcpy(agg->msg, rerr, RERR_CALC_SIZE(rerr));
+    agg->dev = dev;
+    agg->dst = dst;
+
+    timer_init(&agg->agg_timer, &NS_CLASS rerr_agg_timeout, agg);
+    list_add_tail(&rerr_aggs, &agg->l);
+
+    timer_set_timeout(&agg->agg_timer, rerr_agg_window);
+}
+
+void NS_CLASS rerr_agg_timeout(void *arg)
+{
+    struct rerr_agg *agg = (struct rerr_agg *) arg;
+    RERR *rerr = (RERR *) agg->msg;
+
+    list_detach(&agg->l);
+
+    DEBUG(LOG_DEBUG, 0, "Sending RERR to %s, %d udests",
+	  ip_to_str(agg->dst), rerr->dest_count);
+    EVLOG(EV_RERR_SEND, agg->dst.s_addr, rerr->dest_count, 0, 0);
+
+    aodv_socket_send((AODV_msg *) rerr, agg->dst, RERR_CALC_SIZE(rerr), 1,
+		     agg->dev);
+    free(agg);
+}
+
+/* Get rid of all pending aggregated RERRs. The daemon sends them
+   before it goes down, in ns-2 the simulation is over and they are
+   just freed. */
+void NS_CLASS rerr_agg_cleanup(void)
+{
+    struct rerr_agg *agg;
+
+    while (!list_empty(&rerr_aggs)) {
+	agg = (struct rerr_agg *) list_first(&rerr_aggs);
+	timer_remove(&agg->agg_timer);
+#ifdef NS_PORT
+	list_detach(&agg->l);
+	free(agg);
+#else
+	rerr_agg_timeout(agg);
+#endif
+    }
+}
+
+void NS_CLASS rerr_targets_init(struct rerr_targets *t)
+{
+    memset(t, 0, sizeof(struct rerr_targets));
+}
+
+/* Account for the precursors of a route that is about to be reported
+   unreachable. */
+void NS_CLASS rerr_targets_add(struct rerr_targets *t, rt_table_t * rt)
+{
+    list_t *pos;
+    int i;
+
+    list_foreach(pos, &rt->precursors) {
+	precursor_t *pr = (precursor_t *) pos;
+
+	i = ifindex2devindex(pr->ifindex);
+
+	if (i < 0 || i >= MAX_NR_INTERFACES)
+	    continue;
+
+	if (t->dst[i].s_addr == 0)
+	    t->dst[i] = pr->neighbor;
+	else if (t->dst[i].s_addr != pr->neighbor.s_addr)
+	    t->dst[i].s_addr = AODV_BROADCAST;
+    }
+}
+
+/* Send the RERR on every interface that has affected precursors,
+   unicast if there is only one of them there. */
+void NS_CLASS rerr_targets_send(struct rerr_targets *t, RERR * rerr)
+{
+    int i;
+
+    for (i = 0; i < MAX_NR_INTERFACES; i++) {
+	if (!DEV_NR(i).enabled || t->dst[i].s_addr == 0)
+	    continue;
+
+	rerr_send(rerr, t->dst[i], &DEV_NR(i));
+    }
+}
 
 void NS_CLASS rerr_process(RERR * rerr, int rerrlen, struct in_addr ip_src,
 			   struct in_addr ip_dst)
@@ -74,12 +253,13 @@ void NS_CLASS rerr_process(RERR * rerr, int rerrlen, struct in_addr ip_src,
     RERR_udest *udest;
     rt_table_t *rt;
     u_int32_t rerr_dest_seqno;
-    struct in_addr udest_addr, rerr_unicast_dest;
-    int i;
+    struct in_addr udest_addr;
+    struct rerr_targets targets;
 
-    rerr_unicast_dest.s_addr = 0;
+    rerr_targets_init(&targets);
 
     DEBUG(LOG_DEBUG, 0, "ip_src=%s", ip_to_str(ip_src));
+    EVLOG(EV_RERR_RECV, ip_src.s_addr, 0, 0, 0);
 
     log_pkt_fields((AODV_msg *) rerr);
 
@@ -104,8 +284,25 @@ void NS_CLASS rerr_process(RERR * rerr, int rerrlen, struct in_addr ip_src,
 
 	rt = rt_table_find(udest_addr);
 
+#ifndef NS_PORT
+	if (passive_learning)
+	    passive_forget(udest_addr, rerr_dest_seqno, ip_src);
+#endif
+
+	/* The sender lost its route, so it is no alternate either */
+	if (rt && rt->npaths)
+	    rt_table_remove_path(rt, ip_src);
+
 	if (rt && rt->state == VALID && rt->next_hop.s_addr == ip_src.s_addr) {
 
+	    /* With multipath, switch to an alternate next hop instead
+	       of reporting the route as lost. */
+	    if (rt_table_failover(rt)) {
+		udest = RERR_UDEST_NEXT(udest);
+		rerr->dest_count--;
+		continue;
+	    }
+
 	    /* Checking sequence numbers here is an out of draft
 	     * addition to AODV-UU. It is here because it makes a lot
 	     * of sense... */
@@ -144,29 +341,13 @@ void NS_CLASS rerr_process(RERR * rerr, int rerrlen, struct in_addr ip_src,
 					   rt->dest_seqno);
 		    DEBUG(LOG_DEBUG, 0, "Added %s as unreachable, seqno=%lu",
 			  ip_to_str(rt->dest_addr), rt->dest_seqno);
-
-		    if (rt->nprec == 1)
-			rerr_unicast_dest =
-			    FIRST_PREC(rt->precursors)->neighbor;
-
 		} else {
-		    /* Decide whether new precursors make this a non unicast RERR */
 		    rerr_add_udest(new_rerr, rt->dest_addr, rt->dest_seqno);
 
 		    DEBUG(LOG_DEBUG, 0, "Added %s as unreachable, seqno=%lu",
 			  ip_to_str(rt->dest_addr), rt->dest_seqno);
-
-		    if (rerr_unicast_dest.s_addr) {
-			list_t *pos2;
-			list_foreach(pos2, &rt->precursors) {
-			    precursor_t *pr = (precursor_t *) pos2;
-			    if (pr->neighbor.s_addr != rerr_unicast_dest.s_addr) {
-				rerr_unicast_dest.s_addr = 0;
-				break;
-			    }
-			}
-		    }
 		}
+		rerr_targets_add(&targets, rt);
 	    } else {
 		DEBUG(LOG_DEBUG, 0,
 		      "Not sending RERR, no precursors or route in RT_REPAIR");
@@ -183,28 +364,6 @@ void NS_CLASS rerr_process(RERR * rerr, int rerrlen, struct in_addr ip_src,
     }				/* End while() */
 
     /* If a RERR was created, then send it now... */
-    if (new_rerr) {
-
-	rt = rt_table_find(rerr_unicast_dest);
-
-	if (rt && new_rerr->dest_count == 1 && rerr_unicast_dest.s_addr)
-	    aodv_socket_send((AODV_msg *) new_rerr,
-			     rerr_unicast_dest,
-			     RERR_CALC_SIZE(new_rerr), 1,
-			     &DEV_IFINDEX(rt->ifindex));
-
-	else if (new_rerr->dest_count > 0) {
-	    /* FIXME: Should only transmit RERR on those interfaces
-	     * which have precursor nodes for the broken route */
-	    for (i = 0; i < MAX_NR_INTERFACES; i++) {
-		struct in_addr dest;
-
-		if (!DEV_NR(i).enabled)
-		    continue;
-		dest.s_addr = AODV_BROADCAST;
-		aodv_socket_send((AODV_msg *) new_rerr, dest,
-				 RERR_CALC_SIZE(new_rerr), 1, &DEV_NR(i));
-	    }
-	}
-    }
+    if (new_rerr)
+	rerr_targets_send(&targets, new_rerr);
 }
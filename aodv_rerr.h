@@ -59,17 +59,45 @@ typedef struct {
 
 #define RERR_UDEST_SIZE sizeof(RERR_udest)
 
+/* Max number of extra unreachable destinations in one RERR */
+#define RERR_MAX_UDEST 100
+#define RERR_MAX_SIZE (RERR_SIZE + RERR_MAX_UDEST * RERR_UDEST_SIZE)
+
 /* Given the total number of unreachable destination this macro
    returns the RERR size */
 #define RERR_CALC_SIZE(rerr) (RERR_SIZE + (rerr->dest_count-1)*RERR_UDEST_SIZE)
 #define RERR_UDEST_FIRST(rerr) ((RERR_udest *)&rerr->dest_addr)
 #define RERR_UDEST_NEXT(udest) ((RERR_udest *)((char *)udest + RERR_UDEST_SIZE))
+
+/* RERRs to the same neighbor (or broadcast) on the same interface
+   are collected for a short window and sent as one message. */
+struct rerr_agg {
+    list_t l;
+    struct dev_info *dev;
+    struct in_addr dst;
+    struct timer agg_timer;
+    char msg[RERR_MAX_SIZE];
+};
+
+/* Where a RERR should go, one entry per interface: 0 if there are no
+   affected precursors on that interface, the precursor's address if
+   there is exactly one, and AODV_BROADCAST otherwise. */
+struct rerr_targets {
+    struct in_addr dst[MAX_NR_INTERFACES];
+};
 #endif				/* NS_NO_GLOBALS */
 
 #ifndef NS_NO_DECLARATIONS
 RERR *rerr_create(u_int8_t flags, struct in_addr dest_addr,
 		  u_int32_t dest_seqno);
 void rerr_add_udest(RERR * rerr, struct in_addr udest, u_int32_t udest_seqno);
+int rerr_merge(RERR * rerr, RERR * other);
+void rerr_send(RERR * rerr, struct in_addr dst, struct dev_info *dev);
+void rerr_agg_timeout(void *arg);
+void rerr_agg_cleanup(void);
+void rerr_targets_init(struct rerr_targets *t);
+void rerr_targets_add(struct rerr_targets *t, rt_table_t * rt);
+void rerr_targets_send(struct rerr_targets *t, RERR * rerr);
 void rerr_process(RERR * rerr, int rerrlen, struct in_addr ip_src,
 		  struct in_addr ip_dst);
 #endif				/* NS_NO_DECLARATIONS */
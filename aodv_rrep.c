@@ -34,9 +34,10 @@
 #include "aodv_socket.h"
 #include "defs.h"
 #include "debug.h"
+#include "evlog.h"
 #include "params.h"
 
-extern int unidir_hack, optimized_hellos, llfeedback;
+extern int unidir_hack, optimized_hellos, llfeedback, etx_metric;
 
 #endif
 
@@ -124,23 +125,48 @@ AODV_ext *NS_CLASS rrep_add_ext(RREP * rrep, int type, unsigned int offset,
     return ext;
 }
 
+/* Include a metric extension with our ETX to the destination, if ETX
+   is in use, and return the new offset. */
+int NS_CLASS rrep_add_metric_ext(RREP * rrep, int offset, u_int32_t metric)
+{
+    AODV_ext *ext;
+
+    if (!etx_metric)
+	return offset;
+
+    metric = htonl(metric);
+    ext = rrep_add_ext(rrep, RREP_METRIC_EXT, offset, sizeof(u_int32_t),
+		       (char *) &metric);
+
+    return offset + AODV_EXT_SIZE(ext);
+}
+
 void NS_CLASS rrep_send(RREP * rrep, rt_table_t * rev_rt,
 			rt_table_t * fwd_rt, int size)
 {
-    u_int8_t rrep_flags = 0;
-    struct in_addr dest;
-
     if (!rev_rt) {
 	DEBUG(LOG_WARNING, 0, "Can't send RREP, rev_rt = NULL!");
 	return;
     }
+    rrep_send_via(rrep, rev_rt, fwd_rt, rev_rt->next_hop, rev_rt->ifindex,
+		  size);
+}
+
+/* Send a RREP towards rev_rt's destination through next_hop, which
+   is either its next hop or an alternate one (multipath). */
+void NS_CLASS rrep_send_via(RREP * rrep, rt_table_t * rev_rt,
+			    rt_table_t * fwd_rt, struct in_addr next_hop,
+			    unsigned int ifindex, int size)
+{
+    u_int8_t rrep_flags = 0;
+    struct in_addr dest;
 
     dest.s_addr = rrep->dest_addr;
 
     /* Check if we should request a RREP-ACK */
     if ((rev_rt->state == VALID && rev_rt->flags & RT_UNIDIR) ||
 	(rev_rt->hcnt == 1 && unidir_hack)) {
-	rt_table_t *neighbor = rt_table_find(rev_rt->next_hop);
+	rt_table_t *neighbor = rt_table_find(next_hop);
 
 	if (neighbor && neighbor->state == VALID && !neighbor->ack_timer.used) {
 	    /* If the node we received a RREQ for is a neighbor we are
@@ -163,16 +189,18 @@ void NS_CLASS rrep_send(RREP * rrep, rt_table_t * rev_rt,
     }
 
     DEBUG(LOG_DEBUG, 0, "Sending RREP to next hop %s about %s->%s",
-	  ip_to_str(rev_rt->next_hop), ip_to_str(rev_rt->dest_addr),
+	  ip_to_str(next_hop), ip_to_str(rev_rt->dest_addr),
 	  ip_to_str(dest));
+    EVLOG(EV_RREP_SEND, next_hop.s_addr, rev_rt->dest_addr.s_addr,
+	  dest.s_addr, 0);
 
-    aodv_socket_send((AODV_msg *) rrep, rev_rt->next_hop, size, MAXTTL,
-		     &DEV_IFINDEX(rev_rt->ifindex));
+    aodv_socket_send((AODV_msg *) rrep, next_hop, size, MAXTTL,
+		     &DEV_IFINDEX(ifindex));
 
     /* Update precursor lists */
     if (fwd_rt) {
-	precursor_add(fwd_rt, rev_rt->next_hop);
-	precursor_add(rev_rt, fwd_rt->next_hop);
+	precursor_add(fwd_rt, next_hop, ifindex);
+	precursor_add(rev_rt, fwd_rt->next_hop, fwd_rt->ifindex);
     }
 
     if (!llfeedback && optimized_hellos)
@@ -194,6 +222,7 @@ void NS_CLASS rrep_forward(RREP * rrep, int size, rt_table_t * rev_rt,
     }
 
     DEBUG(LOG_DEBUG, 0, "Forwarding RREP to %s", ip_to_str(rev_rt->next_hop));
+    EVLOG(EV_RREP_FWD, rev_rt->next_hop.s_addr, 0, 0, 0);
 
     /* Here we should do a check if we should request a RREP_ACK,
        i.e we suspect a unidirectional link.. But how? */
@@ -220,13 +249,13 @@ void NS_CLASS rrep_forward(RREP * rrep, int size, rt_table_t * rev_rt,
     }
 
     rrep = (RREP *) aodv_socket_queue_msg((AODV_msg *) rrep, size);
-    rrep->hcnt = fwd_rt->hcnt;	/* Update the hopcount */
+    rrep->hcnt = rt_table_adv_hcnt(fwd_rt);	/* Update the hopcount */
 
     aodv_socket_send((AODV_msg *) rrep, rev_rt->next_hop, size, ttl,
 		     &DEV_IFINDEX(rev_rt->ifindex));
 
-    precursor_add(fwd_rt, rev_rt->next_hop);
-    precursor_add(rev_rt, fwd_rt->next_hop);
+    precursor_add(fwd_rt, rev_rt->next_hop, rev_rt->ifindex);
+    precursor_add(rev_rt, fwd_rt->next_hop, fwd_rt->ifindex);
 
     rt_table_update_timeout(rev_rt, ACTIVE_ROUTE_TIMEOUT);
 }
@@ -242,6 +271,8 @@ void NS_CLASS rrep_process(RREP * rrep, int rreplen, struct in_addr ip_src,
     AODV_ext *ext;
     unsigned int extlen = 0;
     int rt_flags = 0;
+    u_int32_t rrep_metric = 0, metric;
+    AODV_ext *metric_ext = NULL;
     struct in_addr rrep_dest, rrep_orig;
 #ifdef CONFIG_GATEWAY
     struct in_addr inet_dest_addr;
@@ -269,6 +300,7 @@ void NS_CLASS rrep_process(RREP * rrep, int rreplen, struct in_addr ip_src,
 
     DEBUG(LOG_DEBUG, 0, "from %s about %s->%s",
 	  ip_to_str(ip_src), ip_to_str(rrep_orig), ip_to_str(rrep_dest));
+    EVLOG(EV_RREP_RECV, ip_src.s_addr, rrep_orig.s_addr, rrep_dest.s_addr, 0);
 #ifdef DEBUG_OUTPUT
     log_pkt_fields((AODV_msg *) rrep);
 #endif
@@ -282,6 +314,15 @@ void NS_CLASS rrep_process(RREP * rrep, int rreplen, struct in_addr ip_src,
 	    DEBUG(LOG_INFO, 0, "RREP include EXTENSION");
 	    /* Do something here */
 	    break;
+	case RREP_METRIC_EXT:
+	    if (ext->length == sizeof(u_int32_t)) {
+		memcpy(&metric, AODV_EXT_DATA(ext), sizeof(u_int32_t));
+		rrep_metric = rt_table_metric_add(ntohl(metric), ip_src);
+		metric_ext = ext;
+	    } else
+		alog(LOG_WARNING, 0, __FUNCTION__,
+		     "Bad metric extension length %d", ext->length);
+	    break;
 #ifdef CONFIG_GATEWAY
 	case RREP_INET_DEST_EXT:
 	    if (ext->length == sizeof(u_int32_t)) {
@@ -316,18 +357,25 @@ void NS_CLASS rrep_process(RREP * rrep, int rreplen, struct in_addr ip_src,
 	/* We didn't have an existing entry, so we insert a new one. */
 	fwd_rt = rt_table_insert(rrep_dest, ip_src, rrep_new_hcnt, rrep_seqno,
 				 rrep_lifetime, VALID, rt_flags, ifindex);
+	fwd_rt->metric = rrep_metric;
     } else if (fwd_rt->dest_seqno == 0 ||
 	       (int32_t) rrep_seqno > (int32_t) fwd_rt->dest_seqno ||
 	       (rrep_seqno == fwd_rt->dest_seqno &&
-		(fwd_rt->state == INVALID || fwd_rt->flags & RT_UNIDIR ||
-		 rrep_new_hcnt < fwd_rt->hcnt))) {
+		(fwd_rt->flags & RT_UNIDIR ||
+		 rt_table_better(fwd_rt, rrep_new_hcnt, rrep_metric)))) {
 	pre_repair_hcnt = fwd_rt->hcnt;
 	pre_repair_flags = fwd_rt->flags;
 
+	/* A real RREP confirms an overheard route */
 	fwd_rt = rt_table_update(fwd_rt, ip_src, rrep_new_hcnt, rrep_seqno,
 				 rrep_lifetime, VALID,
-				 rt_flags | fwd_rt->flags);
+				 rt_flags | (fwd_rt->flags & ~RT_PASSIVE));
+	fwd_rt->metric = rrep_metric;
     } else {
+	/* Not better than what we have, but possibly a loop free
+	   alternate (multipath). */
+	rt_table_add_path(fwd_rt, ip_src, rrep_new_hcnt, rrep_seqno, ifindex);
+
 	if (fwd_rt->hcnt > 1) {
 	    DEBUG(LOG_DEBUG, 0,
 		  "Dropping RREP, fwd_rt->hcnt=%d fwd_rt->seqno=%ld",
@@ -383,23 +431,25 @@ void NS_CLASS rrep_process(RREP * rrep, int rreplen, struct in_addr ip_src,
 	    if (fwd_rt->hcnt > pre_repair_hcnt) {
 		RERR *rerr;
 		u_int8_t rerr_flags = 0;
-		struct in_addr dest;
-
-		dest.s_addr = AODV_BROADCAST;
+		struct rerr_targets targets;
 
 		rerr_flags |= RERR_NODELETE;
 		rerr = rerr_create(rerr_flags, fwd_rt->dest_addr,
 				   fwd_rt->dest_seqno);
 
-		if (fwd_rt->nprec)
-		    aodv_socket_send((AODV_msg *) rerr, dest,
-				     RERR_CALC_SIZE(rerr), 1,
-				     &DEV_IFINDEX(fwd_rt->ifindex));
+		rerr_targets_init(&targets);
+		rerr_targets_add(&targets, fwd_rt);
+		rerr_targets_send(&targets, rerr);
 	    }
 	}
     } else {
 	/* --- Here we FORWARD the RREP on the REVERSE route --- */
 	if (rev_rt && rev_rt->state == VALID) {
+	    if (metric_ext) {
+		metric = fwd_rt->metric ? htonl(fwd_rt->metric) :
+		    RT_METRIC_UNKNOWN;
+		memcpy(AODV_EXT_DATA(metric_ext), &metric, sizeof(u_int32_t));
+	    }
 	    rrep_forward(rrep, rreplen, rev_rt, fwd_rt, --ip_ttl);
 	} else {
 	    DEBUG(LOG_DEBUG, 0, "Could not forward RREP - NO ROUTE!!!");
@@ -418,9 +468,10 @@ int rrep_add_hello_ext(RREP * rrep, int offset, u_int32_t interval)
 {
     AODV_ext *ext;
 
-    ext = (AODV_ext *) ((char *) rrep + RREP_SIZE + offset);
+    ext = (AODV_ext *) ((char *) rrep + offset);
     ext->type = RREP_HELLO_INTERVAL_EXT;
     ext->length = sizeof(interval);
+    interval = htonl(interval);
     memcpy(AODV_EXT_DATA(ext), &interval, sizeof(interval));
 
     return (offset + AODV_EXT_SIZE(ext));
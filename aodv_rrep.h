@@ -66,6 +66,8 @@ typedef struct {
 } RREP_ack;
 
 #define RREP_ACK_SIZE sizeof(RREP_ack)
+
+int rrep_add_hello_ext(RREP * rrep, int offset, u_int32_t interval);
 #endif				/* NS_NO_GLOBALS */
 
 #ifndef NS_NO_DECLARATIONS
@@ -80,12 +82,15 @@ RREP_ack *rrep_ack_create();
 AODV_ext *rrep_add_ext(RREP * rrep, int type, unsigned int offset,
 		       int len, char *data);
 void rrep_send(RREP * rrep, rt_table_t * rev_rt, rt_table_t * fwd_rt, int size);
+void rrep_send_via(RREP * rrep, rt_table_t * rev_rt, rt_table_t * fwd_rt,
+		   struct in_addr next_hop, unsigned int ifindex, int size);
 void rrep_forward(RREP * rrep, int size, rt_table_t * rev_rt,
 		  rt_table_t * fwd_rt, int ttl);
 void rrep_process(RREP * rrep, int rreplen, struct in_addr ip_src,
 		  struct in_addr ip_dst, int ip_ttl, unsigned int ifindex);
 void rrep_ack_process(RREP_ack * rrep_ack, int rreplen, struct in_addr ip_src,
 		      struct in_addr ip_dst);
+int rrep_add_metric_ext(RREP * rrep, int offset, u_int32_t metric);
 #endif				/* NS_NO_DECLARATIONS */
 
 #endif				/* AODV_RREP_H */
@@ -36,26 +36,57 @@
 #include "seek_list.h"
 #include "defs.h"
 #include "debug.h"
+#include "evlog.h"
+#include "stats.h"
 
 #include "locality.h"
-#endif
 
-/* Comment this to remove packet field output: */
-#define DEBUG_OUTPUT
+#ifdef CONFIG_BPF_RREQ
+#include "rreq_bpf.h"
+#endif
+#include "passive.h"
+#endif
 
 #ifndef NS_PORT
 static LIST(rreq_records);
-static LIST(rreq_blacklist);
+static list_t rreq_blacklist[RT_TABLESIZE];	/* Hashed like rt_tbl */
 
 static struct rreq_record *rreq_record_insert(struct in_addr orig_addr,
 					      u_int32_t rreq_id);
 static struct rreq_record *rreq_record_find(struct in_addr orig_addr,
 					    u_int32_t rreq_id);
+static void rreq_schedule_forward(struct rreq_record *rec, RREQ * rreq,
+				  int size, int ttl);
+static int rreq_fwd_threshold();
+static AODV_ext *rreq_find_ext(RREQ * rreq, int rreqlen, int type);
+static u_int32_t rreq_metric_get(RREQ * rreq, int rreqlen,
+				 struct in_addr ip_src);
+static void rreq_metric_update(RREQ * rreq, int rreqlen, u_int32_t metric);
+static void rreq_intermediate_reply(RREQ * rreq, rt_table_t * rev_rt,
+				    rt_table_t * fwd_rt);
+static int rreq_mdest_remove(RREQ * rreq, int rreqlen, AODV_ext * ext, int i);
+static int rreq_mdest_process(RREQ * rreq, int rreqlen, AODV_ext * ext,
+			      rt_table_t * rev_rt, unsigned int ifindex);
+static void rreq_mdest_forward(struct rreq_record *rec, RREQ * rreq,
+			       int rreqlen, int ip_ttl);
+
+/* Destinations waiting to be packed into one RREQ */
+static struct in_addr rreq_batch[RREQ_MDEST_MAX + 1];
+static int rreq_batch_len = 0;
+static struct timer rreq_batch_timer;
+
+struct rreq_fwd_stats rreq_fwd_stats;
+static int rreq_fwd_nb_cnt;		/* Cached neighbor count... */
+static struct timeval rreq_fwd_nb_time;	/* ...and when it was taken */
 
 struct blacklist *rreq_blacklist_find(struct in_addr dest_addr);
 
 extern int rreq_gratuitous, expanding_ring_search;
-extern int internet_gw_mode;
+extern int internet_gw_mode, multipath;
+extern int rreq_fwd_counter, rreq_fwd_adaptive, rreq_batch_window;
+extern int passive_learning, etx_metric;
+extern struct disc_stats disc_stats;
+extern struct disc_lat disc_lat;
 #endif
 
 RREQ *NS_CLASS rreq_create(u_int8_t flags, struct in_addr dest_addr,
@@ -115,10 +146,21 @@ AODV_ext *rreq_add_ext(RREQ * rreq, int type, unsigned int offset,
 
 void NS_CLASS rreq_send(struct in_addr dest_addr, u_int32_t dest_seqno,
 			int ttl, u_int8_t flags)
+{
+    rreq_send_mdest(dest_addr, dest_seqno, ttl, flags, NULL, 0);
+}
+
+/* Send a RREQ for dest_addr that also asks for the nmd destinations
+   in md. */
+void NS_CLASS rreq_send_mdest(struct in_addr dest_addr, u_int32_t dest_seqno,
+			      int ttl, u_int8_t flags, RREQ_mdest * md,
+			      int nmd)
 {
     RREQ *rreq;
+    AODV_ext *ext;
     struct in_addr dest;
-    int i;
+    u_int32_t metric = 0;
+    int i, size;
 
     dest.s_addr = AODV_BROADCAST;
 
@@ -126,18 +168,80 @@ void NS_CLASS rreq_send(struct in_addr dest_addr, u_int32_t dest_seqno,
     if (rreq_gratuitous)
 	flags |= RREQ_GRATUITOUS;
 
+    EVLOG(EV_RREQ_SEND, dest_addr.s_addr, dest_seqno, ttl, 0);
+
     /* Broadcast on all interfaces */
     for (i = 0; i < MAX_NR_INTERFACES; i++) {
 	if (!DEV_NR(i).enabled)
 	    continue;
 	rreq = rreq_create(flags, dest_addr, dest_seqno, DEV_NR(i).ipaddr);
-	aodv_socket_send((AODV_msg *) rreq, dest, RREQ_SIZE, ttl, &DEV_NR(i));
+	size = RREQ_SIZE;
+
+	if (etx_metric) {
+	    ext = rreq_add_ext(rreq, RREQ_METRIC_EXT, size,
+			       sizeof(u_int32_t), (char *) &metric);
+	    size += AODV_EXT_SIZE(ext);
+	}
+	if (nmd > 0) {
+	    ext = rreq_add_ext(rreq, RREQ_MDEST_EXT, size,
+			       nmd * RREQ_MDEST_SIZE, (char *) md);
+	    size += AODV_EXT_SIZE(ext);
+	}
+	aodv_socket_send((AODV_msg *) rreq, dest, size, ttl, &DEV_NR(i));
+    }
+}
+
+/* Send the RREQs of all batched discoveries. Discoveries with the
+   same TTL and flags go in one RREQ, the first one as the primary
+   destination and the others in a RREQ_MDEST_EXT. */
+void NS_CLASS rreq_batch_timeout(void *arg)
+{
+    RREQ_mdest md[RREQ_MDEST_MAX];
+    seek_list_t *e, *o;
+    int i, n;
+
+    while (rreq_batch_len) {
+	e = seek_list_find(rreq_batch[0]);
+
+	rreq_batch_len--;
+	memmove(&rreq_batch[0], &rreq_batch[1],
+		rreq_batch_len * sizeof(struct in_addr));
+
+	if (!e)
+	    continue;
+
+	gettimeofday(&e->rreq_time, NULL);
+	n = 0;
+	i = 0;
+
+	while (i < rreq_batch_len) {
+	    o = seek_list_find(rreq_batch[i]);
+
+	    if (o && (o->ttl != e->ttl || o->flags != e->flags)) {
+		i++;
+		continue;
+	    }
+	    if (o) {
+		md[n].dest_addr = o->dest_addr.s_addr;
+		md[n].dest_seqno = htonl(o->dest_seqno);
+		o->rreq_time = e->rreq_time;
+		n++;
+	    }
+	    rreq_batch_len--;
+	    memmove(&rreq_batch[i], &rreq_batch[i + 1],
+		    (rreq_batch_len - i) * sizeof(struct in_addr));
+	}
+	DEBUG(LOG_DEBUG, 0, "Seeking %s and %d more in one RREQ",
+	      ip_to_str(e->dest_addr), n);
+
+	rreq_send_mdest(e->dest_addr, e->dest_seqno, e->ttl, e->flags, md, n);
     }
 }
 
 void NS_CLASS rreq_forward(RREQ * rreq, int size, int ttl)
 {
     struct in_addr dest, orig;
+    rt_table_t *rev_rt;
     int i;
 
     dest.s_addr = AODV_BROADCAST;
@@ -146,6 +250,7 @@ void NS_CLASS rreq_forward(RREQ * rreq, int size, int ttl)
     /* FORWARD the RREQ if the TTL allows it. */
     DEBUG(LOG_INFO, 0, "forwarding RREQ src=%s, rreq_id=%lu",
 	  ip_to_str(orig), ntohl(rreq->rreq_id));
+    EVLOG(EV_RREQ_FWD, orig.s_addr, ntohl(rreq->rreq_id), 0, 0);
 
     /* Queue the received message in the send buffer */
     rreq = (RREQ *) aodv_socket_queue_msg((AODV_msg *) rreq, size);
@@ -153,6 +258,14 @@ void NS_CLASS rreq_forward(RREQ * rreq, int size, int ttl)
     rreq->hcnt++;		/* Increase hopcount to account for
 				 * intermediate route */
 
+    /* With multipath, the reverse route's advertised hop count is
+       what duplicates of this RREQ were checked against. */
+    rev_rt = rt_table_find(orig);
+
+    if (multipath && rev_rt && rev_rt->state == VALID &&
+	rev_rt->dest_seqno == ntohl(rreq->orig_seqno))
+	rreq->hcnt = rt_table_adv_hcnt(rev_rt);
+
     /* Send out on all interfaces */
     for (i = 0; i < MAX_NR_INTERFACES; i++) {
 	if (!DEV_NR(i).enabled)
@@ -170,10 +283,12 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
     RREP *rrep = NULL;
     int rrep_size = RREP_SIZE;
     rt_table_t *rev_rt, *fwd_rt = NULL;
+    struct rreq_record *rec;
     u_int32_t rreq_orig_seqno, rreq_dest_seqno;
-    u_int32_t rreq_id, rreq_new_hcnt, life;
+    u_int32_t rreq_id, rreq_new_hcnt, life, rreq_metric;
     unsigned int extlen = 0;
     struct in_addr rreq_dest, rreq_orig;
+    AODV_ext *mdest_ext = NULL;
 
     rreq_dest.s_addr = rreq->dest_addr;
     rreq_orig.s_addr = rreq->orig_addr;
@@ -192,6 +307,8 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
     DEBUG(LOG_DEBUG, 0, "ip_src=%s rreq_orig=%s rreq_dest=%s ttl=%d",
 	  ip_to_str(ip_src), ip_to_str(rreq_orig), ip_to_str(rreq_dest), 
 	  ip_ttl);
+    EVLOG(EV_RREQ_RECV, ip_src.s_addr, rreq_orig.s_addr, rreq_dest.s_addr,
+	  ip_ttl);
 
     if (rreqlen < (int) RREQ_SIZE) {
 	alog(LOG_WARNING, 0,
@@ -204,16 +321,65 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
        it is, then ignore the RREQ. */
     if (rreq_blacklist_find(ip_src)) {
 	DEBUG(LOG_DEBUG, 0, "prev hop of RREQ blacklisted, ignoring!");
+	STATS_INC(STATS_RREQ, dropped);
 	return;
     }
 
-    /* Ignore already processed RREQs. */
-    if (rreq_record_find(rreq_orig, rreq_id))
+    rreq_metric = rreq_metric_get(rreq, rreqlen, ip_src);
+
+    /* Calculate the extended minimal life time. */
+    life = PATH_DISCOVERY_TIME - 2 * rreq_new_hcnt * NODE_TRAVERSAL_TIME;
+
+    /* Ignore already processed RREQs. With multipath, a copy that
+       arrived through another neighbor is first recorded as an
+       alternate reverse path to the originator. The destination also
+       replies along it, so that nodes on the way learn alternate
+       forward paths. */
+    if ((rec = rreq_record_find(rreq_orig, rreq_id))) {
+	STATS_INC(STATS_RREQ, duplicate);
+	/* Count copies heard while our own rebroadcast is pending, and
+	   cancel it once enough neighbors have already covered the
+	   area. */
+	if (rec->fwd_msg && ++rec->dup_cnt >= rreq_fwd_threshold()) {
+	    timer_remove(&rec->fwd_timer);
+	    free(rec->fwd_msg);
+	    rec->fwd_msg = NULL;
+	    rreq_fwd_stats.suppressed++;
+#ifdef CONFIG_BPF_RREQ
+	    rreq_bpf_insert(rec->orig_addr, rec->rreq_id);
+#endif
+	    DEBUG(LOG_DEBUG, 0, "Suppressed RREQ rebroadcast, %d copies",
+		  rec->dup_cnt);
+	}
+	/* A later copy may have come over a better path. It is not
+	   forwarded, but the reverse route is moved to it. */
+	rev_rt = rt_table_find(rreq_orig);
+
+	if (rreq_metric && rev_rt && rev_rt->state == VALID &&
+	    rev_rt->dest_seqno == rreq_orig_seqno &&
+	    rt_table_better(rev_rt, rreq_new_hcnt, rreq_metric)) {
+	    rt_table_update(rev_rt, ip_src, rreq_new_hcnt, rreq_orig_seqno,
+			    life, VALID, rev_rt->flags);
+	    rev_rt->metric = rreq_metric;
+	}
+	if (multipath && rev_rt &&
+	    rt_table_add_path(rev_rt, ip_src, rreq_new_hcnt, rreq_orig_seqno,
+			      ifindex) &&
+	    rreq_dest.s_addr == DEV_IFINDEX(ifindex).ipaddr.s_addr) {
+
+	    rrep = rrep_create(0, 0, 0, DEV_IFINDEX(ifindex).ipaddr,
+			       this_host.seqno, rreq_orig, MY_ROUTE_TIMEOUT);
+	    rrep_send_via(rrep, rev_rt, NULL, ip_src, ifindex,
+			  rrep_add_metric_ext(rrep, RREP_SIZE, 0));
+	}
 	return;
+    }
 
     /* Now buffer this RREQ so that we don't process a similar RREQ we
        get within PATH_DISCOVERY_TIME. */
-    rreq_record_insert(rreq_orig, rreq_id);
+    rec = rreq_record_insert(rreq_orig, rreq_id);
+
+    rreq_metric_update(rreq, rreqlen, rreq_metric);
 
     /* Determine whether there are any RREQ extensions */
     ext = (AODV_ext *) ((char *) rreq + RREQ_SIZE);
@@ -224,6 +390,19 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
 	    DEBUG(LOG_INFO, 0, "RREQ include EXTENSION");
 	    /* Do something here */
 	    break;
+	case RREQ_MDEST_EXT:
+	    if (ext->length % RREQ_MDEST_SIZE == 0)
+		mdest_ext = ext;
+	    else
+		alog(LOG_WARNING, 0, __FUNCTION__,
+		     "Bad multiple destination extension length %d",
+		     ext->length);
+	    break;
+	case RREQ_METRIC_EXT:
+	    if (ext->length != sizeof(u_int32_t))
+		alog(LOG_WARNING, 0, __FUNCTION__,
+		     "Bad metric extension length %d", ext->length);
+	    break;
 	default:
 	    alog(LOG_WARNING, 0, __FUNCTION__, "Unknown extension type %d",
 		 ext->type);
@@ -240,23 +419,22 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
        source of the RREQ. */
     rev_rt = rt_table_find(rreq_orig);
 
-    /* Calculate the extended minimal life time. */
-    life = PATH_DISCOVERY_TIME - 2 * rreq_new_hcnt * NODE_TRAVERSAL_TIME;
-
     if (rev_rt == NULL) {
 	DEBUG(LOG_DEBUG, 0, "Creating REVERSE route entry, RREQ orig: %s",
 	      ip_to_str(rreq_orig));
 
 	rev_rt = rt_table_insert(rreq_orig, ip_src, rreq_new_hcnt,
 				 rreq_orig_seqno, life, VALID, 0, ifindex);
+	rev_rt->metric = rreq_metric;
     } else {
 	if (rev_rt->dest_seqno == 0 ||
 	    (int32_t) rreq_orig_seqno > (int32_t) rev_rt->dest_seqno ||
 	    (rreq_orig_seqno == rev_rt->dest_seqno &&
-	     (rev_rt->state == INVALID || rreq_new_hcnt < rev_rt->hcnt))) {
+	     rt_table_better(rev_rt, rreq_new_hcnt, rreq_metric))) {
 	    rev_rt = rt_table_update(rev_rt, ip_src, rreq_new_hcnt,
 				     rreq_orig_seqno, life, VALID,
 				     rev_rt->flags);
+	    rev_rt->metric = rreq_metric;
 	}
 #ifdef DISABLED
 	/* This is a out of draft modification of AODV-UU to prevent
@@ -273,6 +451,11 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
     }
     /**** END updating/creating REVERSE route ****/
 
+    /* Answer those of the extra destinations we can, and strip them
+       from the RREQ before it is forwarded. */
+    if (mdest_ext)
+	rreqlen = rreq_mdest_process(rreq, rreqlen, mdest_ext, rev_rt, ifindex);
+
 #ifdef CONFIG_GATEWAY
     /* This is a gateway */
     if (internet_gw_mode) {
@@ -299,6 +482,7 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
 
 	    rrep_send(rrep, rev_rt, NULL, rrep_size);
 
+	    rreq_mdest_forward(rec, rreq, rreqlen, ip_ttl);
 	    return;
 
 	case HOST_UNKNOWN:
@@ -324,8 +508,9 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
 			   this_host.seqno, rev_rt->dest_addr,
 			   MY_ROUTE_TIMEOUT);
 
-	rrep_send(rrep, rev_rt, NULL, RREP_SIZE);
+	rrep_send(rrep, rev_rt, NULL, rrep_add_metric_ext(rrep, RREP_SIZE, 0));
 
+	rreq_mdest_forward(rec, rreq, rreqlen, ip_ttl);
     } else {
 	/* We are an INTERMEDIATE node. - check if we have an active
 	 * route entry */
@@ -333,15 +518,15 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
 	fwd_rt = rt_table_find(rreq_dest);
 
 	if (fwd_rt && fwd_rt->state == VALID && !rreq->d) {
-	    struct timeval now;
-	    u_int32_t lifetime;
-
 	    /* GENERATE RREP, i.e we have an ACTIVE route entry that is fresh
 	       enough (our destination sequence number for that route is
 	       larger than the one in the RREQ). */
 
-	    gettimeofday(&now, NULL);
 #ifdef CONFIG_GATEWAY_DISABLED
+	    struct timeval now;
+	    u_int32_t lifetime;
+
+	    gettimeofday(&now, NULL);
 	    if (fwd_rt->flags & RT_INET_DEST) {
 		rt_table_t *gw_rt;
 		/* This node knows that this is a rreq for an Internet
@@ -356,7 +541,8 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
 
 		lifetime = timeval_diff(&gw_rt->rt_timer.timeout, &now);
 
-		rrep = rrep_create(0, 0, gw_rt->hcnt, gw_rt->dest_addr,
+		rrep = rrep_create(0, 0, rt_table_adv_hcnt(gw_rt),
+				   gw_rt->dest_addr,
 				   gw_rt->dest_seqno, rev_rt->dest_addr,
 				   lifetime);
 
@@ -374,29 +560,17 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
 	    }
 #endif				/* CONFIG_GATEWAY_DISABLED */
 
-	    /* Respond only if the sequence number is fresh enough... */
+	    /* Respond only if the sequence number is fresh enough... An
+	       overheard route must be strictly fresher. */
 	    if (fwd_rt->dest_seqno != 0 &&
-		(int32_t) fwd_rt->dest_seqno >= (int32_t) rreq_dest_seqno) {
-		lifetime = timeval_diff(&fwd_rt->rt_timer.timeout, &now);
-		rrep = rrep_create(0, 0, fwd_rt->hcnt, fwd_rt->dest_addr,
-				   fwd_rt->dest_seqno, rev_rt->dest_addr,
-				   lifetime);
-		rrep_send(rrep, rev_rt, fwd_rt, rrep_size);
-	    } else {
+		(int32_t) fwd_rt->dest_seqno >= (int32_t) rreq_dest_seqno &&
+		(!(fwd_rt->flags & RT_PASSIVE) ||
+		 fwd_rt->dest_seqno != rreq_dest_seqno))
+		rreq_intermediate_reply(rreq, rev_rt, fwd_rt);
+	    else
 		goto forward;
-	    }
-	    /* If the GRATUITOUS flag is set, we must also unicast a
-	       gratuitous RREP to the destination. */
-	    if (rreq->g) {
-		rrep = rrep_create(0, 0, rev_rt->hcnt, rev_rt->dest_addr,
-				   rev_rt->dest_seqno, fwd_rt->dest_addr,
-				   lifetime);
 
-		rrep_send(rrep, fwd_rt, rev_rt, RREP_SIZE);
-
-		DEBUG(LOG_INFO, 0, "Sending G-RREP to %s with rte to %s",
-		      ip_to_str(rreq_dest), ip_to_str(rreq_orig));
-	    }
+	    rreq_mdest_forward(rec, rreq, rreqlen, ip_ttl);
 	    return;
 	}
       forward:
@@ -407,7 +581,7 @@ void NS_CLASS rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
 		(int32_t) fwd_rt->dest_seqno > (int32_t) rreq_dest_seqno)
 		rreq->dest_seqno = htonl(fwd_rt->dest_seqno);
 
-	    rreq_forward(rreq, rreqlen, --ip_ttl);
+	    rreq_schedule_forward(rec, rreq, rreqlen, --ip_ttl);
 
 	} else {
 	    DEBUG(LOG_DEBUG, 0, "RREQ not forwarded - ttl=0");
@@ -424,13 +598,17 @@ void NS_CLASS rreq_route_discovery(struct in_addr dest_addr, u_int8_t flags,
     rt_table_t *rt;
     seek_list_t *seek_entry;
     u_int32_t dest_seqno;
-    int ttl;
+    int ttl, hist_ttl = 0;
 #define TTL_VALUE ttl
 
     gettimeofday(&now, NULL);
 
-    if (seek_list_find(dest_addr))
+    /* Already seeking. A preemptive discovery must now go on until
+       it finds a route. */
+    if ((seek_entry = seek_list_find(dest_addr))) {
+	seek_list_preempt_clear(seek_entry);
 	return;
+    }
 
     /* If we already have a route entry, we use information from it. */
     rt = rt_table_find(dest_addr);
@@ -460,22 +638,284 @@ void NS_CLASS rreq_route_discovery(struct in_addr dest_addr, u_int8_t flags,
 	    rt_table_update_timeout(rt, 2 * NET_TRAVERSAL_TIME);
     }
 
-    rreq_send(dest_addr, dest_seqno, ttl, flags);
+#ifndef NS_PORT
+    /* A route we overheard recently may save the discovery */
+    if (passive_learning && passive_route_install(dest_addr)) {
+	disc_stats.cached++;
+	disc_lat.outcome[DISC_CACHED][0]++;
+	return;
+    }
+#endif
+
+    /* If we found the destination before, start the ring just beyond
+       where it was, even if the route has since been deleted. */
+    if (expanding_ring_search && (hist_ttl = seek_list_hist_ttl(dest_addr))) {
+	ttl = hist_ttl;
+	disc_stats.predicted++;
+    }
+#ifndef NS_PORT
+    else if (expanding_ring_search && passive_learning &&
+	     (hist_ttl = passive_ttl(dest_addr)))
+	ttl = hist_ttl;
+#endif
 
     /* Remember that we are seeking this destination */
     seek_entry = seek_list_insert(dest_addr, dest_seqno, ttl, flags, ipd);
 
-    /* Set a timer for this RREQ */
-    if (expanding_ring_search)
-	timer_set_timeout(&seek_entry->seek_timer, RING_TRAVERSAL_TIME);
+    /* Discoveries started close in time are sent together in one
+       RREQ when the batch window is open. */
+    if (rreq_batch_window) {
+	int i;
+
+	if (rreq_batch_len == 0) {
+	    timer_init(&rreq_batch_timer, &NS_CLASS rreq_batch_timeout, NULL);
+	    timer_set_timeout(&rreq_batch_timer, rreq_batch_window);
+	}
+	/* A destination found and sought again within the window is
+	   already queued */
+	for (i = 0; i < rreq_batch_len; i++)
+	    if (rreq_batch[i].s_addr == dest_addr.s_addr)
+		break;
+
+	if (i == rreq_batch_len)
+	    rreq_batch[rreq_batch_len++] = dest_addr;
+
+	if (rreq_batch_len == RREQ_MDEST_MAX + 1) {
+	    timer_remove(&rreq_batch_timer);
+	    rreq_batch_timeout(NULL);
+	}
+    } else
+	rreq_send(dest_addr, dest_seqno, ttl, flags);
+
+    /* Set a timer for this RREQ. A predicted TTL should be right, so
+       the ring timeout uses a smaller buffer. */
+    if (hist_ttl)
+	timer_set_timeout(&seek_entry->seek_timer,
+			  2 * NODE_TRAVERSAL_TIME * (ttl + 1) +
+			  rreq_batch_window);
+    else if (expanding_ring_search)
+	timer_set_timeout(&seek_entry->seek_timer,
+			  RING_TRAVERSAL_TIME + rreq_batch_window);
     else
-	timer_set_timeout(&seek_entry->seek_timer, NET_TRAVERSAL_TIME);
+	timer_set_timeout(&seek_entry->seek_timer,
+			  NET_TRAVERSAL_TIME + rreq_batch_window);
 
     DEBUG(LOG_DEBUG, 0, "Seeking %s ttl=%d", ip_to_str(dest_addr), ttl);
 
     return;
 }
 
+NS_STATIC AODV_ext *NS_CLASS rreq_find_ext(RREQ * rreq, int rreqlen,
+					   int type)
+{
+    AODV_ext *ext = (AODV_ext *) ((char *) rreq + RREQ_SIZE);
+    int extlen = 0;
+
+    while ((rreqlen - extlen) > (int) RREQ_SIZE) {
+	if (ext->type == type)
+	    return ext;
+	extlen += AODV_EXT_SIZE(ext);
+	ext = AODV_EXT_NEXT(ext);
+    }
+    return NULL;
+}
+
+/* Work out the ETX of the path a RREQ took to us from its metric
+   extension. Returns 0 if the RREQ has no metric or the link to
+   ip_src has no estimate. */
+NS_STATIC u_int32_t NS_CLASS rreq_metric_get(RREQ * rreq, int rreqlen,
+					     struct in_addr ip_src)
+{
+    AODV_ext *ext = rreq_find_ext(rreq, rreqlen, RREQ_METRIC_EXT);
+    u_int32_t metric;
+
+    if (!ext || ext->length != sizeof(u_int32_t))
+	return 0;
+
+    memcpy(&metric, AODV_EXT_DATA(ext), sizeof(u_int32_t));
+
+    return rt_table_metric_add(ntohl(metric), ip_src);
+}
+
+/* Write the path metric back into the RREQ for forwarding */
+NS_STATIC void NS_CLASS rreq_metric_update(RREQ * rreq, int rreqlen,
+					   u_int32_t metric)
+{
+    AODV_ext *ext = rreq_find_ext(rreq, rreqlen, RREQ_METRIC_EXT);
+
+    if (!ext || ext->length != sizeof(u_int32_t))
+	return;
+
+    metric = metric ? htonl(metric) : RT_METRIC_UNKNOWN;
+    memcpy(AODV_EXT_DATA(ext), &metric, sizeof(u_int32_t));
+}
+
+/* Reply to a RREQ on behalf of fwd_rt's destination. If the
+   GRATUITOUS flag is set, we must also unicast a gratuitous RREP to
+   the destination. */
+NS_STATIC void NS_CLASS rreq_intermediate_reply(RREQ * rreq,
+						rt_table_t * rev_rt,
+						rt_table_t * fwd_rt)
+{
+    RREP *rrep;
+    struct timeval now;
+    u_int32_t lifetime;
+
+    gettimeofday(&now, NULL);
+    lifetime = timeval_diff(&fwd_rt->rt_timer.timeout, &now);
+
+    rrep = rrep_create(0, 0, rt_table_adv_hcnt(fwd_rt), fwd_rt->dest_addr,
+		       fwd_rt->dest_seqno, rev_rt->dest_addr, lifetime);
+    rrep_send(rrep, rev_rt, fwd_rt, fwd_rt->metric ?
+	      rrep_add_metric_ext(rrep, RREP_SIZE, fwd_rt->metric) :
+	      RREP_SIZE);
+
+    if (rreq->g) {
+	rrep = rrep_create(0, 0, rt_table_adv_hcnt(rev_rt),
+			   rev_rt->dest_addr, rev_rt->dest_seqno,
+			   fwd_rt->dest_addr, lifetime);
+
+	rrep_send(rrep, fwd_rt, rev_rt, RREP_SIZE);
+
+	DEBUG(LOG_INFO, 0, "Sending G-RREP to %s with rte to %s",
+	      ip_to_str(fwd_rt->dest_addr), ip_to_str(rev_rt->dest_addr));
+    }
+}
+
+/* Remove extra destination i from a RREQ_MDEST_EXT, and the whole
+   extension if it was the last one. Returns the new RREQ length. */
+NS_STATIC int NS_CLASS rreq_mdest_remove(RREQ * rreq, int rreqlen,
+					 AODV_ext * ext, int i)
+{
+    char *end = (char *) rreq + rreqlen;
+    char *md = AODV_EXT_DATA(ext) + i * RREQ_MDEST_SIZE;
+
+    if (ext->length == RREQ_MDEST_SIZE) {
+	memmove(ext, AODV_EXT_NEXT(ext), end - (char *) AODV_EXT_NEXT(ext));
+	return rreqlen - AODV_EXT_HDR_SIZE - RREQ_MDEST_SIZE;
+    }
+    memmove(md, md + RREQ_MDEST_SIZE, end - (md + RREQ_MDEST_SIZE));
+    ext->length -= RREQ_MDEST_SIZE;
+
+    return rreqlen - RREQ_MDEST_SIZE;
+}
+
+/* Reply for the extra destinations of a RREQ that we are, or have a
+   fresh enough route to, using the same rules as for the primary
+   destination. Those are removed from the RREQ, so that nodes further
+   away only look for what is still unresolved. Returns the new RREQ
+   length. */
+NS_STATIC int NS_CLASS rreq_mdest_process(RREQ * rreq, int rreqlen,
+					  AODV_ext * ext, rt_table_t * rev_rt,
+					  unsigned int ifindex)
+{
+    RREQ_mdest *md;
+    RREP *rrep;
+    rt_table_t *fwd_rt;
+    struct in_addr dest;
+    u_int32_t dest_seqno;
+    int i = 0;
+
+    while (i < (int) (ext->length / RREQ_MDEST_SIZE)) {
+	md = (RREQ_mdest *) (AODV_EXT_DATA(ext) + i * RREQ_MDEST_SIZE);
+	dest.s_addr = md->dest_addr;
+	dest_seqno = ntohl(md->dest_seqno);
+	fwd_rt = NULL;
+
+	if (dest.s_addr == DEV_IFINDEX(ifindex).ipaddr.s_addr) {
+	    if (dest_seqno != 0) {
+		if ((int32_t) this_host.seqno < (int32_t) dest_seqno)
+		    this_host.seqno = dest_seqno;
+		else if (this_host.seqno == dest_seqno)
+		    seqno_incr(this_host.seqno);
+	    }
+	    rrep = rrep_create(0, 0, 0, DEV_IFINDEX(rev_rt->ifindex).ipaddr,
+			       this_host.seqno, rev_rt->dest_addr,
+			       MY_ROUTE_TIMEOUT);
+	    rrep_send(rrep, rev_rt, NULL,
+		      rrep_add_metric_ext(rrep, RREP_SIZE, 0));
+
+	} else if ((fwd_rt = rt_table_find(dest)) &&
+		   fwd_rt->state == VALID && !rreq->d &&
+		   !(fwd_rt->flags & RT_INET_DEST) &&
+		   fwd_rt->dest_seqno != 0 &&
+		   (int32_t) fwd_rt->dest_seqno >= (int32_t) dest_seqno &&
+		   (!(fwd_rt->flags & RT_PASSIVE) ||
+		    fwd_rt->dest_seqno != dest_seqno)) {
+
+	    rreq_intermediate_reply(rreq, rev_rt, fwd_rt);
+	} else {
+	    /* Update the sequence number in case the maintained one is
+	     * larger */
+	    if (fwd_rt && !(fwd_rt->flags & RT_INET_DEST) &&
+		(int32_t) fwd_rt->dest_seqno > (int32_t) dest_seqno)
+		md->dest_seqno = htonl(fwd_rt->dest_seqno);
+	    i++;
+	    continue;
+	}
+	DEBUG(LOG_DEBUG, 0, "Answered extra RREQ destination %s",
+	      ip_to_str(dest));
+
+	if (ext->length == RREQ_MDEST_SIZE)
+	    return rreq_mdest_remove(rreq, rreqlen, ext, i);
+
+	rreqlen = rreq_mdest_remove(rreq, rreqlen, ext, i);
+    }
+    return rreqlen;
+}
+
+/* The primary destination of a RREQ was answered here. If there are
+   unresolved extra destinations left, the first of them becomes the
+   primary one and the RREQ is forwarded for those. */
+NS_STATIC void NS_CLASS rreq_mdest_forward(struct rreq_record *rec,
+					   RREQ * rreq, int rreqlen,
+					   int ip_ttl)
+{
+    AODV_ext *ext;
+    RREQ_mdest *md;
+
+    if (ip_ttl <= 1 ||
+	!(ext = rreq_find_ext(rreq, rreqlen, RREQ_MDEST_EXT)))
+	return;
+
+    md = (RREQ_mdest *) AODV_EXT_DATA(ext);
+
+    rreq->dest_addr = md->dest_addr;
+    rreq->dest_seqno = md->dest_seqno;
+
+    rreqlen = rreq_mdest_remove(rreq, rreqlen, ext, 0);
+
+    rreq_schedule_forward(rec, rreq, rreqlen, --ip_ttl);
+}
+
+/* Look for a replacement of a route that still works, but whose next
+   hop link is degrading. A single RREQ asks for a fresher sequence
+   number than ours, so that any answer replaces the route. If none
+   comes, the route is simply kept. */
+void NS_CLASS rreq_preempt(rt_table_t * rt)
+{
+    seek_list_t *seek_entry;
+    u_int32_t dest_seqno = rt->dest_seqno;
+    int ttl = rt->hcnt + LOCAL_ADD_TTL;
+
+    if (dest_seqno == 0 || seek_list_find(rt->dest_addr))
+	return;
+
+    seqno_incr(dest_seqno);
+
+    DEBUG(LOG_DEBUG, 0, "Preemptive discovery for %s ttl=%d",
+	  ip_to_str(rt->dest_addr), ttl);
+
+    rreq_send(rt->dest_addr, dest_seqno, ttl, 0);
+
+    seek_entry = seek_list_insert(rt->dest_addr, dest_seqno, ttl, 0, NULL);
+    seek_entry->reqs = RREQ_RETRIES;	/* No retries */
+    seek_entry->start_time.tv_sec = 0;	/* Nobody waits for it */
+    seek_entry->preempt = 1;
+
+    timer_set_timeout(&seek_entry->seek_timer, 2 * ttl * NODE_TRAVERSAL_TIME);
+}
+
 /* Local repair is very similar to route discovery... */
 void NS_CLASS rreq_local_repair(rt_table_t * rt, struct in_addr src_addr,
 				struct ip_data *ipd)
@@ -559,11 +999,22 @@ NS_STATIC struct rreq_record *NS_CLASS rreq_record_insert(struct in_addr
     }
     rec->orig_addr = orig_addr;
     rec->rreq_id = rreq_id;
+    rec->dup_cnt = 0;
+    rec->fwd_msg = NULL;
 
     timer_init(&rec->rec_timer, &NS_CLASS rreq_record_timeout, rec);
+    timer_init(&rec->fwd_timer, &NS_CLASS rreq_fwd_timeout, rec);
 
     list_add(&rreq_records, &rec->l);
 
+#ifdef CONFIG_BPF_RREQ
+    /* Let the kernel drop further copies of this RREQ for us. With
+       counter based forwarding we need to hear the copies, so the
+       insert is done when the rebroadcast has been decided on. */
+    if (!rreq_fwd_counter)
+	rreq_bpf_insert(orig_addr, rreq_id);
+#endif
+
     DEBUG(LOG_INFO, 0, "Buffering RREQ %s rreq_id=%lu time=%u",
 	  ip_to_str(orig_addr), rreq_id, PATH_DISCOVERY_TIME);
 
@@ -590,14 +1041,124 @@ void NS_CLASS rreq_record_timeout(void *arg)
 {
     struct rreq_record *rec = (struct rreq_record *) arg;
 
+#ifdef CONFIG_BPF_RREQ
+    rreq_bpf_remove(rec->orig_addr, rec->rreq_id);
+#endif
+    timer_remove(&rec->fwd_timer);
+    if (rec->fwd_msg)
+	free(rec->fwd_msg);
+
     list_detach(&rec->l);
     free(rec);
 }
 
+/* Counter based rebroadcast suppression (rreq_fwd_counter > 0):
+   instead of rebroadcasting a new RREQ right away, wait a random time
+   of up to RREQ_FWD_DELAY msecs. Every copy heard meanwhile means a
+   neighbor already covered part of our area, and once the threshold
+   is reached the rebroadcast is cancelled. */
+NS_STATIC void NS_CLASS rreq_schedule_forward(struct rreq_record *rec,
+					      RREQ * rreq, int size, int ttl)
+{
+    long delay;
+
+    if (!rreq_fwd_counter || !rec) {
+	rreq_forward(rreq, size, ttl);
+	return;
+    }
+
+    if (rec->fwd_msg)
+	return;
+
+    if ((rec->fwd_msg = (char *) malloc(size)) == NULL) {
+	fprintf(stderr, "Malloc failed!!!\n");
+	exit(-1);
+    }
+    memcpy(rec->fwd_msg, rreq, size);
+    rec->fwd_len = size;
+    rec->fwd_ttl = ttl;
+    rec->dup_cnt = 0;
+
+#ifdef NS_PORT
+    delay = Random::integer(RREQ_FWD_DELAY + 1);
+#else
+    delay = random() % (RREQ_FWD_DELAY + 1);
+#endif
+    rreq_fwd_stats.scheduled++;
+
+    timer_set_timeout(&rec->fwd_timer, delay);
+}
+
+void NS_CLASS rreq_fwd_timeout(void *arg)
+{
+    struct rreq_record *rec = (struct rreq_record *) arg;
+
+    if (!rec->fwd_msg)
+	return;
+
+    rreq_forward((RREQ *) rec->fwd_msg, rec->fwd_len, rec->fwd_ttl);
+    rreq_fwd_stats.sent++;
+
+    free(rec->fwd_msg);
+    rec->fwd_msg = NULL;
+
+#ifdef CONFIG_BPF_RREQ
+    rreq_bpf_insert(rec->orig_addr, rec->rreq_id);
+#endif
+}
+
+/* Number of copies that suppresses a rebroadcast. With
+   rreq_fwd_adaptive the threshold is raised where there are few
+   neighbors (at most RREQ_FWD_SPARSE), so that sparse parts of the
+   network always rebroadcast. The neighbor count is refreshed once
+   per HELLO_INTERVAL. */
+NS_STATIC int NS_CLASS rreq_fwd_threshold()
+{
+    struct timeval now;
+    int i;
+
+    if (!rreq_fwd_adaptive)
+	return rreq_fwd_counter;
+
+    gettimeofday(&now, NULL);
+
+    if (timeval_diff(&now, &rreq_fwd_nb_time) > HELLO_INTERVAL ||
+	rreq_fwd_nb_time.tv_sec == 0) {
+	rreq_fwd_nb_cnt = 0;
+
+	for (i = 0; i < RT_TABLESIZE; i++) {
+	    list_t *pos;
+	    list_foreach(pos, &rt_tbl.tbl[i]) {
+		rt_table_t *rt = (rt_table_t *) pos;
+
+		if (rt->hcnt == 1 && rt->state == VALID &&
+		    !(rt->flags & RT_UNIDIR))
+		    rreq_fwd_nb_cnt++;
+	    }
+	}
+	rreq_fwd_nb_time = now;
+    }
+
+    if (rreq_fwd_nb_cnt <= RREQ_FWD_SPARSE)
+	return max(rreq_fwd_counter, rreq_fwd_nb_cnt + 1);
+
+    return rreq_fwd_counter;
+}
+
+void NS_CLASS rreq_blacklist_init()
+{
+    int i;
+
+    for (i = 0; i < RT_TABLESIZE; i++)
+	INIT_LIST_HEAD(&rreq_blacklist[i]);
+}
+
 struct blacklist *NS_CLASS rreq_blacklist_insert(struct in_addr dest_addr)
 {
 
     struct blacklist *bl;
+    hash_value hash;
+    unsigned int index;
 
     /* First check if this rreq packet is already buffered */
     bl = rreq_blacklist_find(dest_addr);
@@ -614,7 +1175,8 @@ struct blacklist *NS_CLASS rreq_blacklist_insert(struct in_addr dest_addr)
 
     timer_init(&bl->bl_timer, &NS_CLASS rreq_blacklist_timeout, bl);
 
-    list_add(&rreq_blacklist, &bl->l);
+    index = hashing(&dest_addr, &hash);
+    list_add(&rreq_blacklist[index], &bl->l);
 
     timer_set_timeout(&bl->bl_timer, BLACKLIST_TIMEOUT);
     return bl;
@@ -623,8 +1185,12 @@ struct blacklist *NS_CLASS rreq_blacklist_insert(struct in_addr dest_addr)
 struct blacklist *NS_CLASS rreq_blacklist_find(struct in_addr dest_addr)
 {
     list_t *pos;
+    hash_value hash;
+    unsigned int index;
+
+    index = hashing(&dest_addr, &hash);
 
-    list_foreach(pos, &rreq_blacklist) {
+    list_foreach(pos, &rreq_blacklist[index]) {
 	struct blacklist *bl = (struct blacklist *) pos;
 
 	if (bl->dest_addr.s_addr == dest_addr.s_addr)
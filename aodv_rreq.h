@@ -64,12 +64,35 @@ typedef struct {
 
 #define RREQ_SIZE sizeof(RREQ)
 
+/* Extra destination carried in a RREQ_MDEST_EXT extension. Several
+   discoveries started at the same time share one flood this way.
+   Nodes that do not know the extension only see the primary
+   destination. */
+typedef struct {
+    u_int32_t dest_addr;
+    u_int32_t dest_seqno;
+} RREQ_mdest;
+
+#define RREQ_MDEST_SIZE sizeof(RREQ_mdest)
+
 /* A data structure to buffer information about received RREQ's */
 struct rreq_record {
     list_t l;
     struct in_addr orig_addr;	/* Source of the RREQ */
     u_int32_t rreq_id;		/* RREQ's broadcast ID */
     struct timer rec_timer;
+    struct timer fwd_timer;	/* Delayed rebroadcast (counter based) */
+    int dup_cnt;		/* Copies heard while the rebroadcast waits */
+    int fwd_len;
+    int fwd_ttl;
+    char *fwd_msg;		/* RREQ to rebroadcast, NULL if none */
+};
+
+/* Counters for counter based RREQ rebroadcast suppression */
+struct rreq_fwd_stats {
+    u_int32_t scheduled;	/* Rebroadcasts that were delayed */
+    u_int32_t sent;
+    u_int32_t suppressed;	/* Cancelled since enough copies were heard */
 };
 
 struct blacklist {
@@ -84,14 +107,20 @@ RREQ *rreq_create(u_int8_t flags, struct in_addr dest_addr,
 		  u_int32_t dest_seqno, struct in_addr orig_addr);
 void rreq_send(struct in_addr dest_addr, u_int32_t dest_seqno, int ttl,
 	       u_int8_t flags);
+void rreq_send_mdest(struct in_addr dest_addr, u_int32_t dest_seqno, int ttl,
+		     u_int8_t flags, RREQ_mdest * md, int nmd);
+void rreq_batch_timeout(void *arg);
 void rreq_forward(RREQ * rreq, int size, int ttl);
 void rreq_process(RREQ * rreq, int rreqlen, struct in_addr ip_src,
 		  struct in_addr ip_dst, int ip_ttl, unsigned int ifindex);
 void rreq_route_discovery(struct in_addr dest_addr, u_int8_t flags,
 			  struct ip_data *ipd);
 void rreq_record_timeout(void *arg);
+void rreq_fwd_timeout(void *arg);
+void rreq_blacklist_init();
 struct blacklist *rreq_blacklist_insert(struct in_addr dest_addr);
 void rreq_blacklist_timeout(void *arg);
+void rreq_preempt(rt_table_t * rt);
 void rreq_local_repair(rt_table_t * rt, struct in_addr src_addr,
 		       struct ip_data *ipd);
 
@@ -101,6 +130,19 @@ struct rreq_record *rreq_record_insert(struct in_addr orig_addr,
 struct rreq_record *rreq_record_find(struct in_addr orig_addr,
 				     u_int32_t rreq_id);
 struct blacklist *rreq_blacklist_find(struct in_addr dest_addr);
+void rreq_schedule_forward(struct rreq_record *rec, RREQ * rreq, int size,
+			   int ttl);
+int rreq_fwd_threshold();
+AODV_ext *rreq_find_ext(RREQ * rreq, int rreqlen, int type);
+u_int32_t rreq_metric_get(RREQ * rreq, int rreqlen, struct in_addr ip_src);
+void rreq_metric_update(RREQ * rreq, int rreqlen, u_int32_t metric);
+void rreq_intermediate_reply(RREQ * rreq, rt_table_t * rev_rt,
+			     rt_table_t * fwd_rt);
+int rreq_mdest_remove(RREQ * rreq, int rreqlen, AODV_ext * ext, int i);
+int rreq_mdest_process(RREQ * rreq, int rreqlen, AODV_ext * ext,
+		       rt_table_t * rev_rt, unsigned int ifindex);
+void rreq_mdest_forward(struct rreq_record *rec, RREQ * rreq, int rreqlen,
+			int ip_ttl);
 #endif				/* NS_PORT */
 
 #endif				/* NS_NO_DECLARATIONS */
@@ -39,6 +39,11 @@
 #include "aodv_neighbor.h"
 #include "debug.h"
 #include "defs.h"
+#include "stats.h"
+
+#ifdef CONFIG_BPF_RREQ
+#include "rreq_bpf.h"
+#endif
 
 #endif				/* NS_PORT */
 
@@ -49,8 +54,23 @@ static char recv_buf[RECV_BUF_SIZE];
 static char send_buf[SEND_BUF_SIZE];
 
 extern int wait_on_reboot, hello_qual_threshold, ratelimit;
+#ifdef CONFIG_BPF_RREQ
+extern int bpf_rreq_filter;
+#endif
+
+static struct ratel_bucket rreq_bucket, rerr_bucket;
+static LIST(ratel_queue);
+static int ratel_qlen = 0;
+static struct timer ratel_timer;
 
 static void aodv_socket_read(int fd);
+static void aodv_socket_xmit(AODV_msg * aodv_msg, struct in_addr dst,
+			     int len, u_int8_t ttl, struct dev_info *dev);
+static int aodv_socket_ratel_take(struct ratel_bucket *b);
+static long aodv_socket_ratel_wait(struct ratel_bucket *b);
+static void aodv_socket_ratel_queue(AODV_msg * aodv_msg, struct in_addr dst,
+				    int len, u_int8_t ttl,
+				    struct dev_info *dev);
 
 /* Seems that some libc (for example ulibc) has a bug in the provided
  * CMSG_NXTHDR() routine... redefining it here */
@@ -93,6 +113,12 @@ void NS_CLASS aodv_socket_init()
 	fprintf(stderr, "No interfaces configured\n");
 	exit(-1);
     }
+#ifdef CONFIG_BPF_RREQ
+    /* Try to set up in-kernel duplicate RREQ filtering. On failure we
+       silently fall back to filtering in user space. */
+    if (bpf_rreq_filter && rreq_bpf_init() < 0)
+	bpf_rreq_filter = 0;
+#endif
 
     /* Open a socket for every AODV enabled interface */
     for (i = 0; i < MAX_NR_INTERFACES; i++) {
@@ -194,6 +220,10 @@ void NS_CLASS aodv_socket_init()
 		exit(-1);
 	    }
 	}
+#ifdef CONFIG_BPF_RREQ
+	if (bpf_rreq_filter && rreq_bpf_attach(DEV_NR(i).sock) < 0)
+	    bpf_rreq_filter = 0;
+#endif
 
 	retval = attach_callback_func(DEV_NR(i).sock, aodv_socket_read);
 
@@ -204,8 +234,19 @@ void NS_CLASS aodv_socket_init()
     }
 #endif				/* NS_PORT */
 
-    num_rreq = 0;
-    num_rerr = 0;
+    /* Both buckets start out full */
+    rreq_bucket.rate = RREQ_RATELIMIT;
+    rreq_bucket.tokens = RREQ_RATELIMIT * 1000;
+    gettimeofday(&rreq_bucket.last, NULL);
+    rreq_bucket.queued = 0;
+
+    rerr_bucket.rate = RERR_RATELIMIT;
+    rerr_bucket.tokens = RERR_RATELIMIT * 1000;
+    gettimeofday(&rerr_bucket.last, NULL);
+    rerr_bucket.queued = 0;
+
+    ratel_qlen = 0;
+    timer_init(&ratel_timer, &NS_CLASS aodv_socket_ratel_timeout, NULL);
 }
 
 void NS_CLASS aodv_socket_process_packet(AODV_msg * aodv_msg, int len,
@@ -217,10 +258,13 @@ void NS_CLASS aodv_socket_process_packet(AODV_msg * aodv_msg, int len,
     /* If this was a HELLO message... Process as HELLO. */
     if ((aodv_msg->type == AODV_RREP && ttl == 1 &&
 	 dst.s_addr == AODV_BROADCAST)) {
+	STATS_INC(STATS_HELLO, rx);
 	hello_process((RREP *) aodv_msg, len, ifindex);
 	return;
     }
 
+    STATS_INC(STATS_TYPE(aodv_msg->type), rx);
+
     /* Make sure we add/update neighbors */
     neighbor_add(aodv_msg, src, ifindex);
 
@@ -366,17 +410,214 @@ static void aodv_socket_read(int fd)
 void NS_CLASS aodv_socket_send(AODV_msg * aodv_msg, struct in_addr dst,
 			       int len, u_int8_t ttl, struct dev_info *dev)
 {
-    int retval = 0;
+    struct ratel_bucket *b = NULL;
+
+    /* If we are in waiting phase after reboot, don't send any RREPs */
+    if (wait_on_reboot && aodv_msg->type == AODV_RREP) {
+	STATS_INC(STATS_RREP, dropped);
+	return;
+    }
+
+    /* If rate limiting is enabled, RREQs and RERRs need a token from
+       their bucket to be sent right away. Otherwise they are queued
+       until a token becomes available, instead of being dropped. */
+    if (ratelimit) {
+	if (aodv_msg->type == AODV_RREQ)
+	    b = &rreq_bucket;
+	else if (aodv_msg->type == AODV_RERR)
+	    b = &rerr_bucket;
+    }
+
+    if (b && (b->queued || !aodv_socket_ratel_take(b))) {
+	STATS_INC(STATS_TYPE(aodv_msg->type), ratelimited);
+	aodv_socket_ratel_queue(aodv_msg, dst, len, ttl, dev);
+	return;
+    }
+    aodv_socket_xmit(aodv_msg, dst, len, ttl, dev);
+}
+
+/* Refill a bucket according to the time passed since the last refill
+   and take a token if there is one. Returns 1 if a token was taken. */
+NS_STATIC int NS_CLASS aodv_socket_ratel_take(struct ratel_bucket *b)
+{
+    struct timeval now;
+    long elapsed;
+
+    gettimeofday(&now, NULL);
+
+    elapsed = timeval_diff(&now, &b->last);
+
+    if (elapsed > 0) {
+	b->tokens += (elapsed < 1000 ? elapsed : 1000) * b->rate;
+
+	if (b->tokens >= b->rate * 1000) {
+	    b->tokens = b->rate * 1000;
+	    b->last = now;
+	} else
+	    timeval_add_msec(&b->last, elapsed);
+    }
+
+    if (b->tokens < 1000)
+	return 0;
+
+    b->tokens -= 1000;
+    return 1;
+}
+
+/* Milliseconds until the bucket holds a whole token */
+NS_STATIC long NS_CLASS aodv_socket_ratel_wait(struct ratel_bucket *b)
+{
+    if (b->tokens >= 1000)
+	return 0;
+
+    return (1000 - b->tokens + b->rate - 1) / b->rate;
+}
+
+NS_STATIC void NS_CLASS aodv_socket_ratel_queue(AODV_msg * aodv_msg,
+						struct in_addr dst, int len,
+						u_int8_t ttl,
+						struct dev_info *dev)
+{
+    struct ratel_bucket *b;
+    struct ratel_msg *m;
+    list_t *pos;
+    int prio;
+
+    if (aodv_msg->type == AODV_RERR) {
+	b = &rerr_bucket;
+	prio = RATEL_PRIO_RERR;
+
+	/* A RERR to the same neighbor may already be waiting. Then we
+	   just add our unreachable destinations to that one. */
+	list_foreach(pos, &ratel_queue) {
+	    m = (struct ratel_msg *) pos;
+
+	    if (m->prio == RATEL_PRIO_RERR && m->dev == dev &&
+		m->dst.s_addr == dst.s_addr &&
+		rerr_merge((RERR *) m->msg, (RERR *) aodv_msg) == 0) {
+		m->len = RERR_CALC_SIZE(((RERR *) m->msg));
+		DEBUG(LOG_DEBUG, 0, "RATELIMIT: Merged RERR to %s, %d udests",
+		      ip_to_str(dst), ((RERR *) m->msg)->dest_count);
+		return;
+	    }
+	}
+    } else {
+	b = &rreq_bucket;
+
+	if (((RREQ *) aodv_msg)->orig_addr == dev->ipaddr.s_addr)
+	    prio = RATEL_PRIO_RREQ_ORIG;
+	else
+	    prio = RATEL_PRIO_RREQ_FWD;
+    }
+
+    /* If the queue is full, make room by dropping the least urgent
+       message, unless that one is more urgent than this one. */
+    if (ratel_qlen >= RATEL_QUEUE_MAX) {
+	m = (struct ratel_msg *) ratel_queue.prev;
+
+	if (m->prio <= prio) {
+	    DEBUG(LOG_DEBUG, 0, "RATELIMIT: Queue full, dropping msg type %d",
+		  aodv_msg->type);
+	    STATS_INC(STATS_TYPE(aodv_msg->type), dropped);
+	    return;
+	}
+	DEBUG(LOG_DEBUG, 0, "RATELIMIT: Queue full, dropping queued type %d",
+	      ((AODV_msg *) m->msg)->type);
+	STATS_INC(STATS_TYPE(((AODV_msg *) m->msg)->type), dropped);
+
+	list_detach(&m->l);
+	ratel_qlen--;
+	if (((AODV_msg *) m->msg)->type == AODV_RREQ)
+	    rreq_bucket.queued--;
+	else
+	    rerr_bucket.queued--;
+	free(m);
+    }
+
+    if ((m = (struct ratel_msg *) malloc(sizeof(struct ratel_msg))) == NULL) {
+	fprintf(stderr, "Malloc failed!!!\n");
+	exit(-1);
+    }
+    memcpy(m->msg, aodv_msg, len);
+    m->prio = prio;
+    m->dst = dst;
+    m->len = len;
+    m->ttl = ttl;
+    m->dev = dev;
+    gettimeofday(&m->queued, NULL);
+
+    /* Keep the queue sorted on priority, FIFO within a priority */
+    list_foreach(pos, &ratel_queue) {
+	if (((struct ratel_msg *) pos)->prio > prio)
+	    break;
+    }
+    list_add_tail(pos, &m->l);
+
+    ratel_qlen++;
+    b->queued++;
+
+    DEBUG(LOG_DEBUG, 0, "RATELIMIT: Queued msg type %d to %s, qlen=%d",
+	  aodv_msg->type, ip_to_str(dst), ratel_qlen);
+
+    if (!ratel_timer.used)
+	timer_set_timeout(&ratel_timer, aodv_socket_ratel_wait(b));
+}
+
+/* Send queued messages for which there are tokens, in priority
+   order. Messages that waited too long are dropped. */
+void NS_CLASS aodv_socket_ratel_timeout(void *arg)
+{
+    list_t *pos, *tmp;
     struct timeval now;
-    /* Rate limit stuff: */
+    long wait, next = -1;
+
+    gettimeofday(&now, NULL);
+
+    list_foreach_safe(pos, tmp, &ratel_queue) {
+	struct ratel_msg *m = (struct ratel_msg *) pos;
+	AODV_msg *aodv_msg = (AODV_msg *) m->msg;
+	struct ratel_bucket *b;
+
+	if (aodv_msg->type == AODV_RREQ)
+	    b = &rreq_bucket;
+	else
+	    b = &rerr_bucket;
+
+	if (timeval_diff(&now, &m->queued) <= RATEL_MAX_DELAY) {
+	    if (!aodv_socket_ratel_take(b)) {
+		wait = aodv_socket_ratel_wait(b);
+		if (next < 0 || wait < next)
+		    next = wait;
+		continue;
+	    }
+	    aodv_socket_xmit(aodv_msg, m->dst, m->len, m->ttl, m->dev);
+	} else {
+	    DEBUG(LOG_DEBUG, 0, "RATELIMIT: Dropping msg type %d to %s",
+		  aodv_msg->type, ip_to_str(m->dst));
+	}
+	list_detach(&m->l);
+	ratel_qlen--;
+	b->queued--;
+	free(m);
+    }
+
+    if (next >= 0)
+	timer_set_timeout(&ratel_timer, next);
+}
+
+NS_STATIC void NS_CLASS aodv_socket_xmit(AODV_msg * aodv_msg,
+					 struct in_addr dst, int len,
+					 u_int8_t ttl, struct dev_info *dev)
+{
+    int retval = 0;
+    int type = (aodv_msg->type == AODV_RREP &&
+		dst.s_addr == AODV_BROADCAST) ? STATS_HELLO :
+	STATS_TYPE(aodv_msg->type);
 
 #ifndef NS_PORT
 
     struct sockaddr_in dst_addr;
 
-    if (wait_on_reboot && aodv_msg->type == AODV_RREP)
-	return;
-
     memset(&dst_addr, 0, sizeof(dst_addr));
     dst_addr.sin_family = AF_INET;
     dst_addr.sin_addr = dst;
@@ -385,6 +626,7 @@ void NS_CLASS aodv_socket_send(AODV_msg * aodv_msg, struct in_addr dst,
     /* Set ttl */
     if (setsockopt(dev->sock, SOL_IP, IP_TTL, &ttl, sizeof(ttl)) < 0) {
 	alog(LOG_WARNING, 0, __FUNCTION__, "ERROR setting ttl!");
+	STATS_INC(type, dropped);
 	return;
     }
 #else
@@ -397,10 +639,6 @@ void NS_CLASS aodv_socket_send(AODV_msg * aodv_msg, struct in_addr dst,
        agents, _not_ for forwarding "regular" IP packets!
      */
 
-    /* If we are in waiting phase after reboot, don't send any RREPs */
-    if (wait_on_reboot && aodv_msg->type == AODV_RREP)
-	return;
-
     /*
        NS_PORT: Don't allocate packet until now. Otherwise packet uid
        (unique ID) space is unnecessarily exhausted at the beginning of
@@ -438,59 +676,6 @@ void NS_CLASS aodv_socket_send(AODV_msg * aodv_msg, struct in_addr dst,
     retval = len;
 #endif				/* NS_PORT */
 
-    /* If rate limiting is enabled, check if we are sending either a
-       RREQ or a RERR. In that case, drop the outgoing control packet
-       if the time since last transmit of that type of packet is less
-       than the allowed RATE LIMIT time... */
-
-    if (ratelimit) {
-
-	gettimeofday(&now, NULL);
-
-	switch (aodv_msg->type) {
-	case AODV_RREQ:
-	    if (num_rreq == (RREQ_RATELIMIT - 1)) {
-		if (timeval_diff(&now, &rreq_ratel[0]) < 1000) {
-		    DEBUG(LOG_DEBUG, 0, "RATELIMIT: Dropping RREQ %ld ms",
-			  timeval_diff(&now, &rreq_ratel[0]));
-#ifdef NS_PORT
-		  	Packet::free(p);
-#endif
-		    return;
-		} else {
-		    memmove(rreq_ratel, &rreq_ratel[1],
-			    sizeof(struct timeval) * (num_rreq - 1));
-		    memcpy(&rreq_ratel[num_rreq - 1], &now,
-			   sizeof(struct timeval));
-		}
-	    } else {
-		memcpy(&rreq_ratel[num_rreq], &now, sizeof(struct timeval));
-		num_rreq++;
-	    }
-	    break;
-	case AODV_RERR:
-	    if (num_rerr == (RERR_RATELIMIT - 1)) {
-		if (timeval_diff(&now, &rerr_ratel[0]) < 1000) {
-		    DEBUG(LOG_DEBUG, 0, "RATELIMIT: Dropping RERR %ld ms",
-			  timeval_diff(&now, &rerr_ratel[0]));
-#ifdef NS_PORT
-		  	Packet::free(p);
-#endif
-		    return;
-		} else {
-		    memmove(rerr_ratel, &rerr_ratel[1],
-			    sizeof(struct timeval) * (num_rerr - 1));
-		    memcpy(&rerr_ratel[num_rerr - 1], &now,
-			   sizeof(struct timeval));
-		}
-	    } else {
-		memcpy(&rerr_ratel[num_rerr], &now, sizeof(struct timeval));
-		num_rerr++;
-	    }
-	    break;
-	}
-    }
-
     /* If we broadcast this message we update the time of last broadcast
        to prevent unnecessary broadcasts of HELLO msg's */
     if (dst.s_addr == AODV_BROADCAST) {
@@ -503,13 +688,14 @@ void NS_CLASS aodv_socket_send(AODV_msg * aodv_msg, struct in_addr dst,
 	sendPacket(p, dst, 0.0);
 #else
 
-	retval = sendto(dev->sock, send_buf, len, 0,
+	retval = sendto(dev->sock, (char *) aodv_msg, len, 0,
 			(struct sockaddr *) &dst_addr, sizeof(dst_addr));
 
 	if (retval < 0) {
 
 	    alog(LOG_WARNING, errno, __FUNCTION__, "Failed send to bc %s",
 		 ip_to_str(dst));
+	    STATS_INC(type, dropped);
 	    return;
 	}
 #endif
@@ -525,17 +711,20 @@ void NS_CLASS aodv_socket_send(AODV_msg * aodv_msg, struct in_addr dst,
 	else
 	    sendPacket(p, dst, 0.0);
 #else
-	retval = sendto(dev->sock, send_buf, len, 0,
+	retval = sendto(dev->sock, (char *) aodv_msg, len, 0,
 			(struct sockaddr *) &dst_addr, sizeof(dst_addr));
 
 	if (retval < 0) {
 	    alog(LOG_WARNING, errno, __FUNCTION__, "Failed send to %s",
 		 ip_to_str(dst));
+	    STATS_INC(type, dropped);
 	    return;
 	}
 #endif
     }
 
+    STATS_INC(type, tx);
+
     /* Do not print hello msgs... */
     if (!(aodv_msg->type == AODV_RREP && (dst.s_addr == AODV_BROADCAST)))
 	DEBUG(LOG_INFO, 0, "AODV msg to %s ttl=%d size=%u",
@@ -557,15 +746,31 @@ AODV_msg *NS_CLASS aodv_socket_queue_msg(AODV_msg * aodv_msg, int size)
     return (AODV_msg *) send_buf;
 }
 
-void aodv_socket_cleanup(void)
+void NS_CLASS aodv_socket_cleanup(void)
 {
+    list_t *pos, *tmp;
 #ifndef NS_PORT
     int i;
+#endif
+
+    timer_remove(&ratel_timer);
+
+    list_foreach_safe(pos, tmp, &ratel_queue) {
+	list_detach(pos);
+	free(pos);
+    }
+    ratel_qlen = 0;
+    rreq_bucket.queued = 0;
+    rerr_bucket.queued = 0;
 
+#ifndef NS_PORT
     for (i = 0; i < MAX_NR_INTERFACES; i++) {
 	if (!DEV_NR(i).enabled)
 	    continue;
 	close(DEV_NR(i).sock);
     }
+#ifdef CONFIG_BPF_RREQ
+    rreq_bpf_cleanup();
+#endif
 #endif				/* NS_PORT */
 }
@@ -35,23 +35,49 @@
 /* Set a maximun size for AODV msgs. The RERR is the potentially
    largest message, depending on how many unreachable destinations
    that are included. Lets limit them to 100 */
-#define AODV_MSG_MAX_SIZE RERR_SIZE + 100 * RERR_UDEST_SIZE
+#define AODV_MSG_MAX_SIZE RERR_MAX_SIZE
 #define RECV_BUF_SIZE AODV_MSG_MAX_SIZE
 #define SEND_BUF_SIZE RECV_BUF_SIZE
+
+/* Rate limiting of RREQs and RERRs is done with one token bucket per
+   message type. Messages that find the bucket empty are queued in
+   priority order and sent as tokens become available. */
+struct ratel_bucket {
+    long tokens;		/* In thousandths of a token */
+    long rate;			/* Tokens per second, also the burst size */
+    struct timeval last;	/* Time of last refill */
+    int queued;			/* Messages waiting for a token */
+};
+
+/* Queueing priorities, lower is more urgent */
+#define RATEL_PRIO_RERR      0
+#define RATEL_PRIO_RREQ_ORIG 1	/* RREQs we originate */
+#define RATEL_PRIO_RREQ_FWD  2	/* RREQs we forward */
+
+#define RATEL_QUEUE_MAX 32	/* Max number of queued messages */
+#define RATEL_MAX_DELAY 1000	/* Max msecs a message may wait for a token */
+
+struct ratel_msg {
+    list_t l;
+    int prio;
+    struct in_addr dst;
+    int len;
+    u_int8_t ttl;
+    struct dev_info *dev;
+    struct timeval queued;
+    char msg[AODV_MSG_MAX_SIZE];
+};
 #endif				/* NS_NO_GLOBALS */
 
 #ifndef NS_NO_DECLARATIONS
 
-struct timeval rreq_ratel[RREQ_RATELIMIT - 1], rerr_ratel[RERR_RATELIMIT - 1];
-int num_rreq;
-int num_rerr;
-
 void aodv_socket_init();
 void aodv_socket_send(AODV_msg * aodv_msg, struct in_addr dst, int len,
 		      u_int8_t ttl, struct dev_info *dev);
 AODV_msg *aodv_socket_new_msg();
 AODV_msg *aodv_socket_queue_msg(AODV_msg * aodv_msg, int size);
 void aodv_socket_cleanup(void);
+void aodv_socket_ratel_timeout(void *arg);
 void aodv_socket_process_packet(AODV_msg * aodv_msg, int len,
 				struct in_addr src, struct in_addr dst, int ttl,
 				unsigned int ifindex);
@@ -60,6 +86,12 @@ struct cmsghdr *cmsg_nxthdr_fix(struct msghdr *__msg, struct cmsghdr *__cmsg);
 
 #ifdef NS_PORT
 void recvAODVUUPacket(Packet * p);
+void aodv_socket_xmit(AODV_msg * aodv_msg, struct in_addr dst, int len,
+		      u_int8_t ttl, struct dev_info *dev);
+int aodv_socket_ratel_take(struct ratel_bucket *b);
+long aodv_socket_ratel_wait(struct ratel_bucket *b);
+void aodv_socket_ratel_queue(AODV_msg * aodv_msg, struct in_addr dst,
+			     int len, u_int8_t ttl, struct dev_info *dev);
 #endif				/* NS_PORT */
 
 #endif				/* NS_NO_DECLARATIONS */
@@ -35,6 +35,7 @@
 #include "aodv_rerr.h"
 #include "timer_queue.h"
 #include "debug.h"
+#include "evlog.h"
 #include "params.h"
 #include "routing_table.h"
 #include "seek_list.h"
@@ -64,6 +65,18 @@ void NS_CLASS route_discovery_timeout(void *arg)
 
 	DEBUG(LOG_DEBUG, 0, "%s", ip_to_str(seek_entry->dest_addr));
 
+	/* A preemptive discovery got no answer. If the route still
+	   works it is simply kept, otherwise keep seeking. */
+	if (seek_entry->preempt) {
+		rt = rt_table_find(seek_entry->dest_addr);
+
+		if (rt && rt->state == VALID) {
+			seek_list_remove(seek_entry);
+			return;
+		}
+		seek_list_preempt_clear(seek_entry);
+	}
+
 	if (seek_entry->reqs < RREQ_RETRIES) {
 
 		if (expanding_ring_search) {
@@ -99,10 +112,12 @@ void NS_CLASS route_discovery_timeout(void *arg)
 
 		rreq_send(seek_entry->dest_addr, seek_entry->dest_seqno,
 			  TTL_VALUE, seek_entry->flags);
+		seek_entry->rreqs++;
+		gettimeofday(&seek_entry->rreq_time, NULL);
 
 	} else {
-
 		DEBUG(LOG_DEBUG, 0, "NO ROUTE FOUND!");
+		EVLOG(EV_NO_ROUTE, seek_entry->dest_addr.s_addr, 0, 0, 0);
 
 #ifdef NS_PORT
 		packet_queue_set_verdict(seek_entry->dest_addr, PQ_DROP);
@@ -111,6 +126,8 @@ void NS_CLASS route_discovery_timeout(void *arg)
 #endif
 		repair_rt = rt_table_find(seek_entry->dest_addr);
 
+		seek_list_hist_update(seek_entry->dest_addr, 0, 0);
+		seek_list_lat_record(seek_entry, 0, DISC_FAILED);
 		seek_list_remove(seek_entry);
 
 		/* If this route has been in repair, then we should timeout
@@ -126,7 +143,6 @@ void NS_CLASS route_discovery_timeout(void *arg)
 void NS_CLASS local_repair_timeout(void *arg)
 {
 	rt_table_t *rt;
-	struct in_addr rerr_dest;
 	RERR *rerr = NULL;
 
 	rt = (rt_table_t *) arg;
@@ -134,8 +150,6 @@ void NS_CLASS local_repair_timeout(void *arg)
 	if (!rt)
 		return;
 
-	rerr_dest.s_addr = AODV_BROADCAST;	/* Default destination */
-
 	/* Unset the REPAIR flag */
 	rt->flags &= ~RT_REPAIR;
 
@@ -145,28 +159,16 @@ void NS_CLASS local_repair_timeout(void *arg)
 	/* Route should already be invalidated. */
 
 	if (rt->nprec) {
+		struct rerr_targets targets;
 
 		rerr = rerr_create(0, rt->dest_addr, rt->dest_seqno);
 
-		if (rt->nprec == 1) {
-			rerr_dest = FIRST_PREC(rt->precursors)->neighbor;
+		rerr_targets_init(&targets);
+		rerr_targets_add(&targets, rt);
+		rerr_targets_send(&targets, rerr);
 
-			aodv_socket_send((AODV_msg *) rerr, rerr_dest,
-					 RERR_CALC_SIZE(rerr), 1,
-					 &DEV_IFINDEX(rt->ifindex));
-		} else {
-			int i;
-
-			for (i = 0; i < MAX_NR_INTERFACES; i++) {
-				if (!DEV_NR(i).enabled)
-					continue;
-				aodv_socket_send((AODV_msg *) rerr, rerr_dest,
-						 RERR_CALC_SIZE(rerr), 1,
-						 &DEV_NR(i));
-			}
-		}
-		DEBUG(LOG_DEBUG, 0, "Sending RERR about %s to %s",
-		      ip_to_str(rt->dest_addr), ip_to_str(rerr_dest));
+		DEBUG(LOG_DEBUG, 0, "Sending RERR about %s",
+		      ip_to_str(rt->dest_addr));
 	}
 	precursor_list_destroy(rt);
 
@@ -254,6 +256,7 @@ void NS_CLASS hello_timeout(void *arg)
 #endif
 		}
 		neighbor_link_break(rt);
+		hello_neighbor_change();
 	}
 }
 
@@ -0,0 +1,702 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* aodv-bench: microbenchmarks for the daemon's core data structures.
+ *
+ * Linked like aodv-replay: the daemon objects, the netlink stubs and a
+ * virtual clock, so nothing depends on the machine's real time except
+ * the measurements themselves. Addresses come from a seeded generator,
+ * so two runs with the same options do exactly the same work.
+ *
+ * Output is one tab separated line per benchmark and size:
+ *
+ *   bench  n  ops  ns/op  allocs/op  p99_ns
+ *
+ * where n is the routing table size, timer queue length, flood rate
+ * (RREQs/sec) or precursor list length, depending on the benchmark.
+ * Times are per operation, with the cost of reading the clock
+ * subtracted. */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <time.h>
+
+#include "../defs.h"
+#include "../debug.h"
+#include "../params.h"
+#include "../timer_queue.h"
+#include "../routing_table.h"
+#include "../seek_list.h"
+#include "../aodv_socket.h"
+#include "../aodv_rreq.h"
+#include "../aodv_neighbor.h"
+#include "../nl.h"
+
+extern int ratelimit, wait_on_reboot, bpf_rreq_filter, debug, log_level;
+extern char *progname;
+
+#define NB_MAX     16		/* Neighbors routes are spread over */
+#define TIMER_SPAN 10000	/* Timeouts are random in [0, TIMER_SPAN) ms */
+#define RREQ_COPIES 4		/* Copies of each RREQ heard in a flood */
+#define BENCH_WORK 100000000UL	/* Max ops * n for one size */
+
+static struct timeval vclock;
+static unsigned long n_mallocs;
+static unsigned long long overhead;
+static char *only = NULL;
+static u_int32_t seed = 1;
+
+static struct in_addr nb[NB_MAX];
+static struct in_addr bcast;
+
+/* Linker wrapped functions, see aodv-replay.c */
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t nmemb, size_t size);
+
+int __wrap_gettimeofday(struct timeval *tv, void *tz)
+{
+    *tv = vclock;
+    return 0;
+}
+
+void *__wrap_malloc(size_t size)
+{
+    n_mallocs++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t nmemb, size_t size)
+{
+    n_mallocs++;
+    return __real_calloc(nmemb, size);
+}
+
+ssize_t __wrap_sendto(int s, const void *buf, size_t len, int flags,
+		      const struct sockaddr *to, socklen_t tolen)
+{
+    return len;
+}
+
+int __wrap_setsockopt(int s, int level, int optname, const void *optval,
+		      socklen_t optlen)
+{
+    return 0;
+}
+
+static void vclock_advance(long usecs)
+{
+    vclock.tv_usec += usecs;
+    vclock.tv_sec += vclock.tv_usec / 1000000;
+    vclock.tv_usec %= 1000000;
+}
+
+/* xorshift32, so that runs do not depend on the C library's rand() */
+static u_int32_t rnd(void)
+{
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+static unsigned long long nsecs_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Measurements */
+
+struct bench {
+    char *name;
+    int n;
+    unsigned long ops;
+    unsigned long max;
+    unsigned long allocs;
+    unsigned int *lat;
+};
+
+#define BENCH_OP(b, op)							\
+	do {								\
+		unsigned long long t0;					\
+		unsigned long m0 = n_mallocs;				\
+		t0 = nsecs_now();					\
+		op;							\
+		t0 = nsecs_now() - t0;					\
+		if ((b)->ops < (b)->max) {				\
+			(b)->allocs += n_mallocs - m0;			\
+			(b)->lat[(b)->ops++] =				\
+				t0 > overhead ? t0 - overhead : 0;	\
+		}							\
+	} while (0)
+
+/* Whether any benchmark in a group is selected with -b */
+static int bench_want(char *group)
+{
+    if (!only)
+	return 1;
+
+    return strncmp(only, group, strlen(group)) == 0 ||
+	strncmp(group, only, strlen(only)) == 0;
+}
+
+static int bench_begin(struct bench *b, char *name, int n,
+		       unsigned long max)
+{
+    if (only && strncmp(name, only, strlen(only)) != 0)
+	return 0;
+
+    b->name = name;
+    b->n = n;
+    b->ops = 0;
+    b->max = max;
+    b->allocs = 0;
+
+    if ((b->lat = malloc(max * sizeof(unsigned int))) == NULL) {
+	perror("malloc");
+	exit(1);
+    }
+    return 1;
+}
+
+static int lat_cmp(const void *a, const void *b)
+{
+    unsigned int x = *(unsigned int *) a, y = *(unsigned int *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+static void bench_end(struct bench *b)
+{
+    unsigned long long sum = 0;
+    unsigned long i;
+
+    if (!b->lat)
+	return;
+
+    for (i = 0; i < b->ops; i++)
+	sum += b->lat[i];
+
+    qsort(b->lat, b->ops, sizeof(unsigned int), lat_cmp);
+
+    printf("%s\t%d\t%lu\t%.1f\t%.2f\t%u\n", b->name, b->n, b->ops,
+	   b->ops ? (double) sum / b->ops : 0,
+	   b->ops ? (double) b->allocs / b->ops : 0,
+	   b->ops ? b->lat[(b->ops * 99) / 100] : 0);
+    fflush(stdout);
+
+    free(b->lat);
+    b->lat = NULL;
+}
+
+/* Cost of the two clock reads around an operation */
+static void bench_calibrate(void)
+{
+    struct bench b;
+    int i;
+
+    memset(&b, 0, sizeof(b));
+    b.max = 10000;
+    b.lat = malloc(b.max * sizeof(unsigned int));
+    overhead = 0;
+
+    for (i = 0; i < 10000; i++)
+	BENCH_OP(&b, /* nothing */);
+
+    qsort(b.lat, b.ops, sizeof(unsigned int), lat_cmp);
+    overhead = b.lat[b.ops / 2];
+    free(b.lat);
+}
+
+/* Addresses as they tend to look in a mesh: mostly hosts numbered
+   from 1 in a number of /24s under 10/8, plus some scattered hosts
+   under 192.168/16 (gateways, Internet destinations). */
+static struct in_addr *gen_addrs(int n)
+{
+    static unsigned char used10[65536], used192[65536];
+    struct in_addr *a;
+    u_int32_t net = 0;
+    int i, host = 255;
+
+    memset(used10, 0, sizeof(used10));
+    memset(used192, 0, sizeof(used192));
+    used10[0xfffe] = used10[0xffff] = 1;	/* Neighbors and us */
+
+    if ((a = malloc(n * sizeof(struct in_addr))) == NULL) {
+	perror("malloc");
+	exit(1);
+    }
+
+    for (i = 0; i < n; i++) {
+	u_int32_t r = rnd();
+
+	if (r % 8 == 0) {
+	    do
+		r = rnd() & 0xffff;
+	    while (used192[r] || (r & 0xff) == 0 || (r & 0xff) == 255);
+	    used192[r] = 1;
+	    a[i].s_addr = htonl(0xc0a80000 | r);
+	    continue;
+	}
+	if (host == 255) {
+	    do
+		net = rnd() & 0xffff;
+	    while (used10[net]);
+	    used10[net] = 1;
+	    host = 1;
+	}
+	a[i].s_addr = htonl(0x0a000000 | (net << 8) | host++);
+    }
+    return a;
+}
+
+/* Addresses that are never generated above */
+static struct in_addr unknown_addr(void)
+{
+    struct in_addr a;
+
+    a.s_addr = htonl(0x0b000000 | (rnd() & 0xffffff));
+    return a;
+}
+
+static void neighbors_insert(void)
+{
+    int i;
+
+    for (i = 0; i < NB_MAX; i++)
+	rt_table_insert(nb[i], nb[i], 1, 1, ACTIVE_ROUTE_TIMEOUT, VALID, 0,
+			1);
+}
+
+/* Let every timer run out, then drop what is left of the table */
+static void state_flush(void)
+{
+    int i;
+
+    for (i = 0; i < 10; i++) {
+	vclock_advance(600 * 1000000L);
+	timer_age_queue();
+    }
+    rt_table_destroy();
+}
+
+/* Routing table */
+
+static void bench_rt(int n, unsigned long ops)
+{
+    struct bench b;
+    struct in_addr *a = gen_addrs(n);
+    rt_table_t *rt;
+    unsigned long i;
+    int *order;
+
+    memset(&b, 0, sizeof(b));
+    neighbors_insert();
+
+    if (bench_begin(&b, "rt_insert", n, n)) {
+	for (i = 0; i < n; i++)
+	    BENCH_OP(&b, rt_table_insert(a[i], nb[i % NB_MAX], 2 + i % 8, 1,
+					 ACTIVE_ROUTE_TIMEOUT, VALID, 0, 1));
+	bench_end(&b);
+    } else {
+	for (i = 0; i < n; i++)
+	    rt_table_insert(a[i], nb[i % NB_MAX], 2 + i % 8, 1,
+			    ACTIVE_ROUTE_TIMEOUT, VALID, 0, 1);
+    }
+
+    /* One in ten lookups is for an unknown destination */
+    if (bench_begin(&b, "rt_find", n, ops)) {
+	for (i = 0; i < ops; i++) {
+	    struct in_addr d = rnd() % 10 ? a[rnd() % n] : unknown_addr();
+	    BENCH_OP(&b, rt = rt_table_find(d));
+	}
+	bench_end(&b);
+    }
+
+    /* An update a millisecond, so that the new timeout is later */
+    if (bench_begin(&b, "rt_update", n, ops)) {
+	for (i = 0; i < ops; i++) {
+	    rt = rt_table_find(a[rnd() % n]);
+	    vclock_advance(1000);
+	    BENCH_OP(&b, rt_table_update(rt, nb[rnd() % NB_MAX],
+					 2 + rnd() % 8, rt->dest_seqno + 1,
+					 ACTIVE_ROUTE_TIMEOUT, VALID,
+					 rt->flags));
+	}
+	bench_end(&b);
+    }
+
+    if ((order = malloc(n * sizeof(int))) == NULL) {
+	perror("malloc");
+	exit(1);
+    }
+    for (i = 0; i < n; i++)
+	order[i] = i;
+    for (i = n - 1; i > 0; i--) {
+	int j = rnd() % (i + 1), tmp = order[i];
+	order[i] = order[j];
+	order[j] = tmp;
+    }
+
+    if (bench_begin(&b, "rt_delete", n, n)) {
+	for (i = 0; i < n; i++) {
+	    rt = rt_table_find(a[order[i]]);
+	    BENCH_OP(&b, rt_table_delete(rt));
+	}
+	bench_end(&b);
+    }
+    free(order);
+    free(a);
+    state_flush();
+}
+
+/* Timer queue */
+
+static void bench_timer_rearm(void *arg)
+{
+    timer_set_timeout((struct timer *) arg, rnd() % TIMER_SPAN);
+}
+
+static void bench_timer(int n, unsigned long ops)
+{
+    struct bench b;
+    struct timer *tm, *t;
+    unsigned long i;
+
+    memset(&b, 0, sizeof(b));
+
+    if ((tm = malloc(n * sizeof(struct timer))) == NULL) {
+	perror("malloc");
+	exit(1);
+    }
+    /* Decreasing timeouts, so that each insert stops at the head */
+    for (i = 0; i < n; i++) {
+	timer_init(&tm[i], bench_timer_rearm, &tm[i]);
+	timer_set_timeout(&tm[i], (long) (n - 1 - i) * TIMER_SPAN / n);
+    }
+
+    if (bench_begin(&b, "timer_set", n, ops)) {
+	for (i = 0; i < ops; i++) {
+	    t = &tm[rnd() % n];
+	    BENCH_OP(&b, timer_set_timeout(t, rnd() % TIMER_SPAN));
+	}
+	bench_end(&b);
+    }
+
+    if (bench_begin(&b, "timer_remove", n, ops)) {
+	for (i = 0; i < ops; i++) {
+	    t = &tm[rnd() % n];
+	    BENCH_OP(&b, timer_remove(t));
+	    timer_set_timeout(t, rnd() % TIMER_SPAN);
+	}
+	bench_end(&b);
+    }
+
+    /* Each call advances time by 1 ms, and expired timers are set
+       again, so the queue length stays at n. */
+    if (bench_begin(&b, "timer_age", n, ops)) {
+	for (i = 0; i < ops; i++) {
+	    vclock_advance(1000);
+	    BENCH_OP(&b, timer_age_queue());
+	}
+	bench_end(&b);
+    }
+
+    for (i = 0; i < n; i++)
+	timer_remove(&tm[i]);
+    free(tm);
+}
+
+/* RREQ flood. New RREQs arrive at the given rate, and copies from
+   other neighbors follow 10, 20 and 30 ms later. The number of RREQ
+   records kept is about rate * PATH_DISCOVERY_TIME. */
+
+static void rreq_fill(RREQ * rreq, struct in_addr orig, u_int32_t id,
+		      struct in_addr dest, int hcnt)
+{
+    memset(rreq, 0, sizeof(RREQ));
+    rreq->type = AODV_RREQ;
+    rreq->hcnt = hcnt;
+    rreq->rreq_id = htonl(id);
+    rreq->dest_addr = dest.s_addr;
+    rreq->orig_addr = orig.s_addr;
+    rreq->orig_seqno = htonl(id);
+}
+
+static void bench_rreq(int rate, unsigned long ops)
+{
+    struct bench b_new, b_dup;
+    struct in_addr *origs = gen_addrs(1000), *dests;
+    unsigned long i, j, count = ops / RREQ_COPIES;
+    int run_new, run_dup, k;
+    RREQ rreq;
+
+    memset(&b_new, 0, sizeof(b_new));
+    memset(&b_dup, 0, sizeof(b_dup));
+    neighbors_insert();
+
+    run_new = bench_begin(&b_new, "rreq_new", rate, count);
+    run_dup = bench_begin(&b_dup, "rreq_dup", rate, count * RREQ_COPIES);
+
+    if (!run_new && !run_dup) {
+	free(origs);
+	state_flush();
+	return;
+    }
+
+    if ((dests = malloc(count * sizeof(struct in_addr))) == NULL) {
+	perror("malloc");
+	exit(1);
+    }
+    for (i = 0; i < count; i++)
+	dests[i] = unknown_addr();
+
+    for (i = 0; i < count; i++) {
+	vclock_advance(1000000 / rate);
+	timer_age_queue();
+
+	rreq_fill(&rreq, origs[i % 1000], i + 1, dests[i], 2);
+	BENCH_OP(&b_new, rreq_process(&rreq, RREQ_SIZE, nb[i % NB_MAX],
+				      bcast, NET_DIAMETER, 1));
+
+	for (k = 1; k < RREQ_COPIES; k++) {
+	    if (i < k * rate / 100)
+		continue;
+	    j = i - k * rate / 100;
+	    rreq_fill(&rreq, origs[j % 1000], j + 1, dests[j], 2 + k);
+	    BENCH_OP(&b_dup, rreq_process(&rreq, RREQ_SIZE,
+					  nb[(j + k) % NB_MAX], bcast,
+					  NET_DIAMETER, 1));
+	}
+    }
+    free(dests);
+    if (run_new)
+	bench_end(&b_new);
+    else
+	free(b_new.lat);
+    if (run_dup)
+	bench_end(&b_dup);
+    else
+	free(b_dup.lat);
+
+    free(origs);
+    state_flush();
+}
+
+/* Adding a precursor that is not yet in a list of n */
+static void bench_precursor(int n, unsigned long ops)
+{
+    struct bench b;
+    struct in_addr *a = gen_addrs(n), d = unknown_addr(), p;
+    rt_table_t *rt;
+    unsigned long i;
+
+    memset(&b, 0, sizeof(b));
+
+    if (!bench_begin(&b, "precursor_add", n, ops)) {
+	free(a);
+	return;
+    }
+
+    rt = rt_table_insert(d, nb[0], 2, 1, ACTIVE_ROUTE_TIMEOUT, VALID, 0, 1);
+
+    for (i = 1; i < n; i++)
+	precursor_add(rt, a[i], 1);
+
+    for (i = 0; i < ops; i++) {
+	p = a[0];
+	BENCH_OP(&b, precursor_add(rt, p, 1));
+	precursor_remove(rt, p);
+    }
+    bench_end(&b);
+
+    free(a);
+    state_flush();
+}
+
+/* A neighbor with n / NB_MAX routes through it goes away. Each route
+   has two precursors, so every one ends up in the RERR. */
+static void bench_link_break(int n, unsigned long ops)
+{
+    struct bench b;
+    struct in_addr *a;
+    rt_table_t *rt;
+    unsigned long i, reps;
+    int j;
+
+    memset(&b, 0, sizeof(b));
+
+    /* Repairing the table after each break is expensive, so fewer
+       repetitions are done for large tables. */
+    reps = 1000000 / n;
+    if (reps > ops)
+	reps = ops;
+    if (reps < NB_MAX / 2)
+	reps = NB_MAX / 2;
+
+    if (!bench_begin(&b, "link_break", n, reps))
+	return;
+
+    a = gen_addrs(n);
+    neighbors_insert();
+
+    for (j = 0; j < n; j++) {
+	rt = rt_table_insert(a[j], nb[j % NB_MAX], 2 + j % 8, 1,
+			     ACTIVE_ROUTE_TIMEOUT, VALID, 0, 1);
+	precursor_add(rt, nb[(j + 1) % NB_MAX], 1);
+	precursor_add(rt, nb[(j + 2) % NB_MAX], 1);
+    }
+
+    for (i = 0; i < reps; i++) {
+	int k = i % NB_MAX;
+	rt_table_t *nb_rt = rt_table_find(nb[k]);
+
+	vclock_advance(1000);
+	BENCH_OP(&b, neighbor_link_break(nb_rt));
+
+	/* The neighbor comes back with all its routes */
+	rt_table_update(nb_rt, nb[k], 1, nb_rt->dest_seqno + 1,
+			ACTIVE_ROUTE_TIMEOUT, VALID, 0);
+	for (j = k; j < n; j += NB_MAX) {
+	    rt = rt_table_find(a[j]);
+	    rt_table_update(rt, nb[k], 2 + j % 8, rt->dest_seqno + 1,
+			    ACTIVE_ROUTE_TIMEOUT, VALID, 0);
+	    precursor_add(rt, nb[(j + 1) % NB_MAX], 1);
+	    precursor_add(rt, nb[(j + 2) % NB_MAX], 1);
+	}
+    }
+    bench_end(&b);
+
+    free(a);
+    state_flush();
+}
+
+static void usage(char *name)
+{
+    fprintf(stderr, "Usage: %s [-b NAME] [-n N,N,..] [-o OPS] [-s SEED]\n\n"
+	    "-b NAME  Only run benchmarks whose name starts with NAME.\n"
+	    "-n N,..  Table and queue sizes, default 1000,10000.\n"
+	    "-o OPS   Operations per benchmark, default 100000.\n"
+	    "-s SEED  Seed for the address generator, default 1.\n", name);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    char sizes_def[] = "1000,10000", *sizes = sizes_def, *s;
+    static int rates[] = { 100, 1000, 10000 };
+    static int precs[] = { 2, 8, 32 };
+    unsigned long ops = 100000;
+    int opt, i;
+
+    progname = "aodv-bench";
+
+    while ((opt = getopt(argc, argv, "b:n:o:s:h")) != -1) {
+	switch (opt) {
+	case 'b':
+	    only = optarg;
+	    break;
+	case 'n':
+	    sizes = optarg;
+	    break;
+	case 'o':
+	    ops = strtoul(optarg, NULL, 0);
+	    break;
+	case 's':
+	    seed = strtoul(optarg, NULL, 0);
+	    if (!seed)
+		seed = 1;
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    }
+    if (ops < RREQ_COPIES)
+	usage(argv[0]);
+
+    /* A single interface, as in aodv-replay. Only warnings are logged
+       and rate limiting is off, so that every RREQ is processed. */
+    debug = 1;
+    log_level = LOG_WARNING;
+    ratelimit = 0;
+    wait_on_reboot = 0;
+    bpf_rreq_filter = 0;
+
+    vclock.tv_sec = 1000000;
+    bcast.s_addr = AODV_BROADCAST;
+    for (i = 0; i < NB_MAX; i++)
+	nb[i].s_addr = htonl(0x0afffe01 + i);
+
+    this_host.seqno = 1;
+    this_host.nif = 1;
+    DEV_NR(0).enabled = 0;
+    DEV_NR(0).sock = -1;
+    DEV_NR(0).ifindex = 1;
+    strcpy(DEV_NR(0).ifname, "bench0");
+    DEV_NR(0).ipaddr.s_addr = htonl(0x0affff01);
+    DEV_NR(0).broadcast.s_addr = AODV_BROADCAST;
+    dev_indices[0] = 1;
+
+    rt_table_init();
+    seek_list_init();
+    rreq_blacklist_init();
+    aodv_socket_init();
+    DEV_NR(0).enabled = 1;
+
+    bench_calibrate();
+
+    printf("# bench\tn\tops\tns/op\tallocs/op\tp99_ns\n");
+
+    for (s = strtok(sizes, ","); s; s = strtok(NULL, ",")) {
+	int n = atoi(s);
+
+	unsigned long n_ops = ops;
+
+	if (n <= 0)
+	    usage(argv[0]);
+
+	/* Most operations here are linear in n, so fewer are done on
+	   large tables to keep the run time down. */
+	if (n_ops > BENCH_WORK / n)
+	    n_ops = BENCH_WORK / n > 1000 ? BENCH_WORK / n : 1000;
+
+	if (bench_want("rt_"))
+	    bench_rt(n, n_ops);
+	if (bench_want("timer_"))
+	    bench_timer(n, n_ops);
+	if (bench_want("link_break"))
+	    bench_link_break(n, n_ops);
+    }
+    for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+	if (bench_want("rreq_"))
+	    bench_rreq(rates[i], ops);
+    for (i = 0; i < sizeof(precs) / sizeof(precs[0]); i++)
+	if (bench_want("precursor_add"))
+	    bench_precursor(precs[i], ops);
+
+    return 0;
+}
@@ -41,15 +41,24 @@
 #include "params.h"
 #include "timer_queue.h"
 #include "routing_table.h"
+#include "seek_list.h"
+#include "passive.h"
 #endif
 
 #ifndef NS_PORT
 extern int log_to_file, rt_log_interval;
 extern char *progname;
+extern int rreq_fwd_counter;
+extern struct rreq_fwd_stats rreq_fwd_stats;
+extern struct disc_stats disc_stats;
+extern struct disc_lat disc_lat;
+extern int passive_learning, adaptive_hello;
+extern u_int32_t hello_ival;
 int log_file_fd = -1;
 int log_rt_fd = -1;
 int log_nmsgs = 0;
 int debug = 0;
+int log_level = LOG_DEBUG;
 struct timer rt_log_timer;
 #endif
 
@@ -59,19 +68,26 @@ void NS_CLASS log_init()
 /* NS_PORT: Log filename is prefix + IP address + suffix */
 #ifdef NS_PORT
 
-    char AODV_LOG_PATH[strlen(AODV_LOG_PATH_PREFIX) +
+    char AODV_LOG_PATH[strlen(log_prefix) +
 		       strlen(AODV_LOG_PATH_SUFFIX) + 16];
-    char AODV_RT_LOG_PATH[strlen(AODV_LOG_PATH_PREFIX) +
+    char AODV_RT_LOG_PATH[strlen(log_prefix) +
 			  strlen(AODV_RT_LOG_PATH_SUFFIX) + 16];
 
 
-    sprintf(AODV_LOG_PATH, "%s%d%s", AODV_LOG_PATH_PREFIX, node_id,
+    sprintf(AODV_LOG_PATH, "%s%d%s", log_prefix, node_id,
 	    AODV_LOG_PATH_SUFFIX);
-    sprintf(AODV_RT_LOG_PATH, "%s%d%s", AODV_LOG_PATH_PREFIX, node_id,
+    sprintf(AODV_RT_LOG_PATH, "%s%d%s", log_prefix, node_id,
 	    AODV_RT_LOG_PATH_SUFFIX);
 
 #endif				/* NS_PORT */
 
+    /* Without a log file or stdout only syslog is left, and it only
+       takes LOG_NOTICE or worse. Never filter out fatal errors. */
+    if (!debug && !log_to_file && log_level > LOG_NOTICE)
+	log_level = LOG_NOTICE;
+    if (log_level < LOG_ERR)
+	log_level = LOG_ERR;
+
     if (log_to_file) {
 	if ((log_file_fd =
 	     open(AODV_LOG_PATH, O_RDWR | O_CREAT | O_TRUNC,
@@ -262,6 +278,9 @@ void NS_CLASS log_pkt_fields(AODV_msg * msg)
     RERR *rerr;
     struct in_addr dest, orig;
 
+    if (log_level < LOG_DEBUG)
+	return;
+
     switch (msg->type) {
     case AODV_RREQ:
 	rreq = (RREQ *) msg;
@@ -296,18 +315,13 @@ void NS_CLASS log_pkt_fields(AODV_msg * msg)
 
 char *NS_CLASS rt_flags_to_str(u_int16_t flags)
 {
-    static char buf[5];
-    int len = 0;
+    static char buf[sizeof(RT_FLAG_CHARS)];
+    int i, len = 0;
     char *str;
 
-    if (flags & RT_UNIDIR)
-	buf[len++] = 'U';
-    if (flags & RT_REPAIR)
-	buf[len++] = 'R';
-    if (flags & RT_INET_DEST)
-	buf[len++] = 'I';
-    if (flags & RT_GATEWAY)
-	buf[len++] = 'G';
+    for (i = 0; RT_FLAG_CHARS[i]; i++)
+	if ((flags & (1 << i)) && RT_FLAG_CHARS[i] != ' ')
+	    buf[len++] = RT_FLAG_CHARS[i];
     buf[len] = '\0';
 
     str = buf;
@@ -365,6 +379,39 @@ void NS_CLASS print_rt_table(void *arg)
 		time->tm_hour, time->tm_min, time->tm_sec, now.tv_usec / 1000,
 		devs_ip_to_str(), this_host.seqno, rt_tbl.num_entries,
 		rt_tbl.num_active);
+    if (rreq_fwd_counter)
+	len +=
+	    sprintf(rt_buf + len,
+		    "# RREQ rebroadcasts delayed/sent/suppressed: %u/%u/%u\n",
+		    rreq_fwd_stats.scheduled, rreq_fwd_stats.sent,
+		    rreq_fwd_stats.suppressed);
+    len +=
+	sprintf(rt_buf + len,
+		"# Discoveries started/first try/predicted/failed/cached:"
+		" %u/%u/%u/%u/%u node traversal time: %d ms\n",
+		disc_stats.started, disc_stats.first_try,
+		disc_stats.predicted, disc_stats.failed, disc_stats.cached,
+		NODE_TRAVERSAL_TIME);
+    len +=
+	sprintf(rt_buf + len,
+		"# Discovery msecs p50/p99 first try: %ld/%ld retried: %ld/%ld"
+		" failed: %ld/%ld\n",
+		seek_list_lat_pct(disc_lat.outcome[DISC_FIRST_TRY], 50),
+		seek_list_lat_pct(disc_lat.outcome[DISC_FIRST_TRY], 99),
+		seek_list_lat_pct(disc_lat.outcome[DISC_RETRIED], 50),
+		seek_list_lat_pct(disc_lat.outcome[DISC_RETRIED], 99),
+		seek_list_lat_pct(disc_lat.outcome[DISC_FAILED], 50),
+		seek_list_lat_pct(disc_lat.outcome[DISC_FAILED], 99));
+    if (adaptive_hello)
+	len += sprintf(rt_buf + len, "# Hello interval: %u ms\n", hello_ival);
+#ifndef NS_PORT
+    if (passive_learning)
+	len +=
+	    sprintf(rt_buf + len,
+		    "# Overheard routes learned/used/seeded: %u/%u/%u\n",
+		    passive_stats.learned, passive_stats.used,
+		    passive_stats.seeded);
+#endif
     len +=
 	sprintf(rt_buf + len,
 		"%-15s %-15s %-3s %-3s %-5s %-6s %-5s %-5s %-15s\n",
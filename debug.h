@@ -24,6 +24,7 @@
 
 #ifndef NS_PORT
 extern int debug;
+extern int log_level;
 #endif
 
 #ifndef NS_NO_DECLARATIONS
@@ -48,10 +49,24 @@ char *state_to_str(u_int8_t state);
 #endif				/* NS_NO_DECLARATIONS */
 
 #ifndef NS_NO_GLOBALS
+/* Messages less severe than DEBUG_MIN_LEVEL are compiled out, e.g.
+   "make XDEFS='-DDEBUG -DDEBUG_MIN_LEVEL=LOG_INFO'". The rest are
+   checked against log_level before any argument is evaluated. Do not
+   go below LOG_ERR, since DEBUG(LOG_ERR, ...) exits the daemon. */
+#ifndef DEBUG_MIN_LEVEL
+#define DEBUG_MIN_LEVEL LOG_DEBUG
+#endif
+
 #ifdef DEBUG
 #undef DEBUG
+#if DEBUG_MIN_LEVEL >= LOG_DEBUG
 #define DEBUG_OUTPUT
-#define DEBUG(l, s, args...) alog(l, s, __FUNCTION__, ## args)
+#endif
+#define DEBUG(l, s, args...)						\
+	do {								\
+		if ((l) <= DEBUG_MIN_LEVEL && (l) <= log_level)		\
+			alog(l, s, __FUNCTION__, ## args);		\
+	} while (0)
 #else
 #define DEBUG(l, s, args...)
 #endif
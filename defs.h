@@ -71,6 +71,7 @@
 #else
 #define AODV_LOG_PATH "/var/log/aodvd.log"
 #define AODV_RT_LOG_PATH "/var/log/aodvd.rtlog"
+#define AODV_RT_JOURNAL_PATH "/var/log/aodvd.rtj"
 #endif				/* NS_PORT */
 
 #define max(A,B) ( (A) > (B) ? (A):(B))
@@ -214,6 +215,10 @@ typedef AODV_msg hdr_aodvuu;	// Name convention for headers
 #define RREP_HELLO_INTERVAL_EXT 2
 #define RREP_HELLO_NEIGHBOR_SET_EXT 3
 #define RREP_INET_DEST_EXT 4
+#define RREQ_MDEST_EXT 5
+#define RREQ_METRIC_EXT 6
+#define RREP_METRIC_EXT 6
+#define RREP_HELLO_NEIGHBOR_BLOOM_EXT 7
 
 /* An generic AODV extensions header */
 typedef struct {
@@ -0,0 +1,123 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+
+#include "defs.h"
+#include "debug.h"
+#include "evlog.h"
+
+int evlog_enabled = 0;
+
+static struct evlog_hdr *evlog_hdr = NULL;
+static struct evlog_rec *evlog_recs = NULL;
+static size_t evlog_size = 0;
+
+int evlog_init(char *path, unsigned int nrecs)
+{
+    struct evlog_hdr *hdr;
+    struct stat st;
+    int fd;
+
+    evlog_size = EVLOG_HDR_SIZE + nrecs * sizeof(struct evlog_rec);
+
+    fd = open(path, O_RDWR | O_CREAT, S_IROTH | S_IWUSR | S_IRUSR | S_IRGRP);
+
+    if (fd < 0) {
+	alog(LOG_WARNING, errno, __FUNCTION__, "Could not open %s", path);
+	return -1;
+    }
+
+    if (fstat(fd, &st) < 0 || ftruncate(fd, evlog_size) < 0) {
+	alog(LOG_WARNING, errno, __FUNCTION__, "Could not size %s", path);
+	close(fd);
+	return -1;
+    }
+
+    hdr = mmap(NULL, evlog_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (hdr == MAP_FAILED) {
+	alog(LOG_WARNING, errno, __FUNCTION__, "Could not map %s", path);
+	return -1;
+    }
+
+    /* Keep the records of an earlier run (which may have crashed) if
+       the ring has the same layout, otherwise start over. */
+    if (st.st_size != (off_t) evlog_size ||
+	memcmp(hdr->magic, EVLOG_MAGIC, sizeof(EVLOG_MAGIC)) != 0 ||
+	hdr->version != EVLOG_VERSION ||
+	hdr->rec_size != sizeof(struct evlog_rec) || hdr->nrecs != nrecs) {
+	memset(hdr, 0, EVLOG_HDR_SIZE);
+	memcpy(hdr->magic, EVLOG_MAGIC, sizeof(EVLOG_MAGIC));
+	hdr->version = EVLOG_VERSION;
+	hdr->rec_size = sizeof(struct evlog_rec);
+	hdr->nrecs = nrecs;
+    }
+
+    evlog_hdr = hdr;
+    evlog_recs = (struct evlog_rec *) ((char *) hdr + EVLOG_HDR_SIZE);
+    evlog_enabled = 1;
+
+    evlog_write(EV_START, getpid(), 0, 0, 0);
+
+    return 0;
+}
+
+void evlog_write(u_int16_t event, u_int32_t a0, u_int32_t a1,
+		 u_int32_t a2, u_int32_t a3)
+{
+    struct evlog_rec *rec;
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+
+    rec = &evlog_recs[evlog_hdr->head % evlog_hdr->nrecs];
+    rec->sec = now.tv_sec;
+    rec->usec = now.tv_usec;
+    rec->event = event;
+    rec->arg[0] = a0;
+    rec->arg[1] = a1;
+    rec->arg[2] = a2;
+    rec->arg[3] = a3;
+
+    /* The record must be complete before a reader can see it */
+    __asm__ __volatile__("":::"memory");
+
+    evlog_hdr->head++;
+}
+
+void evlog_cleanup(void)
+{
+    if (!evlog_hdr)
+	return;
+
+    msync(evlog_hdr, evlog_size, MS_ASYNC);
+    munmap(evlog_hdr, evlog_size);
+
+    evlog_hdr = NULL;
+    evlog_recs = NULL;
+    evlog_enabled = 0;
+}
@@ -0,0 +1,95 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+#ifndef _EVLOG_H
+#define _EVLOG_H
+
+/* Binary event log.
+ *
+ * Fixed size records are written into a memory mapped ring file, with
+ * no formatting done by the daemon. Since the file is a shared mapping
+ * the records survive a crash of the daemon. Use aodv-logdump to turn
+ * the file into the same text format as the normal log. */
+
+#define EVLOG_MAGIC "AODVEVL"
+#define EVLOG_VERSION 1
+#define EVLOG_HDR_SIZE 64	/* Records start at this offset */
+#define EVLOG_NRECS 8192	/* Default ring size, 256 KB */
+#define AODV_EVLOG_PATH "/var/log/aodvd.evlog"	/* Default file */
+#define EVLOG_NARGS 4
+
+/* Event ids. The text for each one is in aodv-logdump.c, so keep the
+   two in sync and only ever append to this list. */
+enum {
+    EV_START = 1,
+    EV_RREQ_RECV,
+    EV_RREQ_SEND,
+    EV_RREQ_FWD,
+    EV_RREP_RECV,
+    EV_RREP_SEND,
+    EV_RREP_FWD,
+    EV_RERR_RECV,
+    EV_RERR_SEND,
+    EV_HELLO_RECV,
+    EV_NEIGHBOR_ADD,
+    EV_LINK_BREAK,
+    EV_RT_INSERT,
+    EV_RT_INVALIDATE,
+    EV_NO_ROUTE,
+    EV_MAX
+};
+
+struct evlog_hdr {
+    char magic[8];
+    u_int32_t version;
+    u_int32_t rec_size;
+    u_int32_t nrecs;
+    u_int32_t head;		/* Records written, next slot is head % nrecs */
+};
+
+/* Addresses are stored in network byte order, as is */
+struct evlog_rec {
+    u_int32_t sec;
+    u_int32_t usec;
+    u_int16_t event;
+    u_int16_t pad;
+    u_int32_t arg[EVLOG_NARGS];
+    u_int32_t pad2;
+};
+
+#ifdef NS_PORT
+#define EVLOG(ev, a0, a1, a2, a3)
+#else
+extern int evlog_enabled;
+
+int evlog_init(char *path, unsigned int nrecs);
+void evlog_write(u_int16_t event, u_int32_t a0, u_int32_t a1,
+		 u_int32_t a2, u_int32_t a3);
+void evlog_cleanup(void);
+
+#define EVLOG(ev, a0, a1, a2, a3)					\
+	do {								\
+		if (evlog_enabled)					\
+			evlog_write(ev, a0, a1, a2, a3);		\
+	} while (0)
+#endif				/* NS_PORT */
+
+#endif				/* _EVLOG_H */
@@ -47,6 +47,9 @@ int list_add(list_t * head, list_t * le);
 #define list_foreach(curr, head) \
         for (curr = (head)->next; curr != (head); curr = curr->next)
 
+#define list_foreach_reverse(curr, head) \
+        for (curr = (head)->prev; curr != (head); curr = curr->prev)
+
 #define list_foreach_safe(pos, tmp, head) \
         for (pos = (head)->next, tmp = pos->next; pos != (head); \
                 pos = tmp, tmp = pos->next)
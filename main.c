@@ -41,6 +41,13 @@
 #include "routing_table.h"
 #include "aodv_hello.h"
 #include "nl.h"
+#include "seek_list.h"
+#include "aodv_rreq.h"
+#include "passive.h"
+#include "evlog.h"
+#include "rtjournal.h"
+#include "stats.h"
+#include "upath.h"
 
 #ifdef LLFEEDBACK
 #include "llf.h"
@@ -63,12 +70,27 @@ int wait_on_reboot = 1;
 int qual_threshold = 0;
 int llfeedback = 0;
 int gw_prefix = 1;
+int bpf_rreq_filter = 1;	/* In-kernel duplicate RREQ filtering */
+int rerr_agg_window = 0;	/* msecs to aggregate RERRs, 0=off */
+int multipath = 0;		/* Keep alternate next hops (AOMDV style) */
+int rreq_fwd_counter = 0;	/* Copies that suppress a RREQ rebroadcast, 0=off */
+int rreq_fwd_adaptive = 0;	/* Adapt the above to the neighbor count */
+int rreq_batch_window = 0;	/* msecs to batch route discoveries, 0=off */
+int passive_learning = 0;	/* Learn routes from overheard RREPs */
+int event_log = 0;		/* Binary event log, see evlog.c */
+int rt_journal_interval = 0;	/* Secs between journal snapshots */
+int shm_stats = 0;		/* Publish statistics in shared memory */
+int etx_metric = 0;		/* Prefer routes by ETX over hop count */
+int adaptive_hello = 0;		/* Adapt the hello interval to churn */
+int preemptive_repair = 0;	/* Replace routes over degrading links */
+int userspace_path = 0;		/* Data path through a tun device, no kaodv */
 struct timer worb_timer;	/* Wait on reboot timer */
 
 /* Dynamic configuration values */
 int active_route_timeout = ACTIVE_ROUTE_TIMEOUT_HELLO;
 int ttl_start = TTL_START_HELLO;
 int delete_period = DELETE_PERIOD_HELLO;
+int node_traversal_time = NODE_TRAVERSAL_TIME_DEF;
 
 static void cleanup();
 
@@ -89,8 +111,23 @@ struct option longopts[] = {
     {"no-worb", no_argument, NULL, 'D'},
     {"local-repair", no_argument, NULL, 'L'},
     {"rate-limit", no_argument, NULL, 'R'},
+    {"log-level", required_argument, NULL, 'v'},
     {"version", no_argument, NULL, 'V'},
     {"llfeedback", no_argument, NULL, 'f'},
+    {"bpf-filter", no_argument, NULL, 'b'},
+    {"rerr-window", required_argument, NULL, 'a'},
+    {"multipath", no_argument, NULL, 'm'},
+    {"counter-fwd", required_argument, NULL, 'c'},
+    {"adaptive-counter", no_argument, NULL, 'C'},
+    {"rreq-batch", required_argument, NULL, 'B'},
+    {"passive", no_argument, NULL, 'p'},
+    {"etx", no_argument, NULL, 'e'},
+    {"adaptive-hello", no_argument, NULL, 'A'},
+    {"preemptive", no_argument, NULL, 'P'},
+    {"event-log", no_argument, NULL, 'E'},
+    {"rt-journal", required_argument, NULL, 'J'},
+    {"stats", no_argument, NULL, 'S'},
+    {"userspace", no_argument, NULL, 'U'},
     {0}
 };
 
@@ -102,28 +139,46 @@ void usage(int status)
     }
 
     printf
-	("\nUsage: %s [-dghjlouwxLDRV] [-i if0,if1,..] [-r N] [-n N] [-q THR]\n\n"
+	("\nUsage: %s [-bdeghjlmopuwxACEDLPRSUV] [-i if0,if1,..] [-r N] [-J N] [-n N] [-v N] [-q THR] [-a N] [-c N] [-B N]\n\n"
+	 "-a, --rerr-window       Aggregate RERRs for N msecs before sending (default 0=off).\n"
+	 "-A, --adaptive-hello    Adapt the HELLO interval (%d-%d ms) to neighbor changes.\n"
+	 "-b, --bpf-filter        Toggle in-kernel filtering of duplicate RREQs (default ON).\n"
+	 "-B, --rreq-batch        Send route discoveries started within N msecs in one RREQ.\n"
+	 "-c, --counter-fwd       Delay RREQ rebroadcasts and skip them after hearing N copies.\n"
+	 "-C, --adaptive-counter  Never skip RREQ rebroadcasts when there are few neighbors.\n"
 	 "-d, --daemon            Daemon mode, i.e. detach from the console.\n"
+	 "-e, --etx               Choose routes by ETX measured from hellos.\n"
+	 "-E, --event-log         Write a binary event log to %s (see aodv-logdump).\n"
 	 "-g, --force-gratuitous  Force the gratuitous flag to be set on all RREQ's.\n"
 	 "-h, --help              This information.\n"
 	 "-i, --interface         Network interfaces to attach to. Defaults to first\n"
 	 "                        wireless interface.\n"
 	 "-j, --hello-jitter      Toggle hello jittering (default ON).\n"
 	 "-l, --log               Log debug output to %s.\n"
+	 "-m, --multipath         Keep loop free alternate routes for fast failover.\n"
 	 "-o, --opt-hellos        Send HELLOs only when forwarding data (experimental).\n"
+	 "-p, --passive           Learn routes from overheard RREPs (promiscuous mode).\n"
 	 "-r, --log-rt-table      Log routing table to %s every N secs.\n"
+	 "-J, --rt-journal        Journal routing table changes to %s, with a full\n"
+	 "                        snapshot every N secs (see aodv-rtdump).\n"
 	 "-n, --n-hellos          Receive N hellos from host before treating as neighbor.\n"
 	 "-u, --unidir-hack       Detect and avoid unidirectional links (experimental).\n"
 	 "-w, --gateway-mode      Enable experimental Internet gateway support.\n"
 	 "-x, --no-expanding-ring Disable expanding ring search for RREQs.\n"
 	 "-D, --no-worb           Disable 15 seconds wait on reboot delay.\n"
 	 "-L, --local-repair      Enable local repair.\n"
+	 "-P, --preemptive        Look for new routes when a link starts losing HELLOs.\n"
 	 "-f, --llfeedback        Enable link layer feedback.\n"
 	 "-R, --rate-limit        Toggle rate limiting of RREQs and RERRs (default ON).\n"
+	 "-S, --stats             Publish live statistics in shared memory (see aodv-stat).\n"
+	 "-U, --userspace         Forward data through a tun device instead of kaodv.\n"
 	 "-q, --quality-threshold Set a minimum signal quality threshold for control packets.\n"
+	 "-v, --log-level N       Only log messages of syslog level N or lower (3-7).\n"
 	 "-V, --version           Show version.\n\n"
 	 "Erik Nordstrm, <erik.nordstrom@it.uu.se>\n\n",
-	 progname, AODV_LOG_PATH, AODV_RT_LOG_PATH);
+	 progname, HELLO_INTERVAL_MIN, HELLO_INTERVAL_MAX,
+	 AODV_EVLOG_PATH, AODV_LOG_PATH, AODV_RT_LOG_PATH,
+	 AODV_RT_JOURNAL_PATH);
 
     exit(status);
 }
@@ -257,7 +312,7 @@ struct sockaddr_in *get_if_info(char *ifname, int type)
 
 /* This will limit the number of handler functions we can have for
    sockets and file descriptors and so on... */
-#define CALLBACK_FUNCS 5
+#define CALLBACK_FUNCS 8
 static struct callback {
     int fd;
     callback_func_t func;
@@ -453,7 +508,8 @@ void host_init(char *ifname)
     close(if_sock);
 
     /* Load kernel modules */
-    load_modules(ifnames);
+    if (!userspace_path)
+	load_modules(ifnames);
 
     /* Enable IP forwarding and set other kernel options... */
     if (set_kernel_options() < 0) {
@@ -524,7 +580,7 @@ int main(int argc, char **argv)
     while (1) {
 	int opt;
 
-	opt = getopt_long(argc, argv, "i:fjln:dghoq:r:s:uwxDLRV", longopts, 0);
+	opt = getopt_long(argc, argv, "a:c:i:B:bdefghjlmn:opq:r:s:uv:wxACDEJ:LPRSUV", longopts, 0);
 
 	if (opt == EOF)
 	    break;
@@ -532,6 +588,46 @@ int main(int argc, char **argv)
 	switch (opt) {
 	case 0:
 	    break;
+	case 'a':
+	    if (optarg && isdigit(*optarg))
+		rerr_agg_window = atoi(optarg);
+	    break;
+	case 'b':
+	    bpf_rreq_filter = !bpf_rreq_filter;
+	    break;
+	case 'B':
+	    if (optarg && isdigit(*optarg))
+		rreq_batch_window = atoi(optarg);
+	    break;
+	case 'p':
+	    passive_learning = 1;
+	    break;
+	case 'e':
+	    etx_metric = 1;
+	    break;
+	case 'E':
+	    event_log = 1;
+	    break;
+	case 'S':
+	    shm_stats = 1;
+	    break;
+	case 'J':
+	    if (optarg && isdigit(*optarg))
+		rt_journal_interval = atoi(optarg);
+	    break;
+	case 'A':
+	    adaptive_hello = 1;
+	    break;
+	case 'P':
+	    preemptive_repair = 1;
+	    break;
+	case 'c':
+	    if (optarg && isdigit(*optarg))
+		rreq_fwd_counter = atoi(optarg);
+	    break;
+	case 'C':
+	    rreq_fwd_adaptive = !rreq_fwd_adaptive;
+	    break;
 	case 'd':
 	    debug = 0;
 	    daemonize = 1;
@@ -552,6 +648,9 @@ int main(int argc, char **argv)
 	case 'l':
 	    log_to_file = !log_to_file;
 	    break;
+	case 'm':
+	    multipath = !multipath;
+	    break;
 	case 'n':
 	    if (optarg && isdigit(*optarg)) {
 		receive_n_hellos = atoi(optarg);
@@ -575,6 +674,9 @@ int main(int argc, char **argv)
 	case 'u':
 	    unidir_hack = !unidir_hack;
 	    break;
+	case 'U':
+	    userspace_path = !userspace_path;
+	    break;
 	case 'w':
 	    internet_gw_mode = !internet_gw_mode;
 	    break;
@@ -590,6 +692,10 @@ int main(int argc, char **argv)
 	case 'R':
 	    ratelimit = !ratelimit;
 	    break;
+	case 'v':
+	    if (optarg && isdigit(*optarg))
+		log_level = atoi(optarg);
+	    break;
 	case 'V':
 	    printf
 		("\nAODV-UU v%s, %s  Uppsala University & Ericsson AB.\nAuthor: Erik Nordstrm, <erik.nordstrom@it.uu.se>\n\n",
@@ -603,6 +709,18 @@ int main(int argc, char **argv)
 	    usage(0);
 	}
     }
+    /* With multipath, duplicate RREQs carry alternate reverse paths,
+       and with ETX possibly better ones, so they must not be filtered
+       out in the kernel. */
+    if (multipath || etx_metric)
+	bpf_rreq_filter = 0;
+
+    /* Gateway tunneling is done by kaodv */
+    if (userspace_path && internet_gw_mode) {
+	fprintf(stderr, "Gateway mode needs kaodv, cannot be used with -U\n");
+	exit(1);
+    }
+
     /* Check that we are running as root */
     if (geteuid() != 0) {
 	fprintf(stderr, "must be root\n");
@@ -624,13 +742,25 @@ int main(int argc, char **argv)
 
     /* Initialize data structures and services... */
     rt_table_init();
+    seek_list_init();
+    rreq_blacklist_init();
     log_init();
+    if (event_log)
+	evlog_init(AODV_EVLOG_PATH, EVLOG_NRECS);
+    if (rt_journal_interval)
+	rtj_init(AODV_RT_JOURNAL_PATH, rt_journal_interval);
+    if (shm_stats)
+	stats_init();
     /*   packet_queue_init(); */
     host_init(ifname);
     /*   packet_input_init(); */
     nl_init();
     nl_send_conf_msg();
+    if (userspace_path)
+	upath_init();
     aodv_socket_init();
+    if (passive_learning && passive_init() < 0)
+	passive_learning = 0;
 #ifdef LLFEEDBACK
     if (llfeedback) {
 	llf_init();
@@ -692,13 +822,22 @@ int main(int argc, char **argv)
 static void cleanup(void)
 {
     DEBUG(LOG_DEBUG, 0, "CLEANING UP!");
+    rerr_agg_cleanup();
     rt_table_destroy();
     aodv_socket_cleanup();
+    if (passive_learning)
+	passive_cleanup();
 #ifdef LLFEEDBACK
     if (llfeedback)
 	llf_cleanup();
 #endif
+    stats_cleanup();
+    rtj_cleanup();
+    evlog_cleanup();
     log_cleanup();
+    if (userspace_path)
+	upath_cleanup();
     nl_cleanup();
-    remove_modules();
+    if (!userspace_path)
+	remove_modules();
 }
@@ -44,6 +44,8 @@
 #include "params.h"
 #include "aodv_socket.h"
 #include "aodv_rerr.h"
+#include "nl.h"
+#include "upath.h"
 
 /* Implements a Netlink socket communication channel to the kernel. Route
  * information and refresh messages are passed. */
@@ -81,6 +83,13 @@ void nl_init(void)
 	peer.nl_groups = 0;
 
 	memset(&aodvnl, 0, sizeof(struct nlsock));
+	aodvnl.sock = -1;
+
+	/* Without kaodv the data path is handled by upath.c and there
+	   is nobody to talk to on the AODV netlink socket. */
+	if (userspace_path)
+		goto rtnl;
+
 	aodvnl.seq = 0;
 	aodvnl.local.nl_family = AF_NETLINK;
 	aodvnl.local.nl_groups = AODVGRP_NOTIFY;
@@ -115,6 +124,7 @@ void nl_init(void)
 	if (attach_callback_func(aodvnl.sock, nl_kaodv_callback) < 0) {
 		alog(LOG_ERR, 0, __FUNCTION__, "Could not attach callback.");
 	}
+      rtnl:
 	/* This socket is the generic routing socket for adding and
 	   removing kernel routing table entries */
 
@@ -154,7 +164,8 @@ void nl_init(void)
 
 void nl_cleanup(void)
 {
-	close(aodvnl.sock);
+	if (aodvnl.sock >= 0)
+		close(aodvnl.sock);
 	close(rtnl.sock);
 }
 
@@ -264,49 +275,52 @@ static void nl_kaodv_callback(int sock)
 		    DEV_IFINDEX(m->ifindex).broadcast.s_addr)
 			return;
 
-		fwd_rt = rt_table_find(dest_addr);
-		rev_rt = rt_table_find(src_addr);
+		nl_send_rerr_unsolicited(dest_addr, src_addr, m->ifindex);
+		break;
+	default:
+		DEBUG(LOG_DEBUG, 0, "Got mesg type=%d\n", nlm->nlmsg_type);
+	}
 
-		do {
-			struct in_addr rerr_dest;
-			RERR *rerr;
+}
+/* Sends a RERR for a data packet from src_addr to dest_addr that we
+   were asked to forward but have no route for. */
+void nl_send_rerr_unsolicited(struct in_addr dest_addr,
+			      struct in_addr src_addr, int ifindex)
+{
+	struct in_addr rerr_dest;
+	rt_table_t *fwd_rt, *rev_rt;
+	RERR *rerr;
 
-			DEBUG(LOG_DEBUG, 0,
-			      "Sending RERR for unsolicited message from %s to dest %s",
-			      ip_to_str(src_addr), ip_to_str(dest_addr));
+	fwd_rt = rt_table_find(dest_addr);
+	rev_rt = rt_table_find(src_addr);
 
-			if (fwd_rt) {
-				rerr = rerr_create(0, fwd_rt->dest_addr,
-						   fwd_rt->dest_seqno);
+	DEBUG(LOG_DEBUG, 0,
+	      "Sending RERR for unsolicited message from %s to dest %s",
+	      ip_to_str(src_addr), ip_to_str(dest_addr));
 
-				rt_table_update_timeout(fwd_rt, DELETE_PERIOD);
-			} else
-				rerr = rerr_create(0, dest_addr, 0);
+	if (fwd_rt) {
+		rerr = rerr_create(0, fwd_rt->dest_addr, fwd_rt->dest_seqno);
 
-			/* Unicast the RERR to the source of the data transmission
-			 * if possible, otherwise we broadcast it. */
+		rt_table_update_timeout(fwd_rt, DELETE_PERIOD);
+	} else
+		rerr = rerr_create(0, dest_addr, 0);
 
-			if (rev_rt && rev_rt->state == VALID)
-				rerr_dest = rev_rt->next_hop;
-			else
-				rerr_dest.s_addr = AODV_BROADCAST;
+	/* Unicast the RERR to the source of the data transmission
+	 * if possible, otherwise we broadcast it. */
 
-			aodv_socket_send((AODV_msg *) rerr, rerr_dest,
-					 RERR_CALC_SIZE(rerr), 1,
-					 &DEV_IFINDEX(m->ifindex));
+	if (rev_rt && rev_rt->state == VALID)
+		rerr_dest = rev_rt->next_hop;
+	else
+		rerr_dest.s_addr = AODV_BROADCAST;
 
-			if (wait_on_reboot) {
-				DEBUG(LOG_DEBUG, 0,
-				      "Wait on reboot timer reset.");
-				timer_set_timeout(&worb_timer, DELETE_PERIOD);
-			}
-		} while (0);
-		break;
-	default:
-		DEBUG(LOG_DEBUG, 0, "Got mesg type=%d\n", nlm->nlmsg_type);
-	}
+	rerr_send(rerr, rerr_dest, &DEV_IFINDEX(ifindex));
 
+	if (wait_on_reboot) {
+		DEBUG(LOG_DEBUG, 0, "Wait on reboot timer reset.");
+		timer_set_timeout(&worb_timer, DELETE_PERIOD);
+	}
 }
+
 static void nl_rt_callback(int sock)
 {
 	int len, attrlen;
@@ -376,6 +390,7 @@ int prefix_length(int family, void *nm)
 	if (family == AF_INET) {
 		unsigned int tmp;
 		memcpy(&tmp, nm, sizeof(unsigned int));
+		tmp = ntohl(tmp);
 
 		while (tmp) {
 			tmp = tmp << 1;
@@ -490,6 +505,7 @@ int nl_send_add_route_msg(struct in_addr dest, struct in_addr next_hop,
 			  int metric, u_int32_t lifetime, int rt_flags,
 			  int ifindex)
 {
+	int ret;
 	struct {
 		struct nlmsghdr n;
 		struct kaodv_rt_msg m;
@@ -516,6 +532,15 @@ int nl_send_add_route_msg(struct in_addr dest, struct in_addr next_hop,
 	if (rt_flags & RT_REPAIR)
 		areq.m.flags |= KAODV_RT_REPAIR;
 
+	if (userspace_path) {
+		/* The kernel route must be in place before queued
+		   packets are handed back to the stack. */
+		ret = nl_kern_route(RTM_NEWROUTE, NLM_F_CREATE, AF_INET,
+				    ifindex, &dest, &next_hop, NULL, metric);
+		upath_route_added(dest);
+		return ret;
+	}
+
 	if (nl_send(&aodvnl, &areq.n) < 0) {
 		DEBUG(LOG_DEBUG, 0, "Failed to send netlink message");
 		return -1;
@@ -545,6 +570,10 @@ int nl_send_no_route_found_msg(struct in_addr dest)
 	DEBUG(LOG_DEBUG, 0, "Send NOROUTE_FOUND to kernel: %s",
 	      ip_to_str(dest));
 
+	if (userspace_path) {
+		upath_no_route(dest);
+		return 0;
+	}
 	return nl_send(&aodvnl, &areq.n);
 }
 
@@ -569,7 +598,7 @@ int nl_send_del_route_msg(struct in_addr dest, struct in_addr next_hop, int metr
 	areq.m.time = 0;
 	areq.m.flags = 0;
 
-	if (nl_send(&aodvnl, &areq.n) < 0) {
+	if (!userspace_path && nl_send(&aodvnl, &areq.n) < 0) {
 		DEBUG(LOG_DEBUG, 0, "Failed to send netlink message");
 		return -1;
 	}
@@ -587,6 +616,9 @@ int nl_send_conf_msg(void)
 		kaodv_conf_msg_t cm;
 	} areq;
 
+	if (userspace_path)
+		return 0;
+
 	memset(&areq, 0, sizeof(areq));
 
 	areq.n.nlmsg_len = NLMSG_LENGTH(sizeof(kaodv_conf_msg_t));
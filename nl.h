@@ -33,5 +33,13 @@ int nl_send_del_route_msg(struct in_addr dest, struct in_addr next_hop, int metr
 
 int nl_send_no_route_found_msg(struct in_addr dest);
 int nl_send_conf_msg(void);
+int nl_kern_route(int action, int flags, int family,
+		  int index, struct in_addr *dst, struct in_addr *gw,
+		  struct in_addr *nm, int metric);
+void nl_send_rerr_unsolicited(struct in_addr dest_addr,
+			      struct in_addr src_addr, int ifindex);
+
+/* Route operations counted by nl_stub.c */
+extern unsigned long nl_stub_add, nl_stub_del, nl_stub_no_route;
 
 #endif
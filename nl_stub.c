@@ -0,0 +1,75 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* Netlink stubs for the offline tools (aodv-replay, aodv-bench). Route
+   changes are only counted, nothing is sent to the kernel. */
+
+#include "defs.h"
+#include "nl.h"
+
+unsigned long nl_stub_add, nl_stub_del, nl_stub_no_route;
+
+void nl_init(void)
+{
+}
+
+void nl_cleanup(void)
+{
+}
+
+int nl_send_add_route_msg(struct in_addr dest, struct in_addr next_hop,
+			  int metric, u_int32_t lifetime, int rt_flags,
+			  int ifindex)
+{
+    nl_stub_add++;
+    return 0;
+}
+
+int nl_send_del_route_msg(struct in_addr dest, struct in_addr next_hop,
+			  int metric)
+{
+    nl_stub_del++;
+    return 0;
+}
+
+int nl_send_no_route_found_msg(struct in_addr dest)
+{
+    nl_stub_no_route++;
+    return 0;
+}
+
+int nl_send_conf_msg(void)
+{
+    return 0;
+}
+
+int nl_kern_route(int action, int flags, int family,
+		  int index, struct in_addr *dst, struct in_addr *gw,
+		  struct in_addr *nm, int metric)
+{
+    return 0;
+}
+
+void nl_send_rerr_unsolicited(struct in_addr dest_addr,
+			      struct in_addr src_addr, int ifindex)
+{
+}
@@ -94,23 +94,38 @@ NS_CLASS AODVUU(nsaddr_t id) : Agent(PT_AODVUU), ifindex(NS_IFINDEX),
 	bind("hello_jittering_", &hello_jittering);
 	bind("wait_on_reboot_", &wait_on_reboot);
 	bind("debug_", &debug);
+	bind("log_level_", &log_level);
 	bind("rt_log_interval_", &rt_log_interval);	// Note: in milliseconds!
 	bind("log_to_file_", &log_to_file);
 	bind("optimized_hellos_", &optimized_hellos);
 	bind("ratelimit_", &ratelimit);
 	bind("llfeedback_", &llfeedback);
 	bind("internet_gw_mode_", &internet_gw_mode);
+	bind("multipath_", &multipath);
+	bind("rreq_fwd_counter_", &rreq_fwd_counter);
+	bind("rreq_fwd_adaptive_", &rreq_fwd_adaptive);
+	bind("rreq_batch_window_", &rreq_batch_window);
+	bind("etx_metric_", &etx_metric);
+	bind("adaptive_hello_", &adaptive_hello);
+	bind("preemptive_repair_", &preemptive_repair);
+	bind("rerr_agg_window_", &rerr_agg_window);
+	bind("ttl_start_", &ttl_start_opt);
+	bind("hello_interval_", &hello_interval_opt);
   
 	/* Other initializations follow */
 
 	/* From main.c */
 	progname = strdup("AODV-UU");
+	node_traversal_time = NODE_TRAVERSAL_TIME_DEF;
+	ntt_srtt = 0;
+	ntt_rttvar = 0;
 
 	/* From debug.c */
 	/* Note: log_nmsgs was never used anywhere */
 	log_nmsgs = 0;
 	log_file_fd = -1;
 	log_rt_fd = -1;
+	strcpy(log_prefix, AODV_LOG_PATH_PREFIX);
 
 	/* Set host parameters */
 	memset(&this_host, 0, sizeof(struct host_info));
@@ -144,8 +159,17 @@ NS_CLASS AODVUU(nsaddr_t id) : Agent(PT_AODVUU), ifindex(NS_IFINDEX),
 	dport() = RT_PORT;
 
 	INIT_LIST_HEAD(&rreq_records);
-	INIT_LIST_HEAD(&rreq_blacklist); 
-	INIT_LIST_HEAD(&seekhead);
+	memset(&rreq_fwd_stats, 0, sizeof(rreq_fwd_stats));
+	memset(&disc_stats, 0, sizeof(disc_stats));
+	memset(&disc_lat, 0, sizeof(disc_lat));
+	rreq_fwd_nb_cnt = 0;
+	rreq_fwd_nb_time.tv_sec = 0;
+	rreq_fwd_nb_time.tv_usec = 0;
+	rreq_batch_len = 0;
+	hello_churn = 0;
+	hello_ival = HELLO_INTERVAL;
+	INIT_LIST_HEAD(&ratel_queue);
+	INIT_LIST_HEAD(&rerr_aggs);
 	INIT_LIST_HEAD(&TQ);
 
 	/* Initialize data structures */
@@ -155,8 +179,12 @@ NS_CLASS AODVUU(nsaddr_t id) : Agent(PT_AODVUU), ifindex(NS_IFINDEX),
 	hello_timer.used = 0;
 	rt_log_timer.data = NULL;
 	rt_log_timer.used = 0;
+	rreq_batch_timer.data = NULL;
+	rreq_batch_timer.used = 0;
 	aodv_socket_init();
 	rt_table_init();
+	seek_list_init();
+	rreq_blacklist_init();
 	packet_queue_init();
 }
 
@@ -164,7 +192,9 @@ NS_CLASS AODVUU(nsaddr_t id) : Agent(PT_AODVUU), ifindex(NS_IFINDEX),
 /* Destructor for the AODV-UU routing agent */
 NS_CLASS ~ AODVUU()
 {
+	rerr_agg_cleanup();
 	rt_table_destroy();
+	aodv_socket_cleanup();
 	log_cleanup();
 }
 
@@ -240,6 +270,22 @@ void NS_CLASS interfaceQueue(nsaddr_t addr, int action)
 }
 
 
+/* Next hop of the valid route to dest, or -1 if there is none. Lets a
+   simulation inspect the routing tables of all nodes. */
+nsaddr_t NS_CLASS nextHop(nsaddr_t dest)
+{
+	struct in_addr dest_addr;
+	rt_table_t *rt;
+
+	dest_addr.s_addr = dest;
+	rt = rt_table_find(dest_addr);
+
+	if (!rt || rt->state != VALID)
+		return -1;
+
+	return (nsaddr_t) rt->next_hop.s_addr;
+}
+
 /* Called for packets whose delivery fails at the link layer */
 void NS_CLASS packetFailed(Packet *p)
 {
@@ -473,6 +519,16 @@ int NS_CLASS command(int argc, const char *const *argv)
 			DEV_NR(NS_DEV_NR).ipaddr.s_addr = Address::instance().str2addr(argv[2]);
 			return TCL_OK;
 		}
+		/* Log files are named <prefix><node id>.log, so that
+		   concurrent simulations can write to different places */
+		if (strcasecmp(argv[1], "log-prefix") == 0) {
+			if (strlen(argv[2]) >= sizeof(log_prefix)) {
+				fprintf(stderr, "AODVUU: log-prefix too long\n");
+				return TCL_ERROR;
+			}
+			strcpy(log_prefix, argv[2]);
+			return TCL_OK;
+		}
 		if((obj = TclObject::lookup(argv[2])) == 0) {
 			fprintf(stderr, "AODVUU: %s lookup of %s failed\n", argv[1], argv[2]);
 			return TCL_ERROR;
@@ -503,6 +559,9 @@ int NS_CLASS startAODVUUAgent()
 
 		log_init();
 
+		if (hello_interval_opt > 0)
+			hello_ival = hello_interval_opt;
+
 		/* Set up the wait-on-reboot timer */
 		if (wait_on_reboot) {
 			timer_init(&worb_timer, &NS_CLASS wait_on_reboot_timeout, &wait_on_reboot);
@@ -536,6 +595,12 @@ int NS_CLASS startAODVUUAgent()
 		DEBUG(LOG_DEBUG, 0, "ratelimit %s", ratelimit ? "ON" : "OFF");
 		DEBUG(LOG_DEBUG, 0, "llfeedback %s", llfeedback ? "ON" : "OFF");
 		DEBUG(LOG_DEBUG, 0, "internet_gw_mode %s", internet_gw_mode ? "ON" : "OFF");
+		DEBUG(LOG_DEBUG, 0, "multipath %s", multipath ? "ON" : "OFF");
+		DEBUG(LOG_DEBUG, 0, "rreq_fwd_counter %d", rreq_fwd_counter);
+		DEBUG(LOG_DEBUG, 0, "rreq_batch_window %d", rreq_batch_window);
+		DEBUG(LOG_DEBUG, 0, "etx_metric %s", etx_metric ? "ON" : "OFF");
+		DEBUG(LOG_DEBUG, 0, "adaptive_hello %s", adaptive_hello ? "ON" : "OFF");
+		DEBUG(LOG_DEBUG, 0, "preemptive_repair %s", preemptive_repair ? "ON" : "OFF");
 		if (llfeedback) {
 			active_route_timeout = ACTIVE_ROUTE_TIMEOUT_LLF;
 			ttl_start = TTL_START_LLF;
@@ -545,6 +610,8 @@ int NS_CLASS startAODVUUAgent()
 			ttl_start = TTL_START_HELLO;
 			delete_period = DELETE_PERIOD_HELLO;
 		}
+		if (ttl_start_opt > 0)
+			ttl_start = ttl_start_opt;
 
 		DEBUG(LOG_DEBUG, 0, "ACTIVE_ROUTE_TIMEOUT=%d", ACTIVE_ROUTE_TIMEOUT);
 		DEBUG(LOG_DEBUG, 0, "TTL_START=%d", TTL_START);
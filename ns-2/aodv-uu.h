@@ -72,6 +72,9 @@ class AODVUU;
 #include "../aodv_socket.h"
 #include "../aodv_timeout.h"
 #include "../debug.h"
+#include "../evlog.h"
+#include "../rtjournal.h"
+#include "../stats.h"
 #include "../routing_table.h"
 #include "../seek_list.h"
 #include "../locality.h"
@@ -115,6 +118,7 @@ public:
 	void recv(Packet *p, Handler *);
 	int command(int argc, const char *const *argv);
 	void packetFailed(Packet *p);
+	nsaddr_t nextHop(nsaddr_t dest);
  
 protected:
 	void interfaceQueue(nsaddr_t next_hop, int action);
@@ -201,32 +205,66 @@ protected:
 	int llfeedback;
 	char *progname;
 	int wait_on_reboot;
+	int rerr_agg_window;
+	int multipath;
+	int rreq_fwd_counter;
+	int rreq_fwd_adaptive;
+	int rreq_batch_window;
+	int etx_metric;
+	int adaptive_hello;
+	int preemptive_repair;
+	int ttl_start_opt;	/* Overrides TTL_START, 0 means default */
+	int hello_interval_opt;	/* Overrides HELLO_INTERVAL, 0 means default */
 	struct timer worb_timer;
   
 	/* Parameters that are dynamic configuration values: */
 	int active_route_timeout;
 	int ttl_start;
 	int delete_period;
+	int node_traversal_time;
 
 	/* From aodv_hello.c */
 	struct timer hello_timer;
+	int hello_churn;
+	u_int32_t hello_ival;
+
+	/* From aodv_rerr.c */
+	list_t rerr_aggs;
 
 	/* From aodv_rreq.c */
 	list_t rreq_records;
-	list_t rreq_blacklist;
+	struct rreq_fwd_stats rreq_fwd_stats;
+	int rreq_fwd_nb_cnt;
+	struct timeval rreq_fwd_nb_time;
+	list_t rreq_blacklist[RT_TABLESIZE];
+	struct in_addr rreq_batch[RREQ_MDEST_MAX + 1];
+	int rreq_batch_len;
+	struct timer rreq_batch_timer;
   
 	/* From seek_list.c */
-	list_t seekhead;
+	list_t seek_tbl[RT_TABLESIZE];
+	struct disc_hist disc_hist[DISC_HIST_SIZE];
+	struct disc_stats disc_stats;
+	struct disc_lat disc_lat;
+	long ntt_srtt;
+	long ntt_rttvar;
   
 	/* From aodv_socket.c */
 	char recv_buf[RECV_BUF_SIZE];
 	char send_buf[SEND_BUF_SIZE];
+	struct ratel_bucket rreq_bucket;
+	struct ratel_bucket rerr_bucket;
+	list_t ratel_queue;
+	int ratel_qlen;
+	struct timer ratel_timer;
 
 	/* From debug.c */
+	char log_prefix[256];	/* Set with the "log-prefix" command */
 	int log_file_fd;
 	int log_rt_fd;
 	int log_nmsgs;
 	int debug;
+	int log_level;
 	struct timer rt_log_timer;
 
 	/* From defs.h */
@@ -1191,3 +1191,14 @@ Agent/AODVUU set optimized_hellos_ 0
 Agent/AODVUU set ratelimit_ 1
 Agent/AODVUU set llfeedback_ 1
 Agent/AODVUU set internet_gw_mode_ 0
+Agent/AODVUU set multipath_ 0
+Agent/AODVUU set rreq_fwd_counter_ 0
+Agent/AODVUU set rreq_fwd_adaptive_ 0
+Agent/AODVUU set rreq_batch_window_ 0
+Agent/AODVUU set etx_metric_ 0
+Agent/AODVUU set adaptive_hello_ 0
+Agent/AODVUU set preemptive_repair_ 0
+Agent/AODVUU set rerr_agg_window_ 0
+Agent/AODVUU set ttl_start_ 0
+Agent/AODVUU set hello_interval_ 0
+Agent/AODVUU set log_level_ 7
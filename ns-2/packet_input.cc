@@ -175,8 +175,7 @@ void NS_CLASS processPacket(Packet * p)
 	    else
 		rerr_dest.s_addr = AODV_BROADCAST;
 
-	    aodv_socket_send((AODV_msg *) rerr, rerr_dest,
-			     RERR_CALC_SIZE(rerr), 1, &DEV_IFINDEX(ifindex));
+	    rerr_send(rerr, rerr_dest, &DEV_IFINDEX(ifindex));
 
 	    if (wait_on_reboot) {
 		DEBUG(LOG_DEBUG, 0, "Wait on reboot timer reset.");
@@ -31,6 +31,7 @@
 #define ACTIVE_ROUTE_TIMEOUT active_route_timeout
 #define TTL_START ttl_start
 #define DELETE_PERIOD delete_period
+#define NODE_TRAVERSAL_TIME node_traversal_time
 
 /* Settings for Link Layer Feedback */
 #define ACTIVE_ROUTE_TIMEOUT_LLF    10000
@@ -47,16 +48,23 @@
 /* If expanding ring search is used, BLACKLIST_TIMEOUT should be?: */
 #define BLACKLIST_TIMEOUT       RREQ_RETRIES * NET_TRAVERSAL_TIME + (TTL_THRESHOLD - TTL_START)/TTL_INCREMENT + 1 + RREQ_RETRIES
 #define HELLO_INTERVAL          1000
+#define HELLO_INTERVAL_MIN      250	/* Bounds for adaptive hellos */
+#define HELLO_INTERVAL_MAX      5000
 #define LOCAL_ADD_TTL           2
 #define MAX_REPAIR_TTL          3 * NET_DIAMETER / 10
 #define MY_ROUTE_TIMEOUT        2 * ACTIVE_ROUTE_TIMEOUT
 #define NET_DIAMETER            35
 #define NET_TRAVERSAL_TIME      2 * NODE_TRAVERSAL_TIME * NET_DIAMETER
 #define NEXT_HOP_WAIT           NODE_TRAVERSAL_TIME + 10
-#define NODE_TRAVERSAL_TIME     40
+#define NODE_TRAVERSAL_TIME_DEF 40	/* Until measured, see seek_list.c */
+#define NODE_TRAVERSAL_TIME_MIN 5
+#define NODE_TRAVERSAL_TIME_MAX 200
 #define PATH_DISCOVERY_TIME     2 * NET_TRAVERSAL_TIME
 #define RERR_RATELIMIT          10
 #define RING_TRAVERSAL_TIME     2 * NODE_TRAVERSAL_TIME * (TTL_VALUE + TIMEOUT_BUFFER)
+#define RREQ_FWD_DELAY          10	/* Max rebroadcast delay, see rreq_fwd_counter */
+#define RREQ_FWD_SPARSE         4	/* Never suppress with this few neighbors */
+#define RREQ_MDEST_MAX          8	/* Extra destinations in one RREQ */
 #define RREQ_RETRIES            2
 #define RREQ_RATELIMIT          10
 #define TIMEOUT_BUFFER          2
@@ -68,6 +76,7 @@
 extern int active_route_timeout;
 extern int ttl_start;
 extern int delete_period;
+extern int node_traversal_time;
 #endif
 
 #endif				/* _PARAMS_H */
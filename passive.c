@@ -0,0 +1,313 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* Passive route learning.
+ *
+ * On a shared channel a node hears many RREPs and RERRs that are not
+ * meant for it. With promiscuous learning turned on we capture those
+ * with a packet socket, and remember the advertised destinations
+ * through the node we heard them from in a small cache. The cache is
+ * only consulted when a route discovery starts, and a cached route is
+ * only installed if its sequence number is at least as fresh as what
+ * the routing table already knows. Installed routes are marked
+ * RT_PASSIVE, and answer RREQs only when strictly fresher than the
+ * sequence number asked for. The flag is cleared once a RREP for the
+ * destination confirms the route. RERRs, overheard or received,
+ * remove the entries they make stale. */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/udp.h>
+#include <net/ethernet.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+
+#include "defs.h"
+#include "debug.h"
+#include "params.h"
+#include "passive.h"
+#include "aodv_rrep.h"
+#include "aodv_rerr.h"
+
+static struct passive_entry passive_cache[PASSIVE_CACHE_SIZE];
+static int passive_sock = -1;
+
+struct passive_stats passive_stats;
+
+#define PASSIVE_BUFSIZE 2048
+
+/* Only accept AODV packets that were unicast to somebody else.
+   Broadcasts and packets for us reach the AODV sockets anyway. */
+static struct sock_filter passive_filter[] = {
+    BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OTHERHOST, 0, 8),
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 6),
+    BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),
+    BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 4, 0),
+    BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+    BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, AODV_PORT, 0, 1),
+    BPF_STMT(BPF_RET | BPF_K, PASSIVE_BUFSIZE),
+    BPF_STMT(BPF_RET | BPF_K, 0),
+};
+
+static inline struct passive_entry *passive_slot(struct in_addr dest_addr)
+{
+    return &passive_cache[hash_addr(&dest_addr) & PASSIVE_CACHE_MASK];
+}
+
+static int passive_fresh(struct passive_entry *pe)
+{
+    struct timeval now;
+
+    if (pe->dest_addr.s_addr == 0)
+	return 0;
+
+    gettimeofday(&now, NULL);
+
+    return timeval_diff(&now, &pe->time) < ACTIVE_ROUTE_TIMEOUT;
+}
+
+static void passive_learn(struct in_addr dest_addr, u_int32_t dest_seqno,
+			  u_int8_t hcnt, struct in_addr next_hop,
+			  unsigned int ifindex)
+{
+    struct passive_entry *pe = passive_slot(dest_addr);
+
+    if (dest_seqno == 0 || dest_addr.s_addr == DEV_IFINDEX(ifindex).ipaddr.s_addr)
+	return;
+
+    /* Keep what we have if it is fresher, or as fresh and shorter */
+    if (pe->dest_addr.s_addr == dest_addr.s_addr && passive_fresh(pe) &&
+	((int32_t) pe->dest_seqno > (int32_t) dest_seqno ||
+	 (pe->dest_seqno == dest_seqno && pe->hcnt <= hcnt)))
+	return;
+
+    pe->dest_addr = dest_addr;
+    pe->next_hop = next_hop;
+    pe->dest_seqno = dest_seqno;
+    pe->hcnt = hcnt;
+    pe->ifindex = ifindex;
+    gettimeofday(&pe->time, NULL);
+
+    passive_stats.learned++;
+
+    DEBUG(LOG_DEBUG, 0, "Overheard %s seqno=%u hcnt=%d via %s",
+	  ip_to_str(dest_addr), dest_seqno, hcnt, ip_to_str(next_hop));
+}
+
+void passive_forget(struct in_addr dest_addr, u_int32_t dest_seqno,
+		    struct in_addr sender)
+{
+    struct passive_entry *pe = passive_slot(dest_addr);
+
+    if (pe->dest_addr.s_addr != dest_addr.s_addr)
+	return;
+
+    /* The sender lost its route, or a newer seqno was invalidated */
+    if (pe->next_hop.s_addr == sender.s_addr ||
+	(int32_t) pe->dest_seqno <= (int32_t) dest_seqno)
+	memset(pe, 0, sizeof(struct passive_entry));
+}
+
+static void passive_callback(int fd)
+{
+    char buf[PASSIVE_BUFSIZE];
+    struct sockaddr_ll sll;
+    socklen_t sll_len = sizeof(sll);
+    struct iphdr *ip;
+    AODV_msg *aodv_msg;
+    struct in_addr sender, dest_addr;
+    RREP *rrep;
+    RERR *rerr;
+    RERR_udest *udest;
+    int len, iphl, i;
+
+    len = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *) &sll,
+		   &sll_len);
+
+    if (len < 0) {
+	alog(LOG_WARNING, errno, __FUNCTION__, "Receive ERROR!");
+	return;
+    }
+
+    if (ifindex2devindex(sll.sll_ifindex) == MAX_NR_INTERFACES ||
+	len < (int) sizeof(struct iphdr))
+	return;
+
+    ip = (struct iphdr *) buf;
+    iphl = ip->ihl << 2;
+
+    if (len < iphl + (int) sizeof(struct udphdr) + (int) sizeof(AODV_msg))
+	return;
+
+    aodv_msg = (AODV_msg *) (buf + iphl + sizeof(struct udphdr));
+    len -= iphl + sizeof(struct udphdr);
+    sender.s_addr = ip->saddr;
+
+    switch (aodv_msg->type) {
+    case AODV_RREP:
+	if (len < (int) RREP_SIZE)
+	    return;
+	rrep = (RREP *) aodv_msg;
+	dest_addr.s_addr = rrep->dest_addr;
+	passive_learn(dest_addr, ntohl(rrep->dest_seqno), rrep->hcnt + 1,
+		      sender, sll.sll_ifindex);
+	break;
+    case AODV_RERR:
+	if (len < (int) RERR_SIZE)
+	    return;
+	rerr = (RERR *) aodv_msg;
+
+	if (len < (int) RERR_CALC_SIZE(rerr))
+	    return;
+
+	udest = RERR_UDEST_FIRST(rerr);
+
+	for (i = 0; i < rerr->dest_count; i++) {
+	    dest_addr.s_addr = udest->dest_addr;
+	    passive_forget(dest_addr, ntohl(udest->dest_seqno), sender);
+	    udest = RERR_UDEST_NEXT(udest);
+	}
+	break;
+    }
+}
+
+int passive_init(void)
+{
+    struct sock_fprog fprog;
+    struct packet_mreq mreq;
+    int i;
+
+    memset(passive_cache, 0, sizeof(passive_cache));
+    memset(&passive_stats, 0, sizeof(passive_stats));
+
+    passive_sock = socket(PF_PACKET, SOCK_DGRAM, htons(ETH_P_IP));
+
+    if (passive_sock < 0) {
+	alog(LOG_WARNING, errno, __FUNCTION__,
+	     "Could not open packet socket, passive learning disabled");
+	return -1;
+    }
+
+    fprog.len = sizeof(passive_filter) / sizeof(passive_filter[0]);
+    fprog.filter = passive_filter;
+
+    if (setsockopt(passive_sock, SOL_SOCKET, SO_ATTACH_FILTER,
+		   &fprog, sizeof(fprog)) < 0) {
+	alog(LOG_WARNING, errno, __FUNCTION__,
+	     "Could not attach filter, passive learning disabled");
+	passive_cleanup();
+	return -1;
+    }
+
+    /* Unicast frames for other nodes are only seen in promiscuous
+       mode */
+    for (i = 0; i < MAX_NR_INTERFACES; i++) {
+	if (!DEV_NR(i).enabled)
+	    continue;
+
+	memset(&mreq, 0, sizeof(mreq));
+	mreq.mr_ifindex = DEV_NR(i).ifindex;
+	mreq.mr_type = PACKET_MR_PROMISC;
+
+	if (setsockopt(passive_sock, SOL_PACKET, PACKET_ADD_MEMBERSHIP,
+		       &mreq, sizeof(mreq)) < 0)
+	    alog(LOG_WARNING, errno, __FUNCTION__,
+		 "Could not set %s promiscuous", DEV_NR(i).ifname);
+    }
+
+    if (attach_callback_func(passive_sock, passive_callback) < 0) {
+	alog(LOG_ERR, 0, __FUNCTION__, "Could not attach callback.");
+	passive_cleanup();
+	return -1;
+    }
+    return 0;
+}
+
+void passive_cleanup(void)
+{
+    /* Promiscuous mode is dropped by the kernel with the socket */
+    if (passive_sock >= 0)
+	close(passive_sock);
+
+    passive_sock = -1;
+}
+
+/* Install a route to dest_addr from the cache, if there is one that
+   is recent, goes through a current neighbor and is not older than
+   what the routing table knows. */
+rt_table_t *passive_route_install(struct in_addr dest_addr)
+{
+    struct passive_entry *pe = passive_slot(dest_addr);
+    rt_table_t *rt, *next_rt;
+
+    if (pe->dest_addr.s_addr != dest_addr.s_addr || !passive_fresh(pe))
+	return NULL;
+
+    next_rt = rt_table_find(pe->next_hop);
+
+    if (!next_rt || next_rt->state != VALID || next_rt->hcnt != 1 ||
+	next_rt->ifindex != pe->ifindex)
+	return NULL;
+
+    rt = rt_table_find(dest_addr);
+
+    if (rt && ((int32_t) rt->dest_seqno > (int32_t) pe->dest_seqno ||
+	       rt->ifindex != pe->ifindex))
+	return NULL;
+
+    DEBUG(LOG_DEBUG, 0, "Using overheard route to %s via %s",
+	  ip_to_str(dest_addr), ip_to_str(pe->next_hop));
+
+    if (rt)
+	rt = rt_table_update(rt, pe->next_hop, pe->hcnt, pe->dest_seqno,
+			     ACTIVE_ROUTE_TIMEOUT, VALID, RT_PASSIVE);
+    else
+	rt = rt_table_insert(dest_addr, pe->next_hop, pe->hcnt,
+			     pe->dest_seqno, ACTIVE_ROUTE_TIMEOUT, VALID,
+			     RT_PASSIVE, pe->ifindex);
+
+    /* Each entry is used once. If the route turns out to be broken
+       the next discovery goes through a real RREQ. */
+    memset(pe, 0, sizeof(struct passive_entry));
+    passive_stats.used++;
+
+    return rt;
+}
+
+/* TTL to start a discovery for dest_addr with, or 0 if the cache has
+   nothing on it. */
+int passive_ttl(struct in_addr dest_addr)
+{
+    struct passive_entry *pe = passive_slot(dest_addr);
+
+    if (pe->dest_addr.s_addr != dest_addr.s_addr || !passive_fresh(pe))
+	return 0;
+
+    passive_stats.seeded++;
+
+    return pe->hcnt + TTL_INCREMENT;
+}
@@ -0,0 +1,57 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+#ifndef _PASSIVE_H
+#define _PASSIVE_H
+
+#include "defs.h"
+#include "routing_table.h"
+
+/* Routes learned from overheard RREPs. The cache is direct mapped on
+   the destination address, so it never grows beyond this. */
+#define PASSIVE_CACHE_SIZE 128	/* Must be a power of 2 */
+#define PASSIVE_CACHE_MASK (PASSIVE_CACHE_SIZE - 1)
+
+struct passive_entry {
+    struct in_addr dest_addr;
+    struct in_addr next_hop;	/* The node we heard the RREP from */
+    u_int32_t dest_seqno;
+    u_int8_t hcnt;		/* Hop count via next_hop */
+    unsigned int ifindex;
+    struct timeval time;	/* When it was heard */
+};
+
+struct passive_stats {
+    unsigned int learned;
+    unsigned int used;		/* Discoveries answered from the cache */
+    unsigned int seeded;	/* Discoveries with a TTL from the cache */
+};
+
+extern struct passive_stats passive_stats;
+
+int passive_init(void);
+void passive_cleanup(void);
+rt_table_t *passive_route_install(struct in_addr dest_addr);
+void passive_forget(struct in_addr dest_addr, u_int32_t dest_seqno,
+		    struct in_addr sender);
+int passive_ttl(struct in_addr dest_addr);
+
+#endif				/* _PASSIVE_H */
@@ -34,14 +34,14 @@
 #include "timer_queue.h"
 #include "defs.h"
 #include "debug.h"
+#include "evlog.h"
+#include "rtjournal.h"
 #include "params.h"
 #include "seek_list.h"
 #include "nl.h"
 #endif				/* NS_PORT */
 
-static unsigned int hashing(struct in_addr *addr, hash_value * hash);
-
-extern int llfeedback;
+extern int llfeedback, multipath, etx_metric;
 
 void NS_CLASS rt_table_init()
 {
@@ -70,15 +70,6 @@ void NS_CLASS rt_table_destroy()
 	}
 }
 
-/* Calculate a hash value and table index given a key... */
-unsigned int hashing(struct in_addr *addr, hash_value * hash)
-{
-	/*   *hash = (*addr & 0x7fffffff); */
-	*hash = (hash_value) addr->s_addr;
-
-	return (*hash & RT_TABLEMASK);
-}
-
 rt_table_t *NS_CLASS rt_table_insert(struct in_addr dest_addr,
 				     struct in_addr next,
 				     u_int8_t hops, u_int32_t seqno,
@@ -136,12 +127,17 @@ rt_table_t *NS_CLASS rt_table_insert(struct in_addr dest_addr,
 	rt->nprec = 0;
 	INIT_LIST_HEAD(&rt->precursors);
 
+	rt->adv_hcnt = hops;
+	rt->npaths = 0;
+	INIT_LIST_HEAD(&rt->paths);
+
 	/* Insert first in bucket... */
 
 	rt_tbl.num_entries++;
 
 	DEBUG(LOG_INFO, 0, "Inserting %s (bucket %d) next hop %s",
 	      ip_to_str(dest_addr), index, ip_to_str(next));
+	EVLOG(EV_RT_INSERT, dest_addr.s_addr, next.s_addr, hops, 0);
 
 	list_add(&rt_tbl.tbl[index], &rt->l);
 
@@ -175,9 +171,11 @@ rt_table_t *NS_CLASS rt_table_insert(struct in_addr dest_addr,
 	if (life != 0)
 		timer_set_timeout(&rt->rt_timer, life);
 //#endif
+	RTJOURNAL(RTJ_INSERT, rt);
+
 	/* In case there are buffered packets for this destination, we
 	 * send them on the new route. */
-	if (rt->state == VALID && seek_list_remove(seek_list_find(dest_addr))) {
+	if (rt->state == VALID && seek_list_found(dest_addr, hops)) {
 #ifdef NS_PORT
 		if (rt->flags & RT_INET_DEST)
 			packet_queue_set_verdict(dest_addr, PQ_ENC_SEND);
@@ -193,7 +191,9 @@ rt_table_t *NS_CLASS rt_table_update(rt_table_t * rt, struct in_addr next,
 				     u_int32_t lifetime, u_int8_t state,
 				     u_int16_t flags)
 {
-	struct in_addr nm;
+	struct in_addr nm, old_next = rt->next_hop;
+	u_int8_t old_hcnt = rt->hcnt;
+	int same_seqno = (rt->state == VALID && seqno == rt->dest_seqno);
 	nm.s_addr = 0;
 
 	if (rt->state == INVALID && state == VALID) {
@@ -228,6 +228,7 @@ rt_table_t *NS_CLASS rt_table_update(rt_table_t * rt, struct in_addr next,
 		rt->last_hello_time.tv_usec = 0;
 		rt->hello_cnt = 0;
 		timer_remove(&rt->hello_timer);
+		rt->lq = 0;
 		/* Must also do a "link break" when updating a 1 hop
 		neighbor in case another routing entry use this as
 		next hop... */
@@ -238,6 +239,21 @@ rt_table_t *NS_CLASS rt_table_update(rt_table_t * rt, struct in_addr next,
 	rt->dest_seqno = seqno;
 	rt->next_hop = next;
 	rt->hcnt = hops;
+	rt->metric = 0;		/* Set by the caller if known */
+
+	/* Alternates are only valid for the sequence number they were
+	   learned with. On a same seqno update the old next hop is kept
+	   as an alternate, and the advertised hop count stays what it
+	   was when the sequence number was first learned. */
+	if (multipath && same_seqno && rt->state == VALID) {
+		rt_table_remove_path(rt, next);
+		if (old_next.s_addr != next.s_addr)
+			rt_table_add_path(rt, old_next, old_hcnt, seqno,
+					  rt->ifindex);
+	} else {
+		rt_table_path_flush(rt);
+		rt->adv_hcnt = hops;
+	}
 
 #ifdef CONFIG_GATEWAY
 	if (rt->flags & RT_GATEWAY)
@@ -254,10 +270,11 @@ rt_table_t *NS_CLASS rt_table_update(rt_table_t * rt, struct in_addr next,
 	/* Finally, mark as VALID */
 	rt->state = state;
 
+	RTJOURNAL(RTJ_UPDATE, rt);
+
 	/* In case there are buffered packets for this destination, we send
 	 * them on the new route. */
-	if (rt->state == VALID
-	    && seek_list_remove(seek_list_find(rt->dest_addr))) {
+	if (rt->state == VALID && seek_list_found(rt->dest_addr, rt->hcnt)) {
 #ifdef NS_PORT
 		if (rt->flags & RT_INET_DEST)
 			packet_queue_set_verdict(rt->dest_addr, PQ_ENC_SEND);
@@ -268,6 +285,71 @@ rt_table_t *NS_CLASS rt_table_update(rt_table_t * rt, struct in_addr next,
 	return rt;
 }
 
+/* ETX of the link to neighbor nb, from its hello delivery ratio. The
+   ratio of our hellos at the neighbor is not known, so the link is
+   assumed symmetric. Returns 0 if there is no estimate. */
+u_int32_t NS_CLASS rt_table_link_metric(rt_table_t * nb)
+{
+	u_int32_t etx;
+
+	if (!etx_metric || !nb || nb->state != VALID || nb->hcnt != 1 ||
+	    nb->lq == 0)
+		return 0;
+
+	etx = (ETX_ONE * LQ_ONE * LQ_ONE) / ((u_int32_t) nb->lq * nb->lq);
+
+	return etx < ETX_LINK_MAX ? etx : ETX_LINK_MAX;
+}
+
+/* Add the link to neighbor nb_addr to a metric received from it.
+   Returns 0 if either is unknown. */
+u_int32_t NS_CLASS rt_table_metric_add(u_int32_t metric,
+				       struct in_addr nb_addr)
+{
+	u_int32_t link;
+
+	if (metric == RT_METRIC_UNKNOWN)
+		return 0;
+
+	link = rt_table_link_metric(rt_table_find(nb_addr));
+
+	if (!link)
+		return 0;
+
+	return metric + link;
+}
+
+/* Is a route with the same sequence number over hops/metric better
+   than rt? The metric decides when both are known, otherwise the hop
+   count does as before. */
+int NS_CLASS rt_table_better(rt_table_t * rt, u_int8_t hops,
+			     u_int32_t metric)
+{
+	if (rt->state == INVALID)
+		return 1;
+
+	/* With multipath, a route longer than what we advertised for
+	   this seqno could loop through a node using us as alternate. */
+	if (multipath && hops > rt->adv_hcnt)
+		return 0;
+
+	if (metric && rt->metric)
+		return metric < rt->metric;
+
+	return hops < rt->hcnt;
+}
+
+/* The hop count to put in RREQs and RREPs about rt. With multipath it
+   must not grow for the same sequence number, since neighbors may
+   have accepted us as alternate next hop based on it. */
+u_int8_t NS_CLASS rt_table_adv_hcnt(rt_table_t * rt)
+{
+	if (multipath && rt->state == VALID)
+		return rt->adv_hcnt;
+
+	return rt->hcnt;
+}
+
 NS_INLINE rt_table_t *NS_CLASS rt_table_update_timeout(rt_table_t * rt,
 						       u_int32_t lifetime)
 {
@@ -287,6 +369,8 @@ NS_INLINE rt_table_t *NS_CLASS rt_table_update_timeout(rt_table_t * rt,
 	} else
 		timer_set_timeout(&rt->rt_timer, lifetime);
 
+	RTJOURNAL_REFRESH(rt);
+
 	return rt;
 }
 
@@ -436,6 +520,8 @@ int NS_CLASS rt_table_invalidate(rt_table_t * rt)
 		      timeval_diff(&now, &rt->last_hello_time));
 	}
 
+	EVLOG(EV_RT_INVALIDATE, rt->dest_addr.s_addr, rt->dest_seqno, 0, 0);
+
 	/* Remove any pending, but now obsolete timers. */
 	timer_remove(&rt->rt_timer);
 	timer_remove(&rt->hello_timer);
@@ -445,6 +531,9 @@ int NS_CLASS rt_table_invalidate(rt_table_t * rt)
 	rt->state = INVALID;
 	rt_tbl.num_active--;
 
+	/* A preemptive discovery now has to find a new route */
+	seek_list_preempt_clear(seek_list_find(rt->dest_addr));
+
 	rt->hello_cnt = 0;
 
 	/* When the lifetime of a route entry expires, increase the sequence
@@ -454,6 +543,8 @@ int NS_CLASS rt_table_invalidate(rt_table_t * rt)
 	rt->last_hello_time.tv_sec = 0;
 	rt->last_hello_time.tv_usec = 0;
 
+	rt_table_path_flush(rt);
+
 #ifndef NS_PORT
 	nl_send_del_route_msg(rt->dest_addr, rt->next_hop, rt->hcnt);
 #endif
@@ -519,6 +610,7 @@ int NS_CLASS rt_table_invalidate(rt_table_t * rt)
 		DEBUG(LOG_DEBUG, 0, "%s removed in %u msecs",
 		      ip_to_str(rt->dest_addr), DELETE_PERIOD);
 	}
+	RTJOURNAL(RTJ_INVALIDATE, rt);
 
 	return 0;
 }
@@ -532,7 +624,10 @@ void NS_CLASS rt_table_delete(rt_table_t * rt)
 
 	list_detach(&rt->l);
 
+	RTJOURNAL(RTJ_DELETE, rt);
+
 	precursor_list_destroy(rt);
+	rt_table_path_flush(rt);
 
 	if (rt->state == VALID) {
 
@@ -554,9 +649,130 @@ void NS_CLASS rt_table_delete(rt_table_t * rt)
 
 /****************************************************************/
 
+/* Multipath (AOMDV style) alternate next hops. A route keeps up to
+   RT_MAX_PATHS alternates besides its primary next hop, all for the
+   route's current sequence number. To stay loop free, an alternate is
+   only accepted if the neighbor's advertised hop count is lower than
+   the hop count we advertise for that sequence number (rt->adv_hcnt,
+   see rt_table_adv_hcnt()). */
+
+rt_path_t *NS_CLASS rt_table_add_path(rt_table_t * rt, struct in_addr next,
+				      u_int8_t hops, u_int32_t seqno,
+				      unsigned int ifindex)
+{
+	rt_path_t *path, *worst = NULL;
+	list_t *pos;
+
+	if (!multipath || !rt || rt->state != VALID)
+		return NULL;
+
+	if (seqno != rt->dest_seqno || hops > rt->adv_hcnt ||
+	    next.s_addr == rt->next_hop.s_addr)
+		return NULL;
+
+	list_foreach(pos, &rt->paths) {
+		path = (rt_path_t *) pos;
+
+		if (path->next_hop.s_addr == next.s_addr) {
+			path->hcnt = hops;
+			path->ifindex = ifindex;
+			return path;
+		}
+		if (!worst || path->hcnt > worst->hcnt)
+			worst = path;
+	}
+
+	if (rt->npaths >= RT_MAX_PATHS) {
+		if (hops >= worst->hcnt)
+			return NULL;
+		/* Replace the longest alternate */
+		path = worst;
+	} else {
+		if ((path = (rt_path_t *) malloc(sizeof(rt_path_t))) == NULL) {
+			fprintf(stderr, "Malloc failed!\n");
+			exit(-1);
+		}
+		list_add_tail(&rt->paths, &path->l);
+		rt->npaths++;
+	}
+	path->next_hop = next;
+	path->hcnt = hops;
+	path->ifindex = ifindex;
+
+	DEBUG(LOG_DEBUG, 0, "Alternate path to %s via %s, hcnt=%d (%d paths)",
+	      ip_to_str(rt->dest_addr), ip_to_str(next), hops, rt->npaths);
+
+	return path;
+}
+
+void NS_CLASS rt_table_remove_path(rt_table_t * rt, struct in_addr next)
+{
+	list_t *pos, *tmp;
+
+	list_foreach_safe(pos, tmp, &rt->paths) {
+		rt_path_t *path = (rt_path_t *) pos;
+
+		if (path->next_hop.s_addr == next.s_addr) {
+			list_detach(pos);
+			rt->npaths--;
+			free(path);
+		}
+	}
+}
+
+/* Switch a route whose next hop broke to its best alternate, if any
+   of them goes through a valid neighbor. Returns 1 if the route was
+   switched. */
+int NS_CLASS rt_table_failover(rt_table_t * rt)
+{
+	rt_path_t *best = NULL;
+	list_t *pos;
+
+	if (!rt || rt->state != VALID)
+		return 0;
+
+	list_foreach(pos, &rt->paths) {
+		rt_path_t *path = (rt_path_t *) pos;
+		rt_table_t *nb = rt_table_find(path->next_hop);
+
+		if (!nb || nb->state != VALID || nb->hcnt != 1)
+			continue;
+
+		if (!best || path->hcnt < best->hcnt)
+			best = path;
+	}
+
+	if (!best)
+		return 0;
+
+	DEBUG(LOG_DEBUG, 0, "Failover %s: next hop %s -> %s, hcnt=%d",
+	      ip_to_str(rt->dest_addr), ip_to_str(rt->next_hop),
+	      ip_to_str(best->next_hop), best->hcnt);
+
+#ifndef NS_PORT
+	nl_send_del_route_msg(rt->dest_addr, rt->next_hop, rt->hcnt);
+	nl_send_add_route_msg(rt->dest_addr, best->next_hop, best->hcnt,
+			      ACTIVE_ROUTE_TIMEOUT, rt->flags, best->ifindex);
+#endif
+	rt->next_hop = best->next_hop;
+	rt->hcnt = best->hcnt;
+	rt->ifindex = best->ifindex;
+
+	list_detach(&best->l);
+	rt->npaths--;
+	free(best);
+
+	rt_table_update_timeout(rt, ACTIVE_ROUTE_TIMEOUT);
+
+	RTJOURNAL(RTJ_UPDATE, rt);
+
+	return 1;
+}
+
 /* Add an neighbor to the active neighbor list. */
 
-void NS_CLASS precursor_add(rt_table_t * rt, struct in_addr addr)
+void NS_CLASS precursor_add(rt_table_t * rt, struct in_addr addr,
+			    unsigned int ifindex)
 {
 	precursor_t *pr;
 	list_t *pos;
@@ -569,8 +785,10 @@ void NS_CLASS precursor_add(rt_table_t * rt, struct in_addr addr)
 	list_foreach(pos, &rt->precursors) {
 		pr = (precursor_t *) pos;
 
-		if (pr->neighbor.s_addr == addr.s_addr)
+		if (pr->neighbor.s_addr == addr.s_addr) {
+			pr->ifindex = ifindex;
 			return;
+		}
 	}
 
 	if ((pr = (precursor_t *) malloc(sizeof(precursor_t))) == NULL) {
@@ -582,6 +800,7 @@ void NS_CLASS precursor_add(rt_table_t * rt, struct in_addr addr)
 	      ip_to_str(addr), ip_to_str(rt->dest_addr));
 
 	pr->neighbor.s_addr = addr.s_addr;
+	pr->ifindex = ifindex;
 
 	/* Insert in precursors list */
 
@@ -636,3 +855,19 @@ void precursor_list_destroy(rt_table_t * rt)
 		free(pr);
 	}
 }
+
+/* Delete all alternate paths of a route. */
+
+void rt_table_path_flush(rt_table_t * rt)
+{
+	list_t *pos, *tmp;
+
+	if (!rt)
+		return;
+
+	list_foreach_safe(pos, tmp, &rt->paths) {
+		list_detach(pos);
+		free(pos);
+	}
+	rt->npaths = 0;
+}
@@ -33,6 +33,7 @@ typedef struct rt_table rt_table_t;
 typedef struct precursor {
     list_t l;
     struct in_addr neighbor;
+    unsigned int ifindex;	/* Interface the neighbor is reached on */
 } precursor_t;
 
 #define FIRST_PREC(h) ((precursor_t *)((h).next))
@@ -41,6 +42,17 @@ typedef struct precursor {
 
 typedef u_int32_t hash_value;	/* A hash value */
 
+/* Alternate next hop for a destination (multipath). All alternates
+   of a route share the route's sequence number. */
+typedef struct rt_path {
+    list_t l;
+    struct in_addr next_hop;
+    unsigned int ifindex;
+    u_int8_t hcnt;
+} rt_path_t;
+
+#define RT_MAX_PATHS 3		/* Max alternates kept per destination */
+
 /* Route table entries */
 struct rt_table {
     list_t l;
@@ -55,12 +67,32 @@ struct rt_table {
     struct timer ack_timer;	/* RREP_ack timer for this destination */
     struct timer hello_timer;
     struct timeval last_hello_time;
+    u_int32_t hello_interval;	/* Last interval the neighbor advertised */
     u_int8_t hello_cnt;
     hash_value hash;
     int nprec;			/* Number of precursors */
     list_t precursors;		/* List of neighbors using the route */
+    u_int8_t adv_hcnt;		/* Hop count advertised for dest_seqno */
+    int npaths;			/* Number of alternate paths */
+    list_t paths;		/* Alternate next hops, see rt_path_t */
+    u_int16_t lq;		/* Hello delivery ratio (neighbors only) */
+    int16_t lq_trend;		/* Smoothed change of lq per hello */
+    u_int8_t lq_degraded;	/* Set when lq drops below LQ_DEGRADE,
+				   cleared when it is back at LQ_RECOVER */
+    u_int32_t metric;		/* Path ETX, 0 if unknown */
+    struct timeval rtj_expire;	/* Expiry last written to the journal */
 };
 
+/* Link quality and ETX are kept in fixed point. A neighbor that never
+   loses a hello has lq LQ_ONE and a link ETX of ETX_ONE. */
+#define LQ_ONE            256
+#define LQ_SHIFT          3	/* EWMA weight 1/8 */
+#define LQ_DEGRADE        (LQ_ONE * 5 / 8)	/* Start looking for a new route */
+#define LQ_RECOVER        (LQ_ONE * 3 / 4)
+#define ETX_ONE           16
+#define ETX_LINK_MAX      (16 * ETX_ONE)
+#define RT_METRIC_UNKNOWN 0xffffffff	/* In metric extensions */
+
 
 /* Route entry flags */
 #define RT_UNIDIR        0x1
@@ -69,6 +101,11 @@ struct rt_table {
 #define RT_INET_DEST     0x8	/* Mark for Internet destinations (to be relayed
 				 * through a Internet gateway. */
 #define RT_GATEWAY       0x10
+#define RT_PASSIVE       0x20	/* Learned from an overheard RREP */
+
+/* Letters for printing the flags above, one per bit from RT_UNIDIR
+   up. Flags with a space are not shown. */
+#define RT_FLAG_CHARS    "UR IGP"
 
 /* Route entry states */
 #define INVALID   0
@@ -78,6 +115,19 @@ struct rt_table {
 #define RT_TABLESIZE 64		/* Must be a power of 2 */
 #define RT_TABLEMASK (RT_TABLESIZE - 1)
 
+/* Scramble an address so that nodes on the same subnet spread over
+   the buckets of a table. Take an index from the middle bits. */
+#define hash_addr(addr) ((u_int32_t) (ntohl((addr)->s_addr) * 2654435761U))
+
+/* Calculate a hash value and table index given a key. Used by all
+   tables indexed by address (routing table, seek list, blacklist). */
+static inline unsigned int hashing(struct in_addr *addr, hash_value * hash)
+{
+    *hash = (hash_value) addr->s_addr;
+
+    return (hash_addr(addr) >> 16) & RT_TABLEMASK;
+}
+
 struct routing_table {
     unsigned int num_entries;
     unsigned int num_active;
@@ -85,6 +135,7 @@ struct routing_table {
 };
 
 void precursor_list_destroy(rt_table_t * rt);
+void rt_table_path_flush(rt_table_t * rt);
 #endif				/* NS_NO_GLOBALS */
 
 #ifndef NS_NO_DECLARATIONS
@@ -108,7 +159,17 @@ rt_table_t *rt_table_find_gateway();
 int rt_table_update_inet_rt(rt_table_t * gw, u_int32_t life);
 int rt_table_invalidate(rt_table_t * rt);
 void rt_table_delete(rt_table_t * rt);
-void precursor_add(rt_table_t * rt, struct in_addr addr);
+rt_path_t *rt_table_add_path(rt_table_t * rt, struct in_addr next,
+			     u_int8_t hops, u_int32_t seqno,
+			     unsigned int ifindex);
+void rt_table_remove_path(rt_table_t * rt, struct in_addr next);
+int rt_table_failover(rt_table_t * rt);
+u_int32_t rt_table_link_metric(rt_table_t * nb);
+u_int32_t rt_table_metric_add(u_int32_t metric, struct in_addr nb_addr);
+int rt_table_better(rt_table_t * rt, u_int8_t hops, u_int32_t metric);
+u_int8_t rt_table_adv_hcnt(rt_table_t * rt);
+void precursor_add(rt_table_t * rt, struct in_addr addr,
+		   unsigned int ifindex);
 void precursor_remove(rt_table_t * rt, struct in_addr addr);
 
 #endif				/* NS_NO_DECLARATIONS */
@@ -0,0 +1,227 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* In-kernel duplicate RREQ filtering.
+ *
+ * During a flood every neighbor rebroadcasts the same RREQ, and all
+ * but the first copy are thrown away by rreq_record_find() after a
+ * full trip through the socket layer. Here we attach an eBPF socket
+ * filter to the AODV sockets that looks up (originator, RREQ id) in
+ * an LRU hash map and drops the packet in the kernel if the pair is
+ * already known. The daemon inserts pairs as it accepts RREQs, so the
+ * map mirrors the rreq_records list.
+ *
+ * If any of the BPF steps fail (old kernel, no privileges) we log it
+ * and the daemon runs exactly as before with user space filtering
+ * only. */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <netinet/in.h>
+#include <linux/bpf.h>
+
+#include "defs.h"
+#include "debug.h"
+#include "rreq_bpf.h"
+
+#ifndef SO_ATTACH_BPF
+#define SO_ATTACH_BPF 50
+#endif
+
+/* The socket filter runs after the IP header has been pulled, so the
+   AODV message follows directly after the UDP header. */
+#define RREQ_BPF_MSG_OFF 8
+
+/* Bytes of the RREQ needed by the filter: type ... orig_addr */
+#define RREQ_BPF_LOAD_LEN 20
+
+/* Map key. Both fields in network byte order, as found on the wire. */
+struct rreq_bpf_key {
+    u_int32_t orig_addr;
+    u_int32_t rreq_id;
+};
+
+/* Minimal instruction helpers, so that we do not depend on libbpf. */
+#define INSN(c, d, s, o, i) \
+	((struct bpf_insn) { .code = (c), .dst_reg = (d), .src_reg = (s), \
+			     .off = (o), .imm = (i) })
+#define MOV64_REG(d, s)	INSN(BPF_ALU64 | BPF_MOV | BPF_X, d, s, 0, 0)
+#define MOV64_IMM(d, i)	INSN(BPF_ALU64 | BPF_MOV | BPF_K, d, 0, 0, i)
+#define ADD64_IMM(d, i)	INSN(BPF_ALU64 | BPF_ADD | BPF_K, d, 0, 0, i)
+#define LDX_MEM(sz, d, s, o) INSN(BPF_LDX | BPF_MEM | (sz), d, s, o, 0)
+#define STX_MEM(sz, d, s, o) INSN(BPF_STX | BPF_MEM | (sz), d, s, o, 0)
+#define JNE_IMM(d, i, o) INSN(BPF_JMP | BPF_JNE | BPF_K, d, 0, o, i)
+#define JEQ_IMM(d, i, o) INSN(BPF_JMP | BPF_JEQ | BPF_K, d, 0, o, i)
+#define CALL(f)		INSN(BPF_JMP | BPF_CALL, 0, 0, 0, f)
+#define EXIT()		INSN(BPF_JMP | BPF_EXIT, 0, 0, 0, 0)
+#define LD_MAP_FD(d, fd) \
+	INSN(BPF_LD | BPF_DW | BPF_IMM, d, BPF_PSEUDO_MAP_FD, 0, fd), \
+	INSN(0, 0, 0, 0, 0)
+
+static int map_fd = -1;
+static int prog_fd = -1;
+
+static int sys_bpf(int cmd, union bpf_attr *attr)
+{
+    return syscall(__NR_bpf, cmd, attr, sizeof(*attr));
+}
+
+static int rreq_bpf_load_prog(void)
+{
+    char license[] = "GPL";
+    union bpf_attr attr;
+
+    /* Stack layout: fp-24..fp-5 holds the first 20 bytes of the
+       message, fp-32..fp-25 the map key. */
+    struct bpf_insn prog[] = {
+	MOV64_REG(BPF_REG_6, BPF_REG_1),
+	MOV64_IMM(BPF_REG_2, RREQ_BPF_MSG_OFF),
+	MOV64_REG(BPF_REG_3, BPF_REG_10),
+	ADD64_IMM(BPF_REG_3, -24),
+	MOV64_IMM(BPF_REG_4, RREQ_BPF_LOAD_LEN),
+	MOV64_REG(BPF_REG_1, BPF_REG_6),
+	CALL(BPF_FUNC_skb_load_bytes),
+	JNE_IMM(BPF_REG_0, 0, 14),	/* Too short, accept */
+	LDX_MEM(BPF_B, BPF_REG_1, BPF_REG_10, -24),
+	JNE_IMM(BPF_REG_1, AODV_RREQ, 12),	/* Not a RREQ, accept */
+	LDX_MEM(BPF_W, BPF_REG_1, BPF_REG_10, -8),	/* orig_addr */
+	STX_MEM(BPF_W, BPF_REG_10, BPF_REG_1, -32),
+	LDX_MEM(BPF_W, BPF_REG_1, BPF_REG_10, -20),	/* rreq_id */
+	STX_MEM(BPF_W, BPF_REG_10, BPF_REG_1, -28),
+	LD_MAP_FD(BPF_REG_1, map_fd),
+	MOV64_REG(BPF_REG_2, BPF_REG_10),
+	ADD64_IMM(BPF_REG_2, -32),
+	CALL(BPF_FUNC_map_lookup_elem),
+	JEQ_IMM(BPF_REG_0, 0, 2),	/* Unknown RREQ, accept */
+	MOV64_IMM(BPF_REG_0, 0),	/* Duplicate, drop */
+	EXIT(),
+	MOV64_IMM(BPF_REG_0, -1),
+	EXIT(),
+    };
+
+    memset(&attr, 0, sizeof(attr));
+    attr.prog_type = BPF_PROG_TYPE_SOCKET_FILTER;
+    attr.insns = (unsigned long) prog;
+    attr.insn_cnt = sizeof(prog) / sizeof(prog[0]);
+    attr.license = (unsigned long) license;
+
+    return sys_bpf(BPF_PROG_LOAD, &attr);
+}
+
+int rreq_bpf_init(void)
+{
+    union bpf_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_type = BPF_MAP_TYPE_LRU_HASH;
+    attr.key_size = sizeof(struct rreq_bpf_key);
+    attr.value_size = sizeof(u_int8_t);
+    attr.max_entries = RREQ_BPF_MAP_SIZE;
+
+    map_fd = sys_bpf(BPF_MAP_CREATE, &attr);
+
+    if (map_fd < 0) {
+	alog(LOG_NOTICE, errno, __FUNCTION__,
+	     "Could not create BPF map, RREQ filtering in user space only");
+	return -1;
+    }
+
+    prog_fd = rreq_bpf_load_prog();
+
+    if (prog_fd < 0) {
+	alog(LOG_NOTICE, errno, __FUNCTION__,
+	     "Could not load BPF program, RREQ filtering in user space only");
+	close(map_fd);
+	map_fd = -1;
+	return -1;
+    }
+    return 0;
+}
+
+int rreq_bpf_attach(int sock)
+{
+    if (prog_fd < 0)
+	return -1;
+
+    if (setsockopt(sock, SOL_SOCKET, SO_ATTACH_BPF,
+		   &prog_fd, sizeof(prog_fd)) < 0) {
+	alog(LOG_NOTICE, errno, __FUNCTION__,
+	     "Could not attach BPF filter, RREQ filtering in user space only");
+	rreq_bpf_cleanup();
+	return -1;
+    }
+    return 0;
+}
+
+void rreq_bpf_insert(struct in_addr orig_addr, u_int32_t rreq_id)
+{
+    union bpf_attr attr;
+    struct rreq_bpf_key key;
+    u_int8_t val = 1;
+
+    if (map_fd < 0)
+	return;
+
+    key.orig_addr = orig_addr.s_addr;
+    key.rreq_id = htonl(rreq_id);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = map_fd;
+    attr.key = (unsigned long) &key;
+    attr.value = (unsigned long) &val;
+    attr.flags = BPF_ANY;
+
+    if (sys_bpf(BPF_MAP_UPDATE_ELEM, &attr) < 0)
+	DEBUG(LOG_DEBUG, errno, "Could not insert RREQ in BPF map");
+}
+
+void rreq_bpf_remove(struct in_addr orig_addr, u_int32_t rreq_id)
+{
+    union bpf_attr attr;
+    struct rreq_bpf_key key;
+
+    if (map_fd < 0)
+	return;
+
+    key.orig_addr = orig_addr.s_addr;
+    key.rreq_id = htonl(rreq_id);
+
+    memset(&attr, 0, sizeof(attr));
+    attr.map_fd = map_fd;
+    attr.key = (unsigned long) &key;
+
+    /* The entry may already have been evicted by the LRU, so ENOENT
+       is not an error. */
+    sys_bpf(BPF_MAP_DELETE_ELEM, &attr);
+}
+
+void rreq_bpf_cleanup(void)
+{
+    if (prog_fd >= 0)
+	close(prog_fd);
+    if (map_fd >= 0)
+	close(map_fd);
+
+    prog_fd = -1;
+    map_fd = -1;
+}
@@ -0,0 +1,38 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+#ifndef _RREQ_BPF_H
+#define _RREQ_BPF_H
+
+#include "defs.h"
+
+/* Number of (originator, RREQ id) pairs remembered by the kernel. The
+   map is an LRU hash, so old entries are evicted automatically when
+   it fills up. */
+#define RREQ_BPF_MAP_SIZE 1024
+
+int rreq_bpf_init(void);
+int rreq_bpf_attach(int sock);
+void rreq_bpf_insert(struct in_addr orig_addr, u_int32_t rreq_id);
+void rreq_bpf_remove(struct in_addr orig_addr, u_int32_t rreq_id);
+void rreq_bpf_cleanup(void);
+
+#endif				/* _RREQ_BPF_H */
@@ -0,0 +1,209 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include "defs.h"
+#include "debug.h"
+#include "timer_queue.h"
+#include "routing_table.h"
+#include "rtjournal.h"
+
+int rt_journal = 0;		/* Snapshot interval in secs, 0 = off */
+
+static char *rtj_path;
+static int rtj_fd = -1;
+static off_t rtj_size = 0;
+static char rtj_buf[RTJ_BUFSIZE];
+static int rtj_len = 0;
+static struct timer rtj_flush_timer;
+static struct timer rtj_snap_timer;
+
+static int rtj_open(void)
+{
+    struct rtj_hdr hdr;
+
+    rtj_fd = open(rtj_path, O_WRONLY | O_CREAT | O_APPEND,
+		  S_IROTH | S_IWUSR | S_IRUSR | S_IRGRP);
+
+    if (rtj_fd < 0) {
+	alog(LOG_WARNING, errno, __FUNCTION__, "Could not open %s", rtj_path);
+	return -1;
+    }
+
+    rtj_size = lseek(rtj_fd, 0, SEEK_END);
+
+    if (rtj_size == 0) {
+	memset(&hdr, 0, sizeof(hdr));
+	memcpy(hdr.magic, RTJ_MAGIC, sizeof(RTJ_MAGIC));
+	hdr.version = RTJ_VERSION;
+	hdr.rec_size = sizeof(struct rtj_rec);
+
+	if (write(rtj_fd, &hdr, sizeof(hdr)) != sizeof(hdr)) {
+	    alog(LOG_WARNING, errno, __FUNCTION__, "Could not write %s",
+		 rtj_path);
+	    close(rtj_fd);
+	    rtj_fd = -1;
+	    return -1;
+	}
+	rtj_size = sizeof(hdr);
+    }
+    return 0;
+}
+
+static void rtj_flush(void)
+{
+    ssize_t n;
+
+    if (rtj_len == 0)
+	return;
+
+    timer_remove(&rtj_flush_timer);
+
+    n = write(rtj_fd, rtj_buf, rtj_len);
+
+    if (n != rtj_len)
+	DEBUG(LOG_WARNING, errno, "Lost %d bytes of journal", rtj_len);
+
+    if (n > 0)
+	rtj_size += n;
+
+    rtj_len = 0;
+}
+
+static void rtj_flush_timeout(void *arg)
+{
+    rtj_flush();
+}
+
+static void rtj_write(u_int8_t op, rt_table_t * rt, struct timeval *now)
+{
+    struct rtj_rec *rec;
+
+    if (rtj_len + sizeof(struct rtj_rec) > RTJ_BUFSIZE)
+	rtj_flush();
+
+    rec = (struct rtj_rec *) (rtj_buf + rtj_len);
+    memset(rec, 0, sizeof(struct rtj_rec));
+    rec->sec = now->tv_sec;
+    rec->usec = now->tv_usec;
+    rec->op = op;
+
+    if (rt) {
+	rec->dest_addr = rt->dest_addr.s_addr;
+	rec->next_hop = rt->next_hop.s_addr;
+	rec->dest_seqno = rt->dest_seqno;
+	rec->flags = rt->flags;
+	rec->state = rt->state;
+	rec->hcnt = rt->hcnt;
+	rec->ifindex = rt->ifindex;
+	if (rt->rt_timer.used)
+	    rec->expire = timeval_diff(&rt->rt_timer.timeout, now);
+	rt->rtj_expire = rt->rt_timer.timeout;
+    }
+    rtj_len += sizeof(struct rtj_rec);
+
+    if (!rtj_flush_timer.used)
+	timer_set_timeout(&rtj_flush_timer, RTJ_FLUSH_INTERVAL);
+}
+
+static void rtj_snapshot(void *arg)
+{
+    struct timeval now;
+    int i;
+
+    rtj_flush();
+
+    /* Start a new file once in a while. The old one is kept, and the
+       new one begins with a full snapshot. */
+    if (rtj_size > RTJ_MAX_SIZE) {
+	char old[strlen(rtj_path) + 3];
+
+	sprintf(old, "%s.1", rtj_path);
+	close(rtj_fd);
+	rename(rtj_path, old);
+
+	if (rtj_open() < 0) {
+	    rt_journal = 0;
+	    return;
+	}
+    }
+
+    gettimeofday(&now, NULL);
+
+    rtj_write(RTJ_SNAP_BEGIN, NULL, &now);
+
+    for (i = 0; i < RT_TABLESIZE; i++) {
+	list_t *pos;
+	list_foreach(pos, &rt_tbl.tbl[i]) {
+	    rtj_write(RTJ_SNAP_ENTRY, (rt_table_t *) pos, &now);
+	}
+    }
+    rtj_write(RTJ_SNAP_END, NULL, &now);
+
+    rtj_flush();
+
+    timer_set_timeout(&rtj_snap_timer, rt_journal * 1000);
+}
+
+int rtj_init(char *path, int snapshot_interval)
+{
+    rtj_path = path;
+
+    if (rtj_open() < 0)
+	return -1;
+
+    rt_journal = snapshot_interval;
+
+    timer_init(&rtj_flush_timer, rtj_flush_timeout, NULL);
+    timer_init(&rtj_snap_timer, rtj_snapshot, NULL);
+
+    rtj_snapshot(NULL);
+
+    return 0;
+}
+
+void rtj_log(u_int8_t op, rt_table_t * rt)
+{
+    struct timeval now;
+
+    gettimeofday(&now, NULL);
+
+    rtj_write(op, rt, &now);
+}
+
+void rtj_cleanup(void)
+{
+    if (rtj_fd < 0)
+	return;
+
+    rtj_flush();
+    close(rtj_fd);
+
+    timer_remove(&rtj_flush_timer);
+    timer_remove(&rtj_snap_timer);
+
+    rtj_fd = -1;
+    rt_journal = 0;
+}
@@ -0,0 +1,101 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+#ifndef _RTJOURNAL_H
+#define _RTJOURNAL_H
+
+/* Routing table journal.
+ *
+ * Every insert, update, invalidation and delete of a route is written
+ * as a binary record, and a full snapshot of the table is added every
+ * so often. aodv-rtdump rebuilds the table at any point in time from
+ * the last snapshot before it and the changes that followed. */
+
+#define RTJ_MAGIC "AODVRTJ"
+#define RTJ_VERSION 1
+#define RTJ_BUFSIZE 4096	/* Records are written out in chunks */
+#define RTJ_FLUSH_INTERVAL 1000	/* msecs */
+#define RTJ_MAX_SIZE (4 * 1024 * 1024)	/* Rotate the file after this */
+
+/* Record ops */
+#define RTJ_INSERT     1
+#define RTJ_UPDATE     2
+#define RTJ_INVALIDATE 3
+#define RTJ_DELETE     4
+#define RTJ_SNAP_BEGIN 5	/* Forget what is known, entries follow */
+#define RTJ_SNAP_ENTRY 6
+#define RTJ_SNAP_END   7
+#define RTJ_REFRESH    8	/* Only the route timer moved */
+
+/* Route timer refreshes, one for every data packet, are journaled only
+   once the expiry has moved this many msecs from the journaled one. */
+#define RTJ_REFRESH_SLACK 1000
+
+struct rtj_hdr {
+    char magic[8];
+    u_int32_t version;
+    u_int32_t rec_size;
+};
+
+/* Addresses in network byte order */
+struct rtj_rec {
+    u_int32_t sec;
+    u_int32_t usec;
+    u_int32_t dest_addr;
+    u_int32_t next_hop;
+    u_int32_t dest_seqno;
+    u_int32_t expire;		/* msecs left on the route timer */
+    u_int16_t flags;
+    u_int8_t op;
+    u_int8_t state;
+    u_int8_t hcnt;
+    u_int8_t ifindex;
+    u_int16_t pad;
+};
+
+#ifdef NS_PORT
+#define RTJOURNAL(op, rt)
+#define RTJOURNAL_REFRESH(rt)
+#else
+#include "routing_table.h"
+
+extern int rt_journal;
+
+int rtj_init(char *path, int snapshot_interval);
+void rtj_log(u_int8_t op, rt_table_t * rt);
+void rtj_cleanup(void);
+
+#define RTJOURNAL(op, rt)						\
+	do {								\
+		if (rt_journal)						\
+			rtj_log(op, rt);				\
+	} while (0)
+
+#define RTJOURNAL_REFRESH(rt)						\
+	do {								\
+		if (rt_journal &&					\
+		    timeval_diff(&(rt)->rt_timer.timeout,		\
+				 &(rt)->rtj_expire) > RTJ_REFRESH_SLACK) \
+			rtj_log(RTJ_REFRESH, rt);			\
+	} while (0)
+#endif				/* NS_PORT */
+
+#endif				/* _RTJOURNAL_H */
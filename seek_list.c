@@ -33,25 +33,53 @@
 #include "params.h"
 #include "debug.h"
 #include "list.h"
+#include "routing_table.h"
+#include "stats.h"
 #endif
 
 #ifndef NS_PORT
-/* The seek list is a linked list of destinations we are seeking
-   (with RREQ's). */
+/* The seek list holds the destinations we are seeking (with
+   RREQ's). It is hashed on destination address like the routing
+   table. */
 
-static LIST(seekhead);
+static list_t seek_tbl[RT_TABLESIZE];
+static struct disc_hist disc_hist[DISC_HIST_SIZE];
+struct disc_stats disc_stats;
+struct disc_lat disc_lat;
+
+/* Smoothed per hop RREQ->RREP time and its mean deviation, usecs */
+static long ntt_srtt = 0;
+static long ntt_rttvar = 0;
+
+static void seek_list_rtt_sample(seek_list_t * entry, u_int8_t hcnt);
 
 #ifdef SEEK_LIST_DEBUG
 void seek_list_print();
 #endif
 #endif				/* NS_PORT */
 
+void NS_CLASS seek_list_init()
+{
+    int i;
+
+    for (i = 0; i < RT_TABLESIZE; i++)
+	INIT_LIST_HEAD(&seek_tbl[i]);
+
+    for (i = 0; i < DISC_HIST_SIZE; i++) {
+	disc_hist[i].dest_addr.s_addr = 0;
+	disc_hist[i].hcnt = 0;
+	disc_hist[i].fails = 0;
+    }
+}
+
 seek_list_t *NS_CLASS seek_list_insert(struct in_addr dest_addr,
 				       u_int32_t dest_seqno,
 				       int ttl, u_int8_t flags,
 				       struct ip_data *ipd)
 {
     seek_list_t *entry;
+    hash_value hash;
+    unsigned int index;
 
     if ((entry = (seek_list_t *) malloc(sizeof(seek_list_t))) == NULL) {
 	fprintf(stderr, "Failed malloc\n");
@@ -63,11 +91,18 @@ seek_list_t *NS_CLASS seek_list_insert(struct in_addr dest_addr,
     entry->flags = flags;
     entry->reqs = 0;
     entry->ttl = ttl;
+    entry->rreqs = 1;
+    entry->preempt = 0;
+    gettimeofday(&entry->rreq_time, NULL);
+    entry->start_time = entry->rreq_time;
+
+    disc_stats.started++;
     entry->ipd = ipd;
 
     timer_init(&entry->seek_timer, &NS_CLASS route_discovery_timeout, entry);
 
-    list_add(&seekhead, &entry->l);
+    index = hashing(&dest_addr, &hash);
+    list_add(&seek_tbl[index], &entry->l);
 #ifdef SEEK_LIST_DEBUG
     seek_list_print();
 #endif
@@ -94,8 +129,12 @@ int NS_CLASS seek_list_remove(seek_list_t * entry)
 seek_list_t *NS_CLASS seek_list_find(struct in_addr dest_addr)
 {
     list_t *pos;
+    hash_value hash;
+    unsigned int index;
+
+    index = hashing(&dest_addr, &hash);
 
-    list_foreach(pos, &seekhead) {
+    list_foreach(pos, &seek_tbl[index]) {
 	seek_list_t *entry = (seek_list_t *) pos;
 
 	if (entry->dest_addr.s_addr == dest_addr.s_addr)
@@ -104,15 +143,200 @@ seek_list_t *NS_CLASS seek_list_find(struct in_addr dest_addr)
     return NULL;
 }
 
+int NS_CLASS seek_list_count()
+{
+    list_t *pos;
+    int i, n = 0;
+
+    for (i = 0; i < RT_TABLESIZE; i++)
+	list_foreach(pos, &seek_tbl[i])
+	    n++;
+
+    return n;
+}
+
+/* A route to dest_addr was found. Remove the seek entry, if any, and
+   remember the outcome. Returns 1 if we were seeking the
+   destination. */
+int NS_CLASS seek_list_found(struct in_addr dest_addr, u_int8_t hcnt)
+{
+    seek_list_t *entry;
+
+    if (!(entry = seek_list_find(dest_addr)))
+	return 0;
+
+    if (entry->rreqs == 1) {
+	disc_stats.first_try++;
+	seek_list_rtt_sample(entry, hcnt);
+    }
+    seek_list_lat_record(entry, hcnt,
+			 entry->rreqs == 1 ? DISC_FIRST_TRY : DISC_RETRIED);
+
+    seek_list_hist_update(dest_addr, hcnt, 1);
+
+    return seek_list_remove(entry);
+}
+
+/* Turn a preemptive discovery into a normal one with all its
+   retries, once the route it was meant to replace is lost or data
+   waits for it. */
+void NS_CLASS seek_list_preempt_clear(seek_list_t * entry)
+{
+    if (!entry || !entry->preempt)
+	return;
+
+    DEBUG(LOG_DEBUG, 0, "Preemptive discovery for %s is now needed",
+	  ip_to_str(entry->dest_addr));
+
+    entry->preempt = 0;
+    entry->reqs = 0;
+    gettimeofday(&entry->start_time, NULL);
+}
+
+/* Add a finished discovery to the latency histograms */
+void NS_CLASS seek_list_lat_record(seek_list_t * entry, u_int8_t hcnt,
+				   int outcome)
+{
+    struct timeval now;
+    int b;
+
+    if (entry->start_time.tv_sec == 0)
+	return;
+
+    gettimeofday(&now, NULL);
+
+    b = disc_lat_bucket(timeval_diff(&now, &entry->start_time));
+
+    disc_lat.outcome[outcome][b]++;
+
+    if (outcome != DISC_FAILED && hcnt > 0)
+	disc_lat.hops[(hcnt < DISC_HOPS_MAX ? hcnt : DISC_HOPS_MAX) - 1][b]++;
+
+    disc_lat.attempts[(entry->rreqs < DISC_ATTEMPTS_MAX ?
+		       entry->rreqs : DISC_ATTEMPTS_MAX) - 1]++;
+}
+
+/* The pct percentile of a latency histogram, as the start of the
+   bucket it falls in. Returns -1 for an empty histogram. */
+long NS_CLASS seek_list_lat_pct(u_int32_t * hist, int pct)
+{
+    u_int32_t total = 0, n = 0;
+    int b;
+
+    for (b = 0; b < DISC_LAT_BUCKETS; b++)
+	total += hist[b];
+
+    if (total == 0)
+	return -1;
+
+    for (b = 0; b < DISC_LAT_BUCKETS; b++) {
+	n += hist[b];
+	if (n * 100 >= total * pct)
+	    break;
+    }
+    return disc_lat_bucket_start(b);
+}
+
+/* Measure NODE_TRAVERSAL_TIME. The time from sending a RREQ until
+   the route is found, divided by twice the hop count, is one per hop
+   sample. As in TCP, only discoveries answered by their first RREQ are
+   sampled (Karn), and node_traversal_time is set to the smoothed
+   value plus four mean deviations, bounded by NODE_TRAVERSAL_TIME_MIN
+   and NODE_TRAVERSAL_TIME_MAX. RREPs from intermediate nodes make the
+   sample a bit low, which the deviation term makes up for. */
+NS_STATIC void NS_CLASS seek_list_rtt_sample(seek_list_t * entry,
+					     u_int8_t hcnt)
+{
+    struct timeval now;
+    long sample, ntt;
+
+    if (hcnt == 0)
+	return;
+
+    gettimeofday(&now, NULL);
+
+    sample = ((now.tv_sec - entry->rreq_time.tv_sec) * 1000000 +
+	      (now.tv_usec - entry->rreq_time.tv_usec)) / (2 * hcnt);
+
+    if (sample < 0)
+	return;
+
+    if (ntt_srtt == 0) {
+	ntt_srtt = sample;
+	ntt_rttvar = sample / 2;
+    } else {
+	ntt_rttvar += ((sample > ntt_srtt ? sample - ntt_srtt :
+			ntt_srtt - sample) - ntt_rttvar) / 4;
+	ntt_srtt += (sample - ntt_srtt) / 8;
+    }
+
+    ntt = (ntt_srtt + 4 * ntt_rttvar + 999) / 1000;
+
+    if (ntt < NODE_TRAVERSAL_TIME_MIN)
+	ntt = NODE_TRAVERSAL_TIME_MIN;
+    else if (ntt > NODE_TRAVERSAL_TIME_MAX)
+	ntt = NODE_TRAVERSAL_TIME_MAX;
+
+    if (ntt != node_traversal_time)
+	DEBUG(LOG_DEBUG, 0, "NODE_TRAVERSAL_TIME %d -> %ld msecs",
+	      node_traversal_time, ntt);
+
+    node_traversal_time = ntt;
+}
+
+/* TTL for the first RREQ to dest_addr, based on earlier discoveries,
+   or 0 if there is no useful history. The guess is the last hop count
+   plus one, widened by TTL_INCREMENT for every failed discovery
+   since. */
+int NS_CLASS seek_list_hist_ttl(struct in_addr dest_addr)
+{
+    struct disc_hist *h;
+    int ttl;
+
+    h = &disc_hist[(hash_addr(&dest_addr) >> 16) & DISC_HIST_MASK];
+
+    if (h->dest_addr.s_addr != dest_addr.s_addr || h->hcnt == 0)
+	return 0;
+
+    ttl = h->hcnt + 1 + h->fails * TTL_INCREMENT;
+
+    if (ttl >= TTL_THRESHOLD)
+	return 0;
+
+    return ttl;
+}
+
+void NS_CLASS seek_list_hist_update(struct in_addr dest_addr, u_int8_t hcnt,
+				    int success)
+{
+    struct disc_hist *h;
+
+    h = &disc_hist[(hash_addr(&dest_addr) >> 16) & DISC_HIST_MASK];
+
+    if (success) {
+	h->dest_addr = dest_addr;
+	h->hcnt = hcnt;
+	h->fails = 0;
+    } else {
+	disc_stats.failed++;
+
+	if (h->dest_addr.s_addr == dest_addr.s_addr && h->fails < 255)
+	    h->fails++;
+    }
+}
+
 #ifdef SEEK_LIST_DEBUG
 void NS_CLASS seek_list_print()
 {
     list_t *pos;
+    int i;
 
-    list_foreach(pos, &seekhead) {
-	seek_list_t *entry = (seek_list_t *) pos;
-	printf("%s %u %d %d\n", ip_to_str(entry->dest_addr),
-	       entry->dest_seqno, entry->reqs, entry->ttl);
+    for (i = 0; i < RT_TABLESIZE; i++) {
+	list_foreach(pos, &seek_tbl[i]) {
+	    seek_list_t *entry = (seek_list_t *) pos;
+	    printf("%s %u %d %d\n", ip_to_str(entry->dest_addr),
+		   entry->dest_seqno, entry->reqs, entry->ttl);
+	}
     }
 }
 #endif
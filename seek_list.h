@@ -44,15 +44,100 @@ typedef struct seek_list {
     u_int8_t flags;		/* The flags we are using for resending the RREQ */
     int reqs;
     int ttl;
+    int rreqs;			/* Number of RREQs sent (attempts) */
+    struct timeval rreq_time;	/* When the last RREQ was sent */
+    struct timeval start_time;	/* When the discovery was asked for,
+				   0 if it is not measured */
+    u_int8_t preempt;		/* Preemptive, see rreq_preempt() */
     struct timer seek_timer;
 } seek_list_t;
+
+/* Discovery history. Remembers the outcome of the last route
+   discovery for a destination, also after the route is deleted, so
+   that the next discovery can start with a good TTL guess. The table
+   is direct mapped, a colliding destination replaces the old one. */
+#define DISC_HIST_SIZE 256	/* Must be a power of 2 */
+#define DISC_HIST_MASK (DISC_HIST_SIZE - 1)
+
+struct disc_hist {
+    struct in_addr dest_addr;	/* 0 if unused */
+    u_int8_t hcnt;		/* Hop count found last time */
+    u_int8_t fails;		/* Failed discoveries since then */
+};
+
+struct disc_stats {
+    u_int32_t started;		/* Route discoveries started */
+    u_int32_t first_try;	/* ...that succeeded with the first RREQ */
+    u_int32_t predicted;	/* ...that started with a TTL from history */
+    u_int32_t failed;
+    u_int32_t cached;		/* Answered from overheard routes, no RREQ */
+};
+
+/* Route discovery latency, from the start of a discovery until the
+   route is installed or the discovery is given up. Histograms are log
+   linear in msecs: exact below 8, then four buckets per power of
+   two. */
+#define DISC_LAT_BUCKETS 64
+#define DISC_HOPS_MAX 8		/* Last hop count bucket is "8 or more" */
+#define DISC_ATTEMPTS_MAX 8
+
+#define DISC_FIRST_TRY 0	/* Found with the first RREQ */
+#define DISC_RETRIED   1	/* Found after more RREQs */
+#define DISC_FAILED    2	/* No route found */
+#define DISC_CACHED    3	/* Overheard route, counted at 0 msecs */
+#define DISC_OUTCOMES  4
+
+struct disc_lat {
+    u_int32_t outcome[DISC_OUTCOMES][DISC_LAT_BUCKETS];
+    u_int32_t hops[DISC_HOPS_MAX][DISC_LAT_BUCKETS];	/* Found routes */
+    u_int32_t attempts[DISC_ATTEMPTS_MAX];	/* By number of RREQs sent */
+};
+
+static inline int disc_lat_bucket(long msecs)
+{
+    int e = 0, b;
+
+    if (msecs < 8)
+	return msecs < 0 ? 0 : msecs;
+
+    /* Shift msecs into [4, 8), the remainder picks one of four */
+    while ((msecs >> e) >= 8)
+	e++;
+
+    b = 8 + (e - 1) * 4 + (msecs >> e) - 4;
+
+    return b < DISC_LAT_BUCKETS ? b : DISC_LAT_BUCKETS - 1;
+}
+
+/* Lowest msecs value counted in a bucket */
+static inline long disc_lat_bucket_start(int b)
+{
+    if (b < 8)
+	return b;
+
+    return (long) (4 + (b - 8) % 4) << ((b - 8) / 4 + 1);
+}
 #endif				/* NS_NO_GLOBALS */
 
 #ifndef NS_NO_DECLARATIONS
+void seek_list_init();
 seek_list_t *seek_list_insert(struct in_addr dest_addr, u_int32_t dest_seqno,
 			      int ttl, u_int8_t flags, struct ip_data *ipd);
 int seek_list_remove(seek_list_t * entry);
 seek_list_t *seek_list_find(struct in_addr dest_addr);
+int seek_list_count();
+long seek_list_lat_pct(u_int32_t * hist, int pct);
+int seek_list_found(struct in_addr dest_addr, u_int8_t hcnt);
+void seek_list_preempt_clear(seek_list_t * entry);
+int seek_list_hist_ttl(struct in_addr dest_addr);
+void seek_list_hist_update(struct in_addr dest_addr, u_int8_t hcnt,
+			   int success);
+
+void seek_list_lat_record(seek_list_t * entry, u_int8_t hcnt, int outcome);
+
+#ifdef NS_PORT
+void seek_list_rtt_sample(seek_list_t * entry, u_int8_t hcnt);
+#endif
 
 #ifdef NS_PORT
 #ifdef SEEK_LIST_DEBUG
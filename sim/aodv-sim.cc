@@ -0,0 +1,774 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* aodv-sim: a headless discrete event simulator for AODV-UU.
+ *
+ * Each node runs the unmodified NS_PORT agent (ns-2/aodv-uu.cc and the
+ * protocol sources) on top of the ns-2 stand-in in ns/ns-shim.h. The
+ * radio is a unit disk with optional random loss: a transmission takes
+ * size / bandwidth seconds and reaches every node within range. There
+ * is no contention or collisions, so absolute delays are optimistic,
+ * but the protocol sees the same packets, timers and link layer
+ * feedback as under ns-2, at a small fraction of the cost.
+ *
+ * Nodes are static, move by random waypoint, or follow an ns-2
+ * "setdest" movement file. Traffic is CBR between random pairs. */
+
+#include <sys/time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <vector>
+#include <algorithm>
+
+#include "../ns-2/aodv-uu.h"
+
+#define MAC_HDR_LEN   52	/* 802.11 header and PLCP, in bytes */
+#define MAC_RETRIES   4		/* Unicast attempts before giving up */
+#define GRID_INTERVAL 1.0	/* Seconds between neighbor grid rebuilds */
+#define MAX_DROP_REASONS 16
+#define LOOP_INTERVAL 0.5	/* Seconds between routing loop checks */
+
+/* Defaults for the bound agent variables, from ns-default.tcl */
+static const struct {
+    const char *name;
+    int value;
+} aodvuu_defaults[] = {
+#include "aodvuu-defaults.h"
+};
+
+/* Simulation parameters */
+static int nnodes = 50;
+static double sim_time = 100.0;
+static double range = 250.0;
+static double area_x, area_y;
+static double degree = 10.0;	/* Sizes the default area */
+static double loss;
+static double bandwidth = 2e6;
+static double max_speed, min_speed = 1.0, pause_time = 10.0;
+static const char *movement_file;
+static int nflows = 10;
+static double rate = 4.0;
+static int pkt_size = 512;
+static unsigned long seed = 1;
+static const char *log_dir;
+
+/* Results */
+static struct {
+    unsigned long data_sent, data_recv, data_tx;
+    double delay_sum;
+    unsigned long hops_sum;
+    unsigned long ctrl_tx[5], ctrl_bytes;
+    unsigned long mac_lost, link_breaks;
+    unsigned long rt_loops;
+    const char *drop_why[MAX_DROP_REASONS];
+    unsigned long drops[MAX_DROP_REASONS];
+} res;
+
+static const char *ctrl_names[] = { "hello", "rreq", "rrep", "rerr",
+    "rrep_ack"
+};
+
+static double now()
+{
+    return Scheduler::instance().clock();
+}
+
+/* Nodes */
+
+struct SimNode;
+static std::vector<SimNode *> nodes;
+
+/* Transmits packets handed down by the agent */
+class LinkLayer : public NsObject {
+public:
+    LinkLayer(SimNode *n) : node_(n) {}
+    virtual void recv(Packet *p, Handler *h = 0);
+private:
+    SimNode *node_;
+};
+
+/* Delivers packets to the agent at the end of a transmission */
+class Receiver : public NsObject {
+public:
+    Receiver(SimNode *n) : node_(n) {}
+    virtual void recv(Packet *p, Handler *h = 0);
+private:
+    SimNode *node_;
+};
+
+/* Reports unicast transmission failures back to the agent */
+class Feedback : public NsObject {
+public:
+    virtual void recv(Packet *p, Handler *h = 0) {
+	HDR_CMN(p)->xmit_failure_(p, HDR_CMN(p)->xmit_failure_data_);
+    }
+};
+
+/* Target and drop target of the agent */
+class Sink : public NsObject {
+public:
+    virtual void recv(Packet *p, Handler *h = 0);
+    virtual void recv(Packet *p, const char *why);
+};
+
+static Sink sink;
+static Feedback feedback;
+
+class MoveTimer : public TimerHandler {
+public:
+    MoveTimer(SimNode *n) : node_(n) {}
+protected:
+    virtual void expire(Event *e);
+private:
+    SimNode *node_;
+};
+
+struct SimNode {
+    SimNode(int i) : id(i), ll(this), rx(this), move(this) {
+	x0 = y0 = t0 = t1 = vx = vy = 0;
+    }
+
+    /* Position now. The node moves in a straight line from (x0, y0)
+       starting at t0 and stops at t1. */
+    void pos(double *x, double *y) const {
+	double t = now() < t1 ? now() : t1;
+	*x = x0 + vx * (t - t0);
+	*y = y0 + vy * (t - t0);
+    }
+    void setdest(double x, double y, double speed) {
+	double d;
+
+	pos(&x0, &y0);
+	t0 = now();
+	d = hypot(x - x0, y - y0);
+	if (d == 0 || speed <= 0) {
+	    vx = vy = 0;
+	    t1 = t0;
+	    return;
+	}
+	vx = (x - x0) / d * speed;
+	vy = (y - y0) / d * speed;
+	t1 = t0 + d / speed;
+    }
+
+    int id;
+    nsaddr_t addr;
+    AODVUU *agent;
+    LinkLayer ll;
+    Receiver rx;
+    MoveTimer move;
+    double x0, y0, t0, t1, vx, vy;
+    int gx, gy;			/* Grid cell */
+};
+
+static SimNode *node_by_addr(nsaddr_t addr)
+{
+    if (addr < 1 || addr > nnodes)
+	return 0;
+    return nodes[addr - 1];
+}
+
+/* Neighbor grid. Cells are large enough that nobody can move into
+   range from outside the surrounding cells between two rebuilds. */
+static double cell;
+static int grid_w, grid_h;
+static std::vector<std::vector<SimNode *> > grid;
+
+static void grid_build()
+{
+    double x, y;
+    int i;
+
+    for (i = 0; i < (int) grid.size(); i++)
+	grid[i].clear();
+
+    for (i = 0; i < nnodes; i++) {
+	SimNode *n = nodes[i];
+	n->pos(&x, &y);
+	n->gx = (int) (x / cell);
+	n->gy = (int) (y / cell);
+	if (n->gx < 0)
+	    n->gx = 0;
+	if (n->gx >= grid_w)
+	    n->gx = grid_w - 1;
+	if (n->gy < 0)
+	    n->gy = 0;
+	if (n->gy >= grid_h)
+	    n->gy = grid_h - 1;
+	grid[n->gy * grid_w + n->gx].push_back(n);
+    }
+}
+
+static bool in_range(SimNode *a, SimNode *b)
+{
+    double ax, ay, bx, by;
+
+    a->pos(&ax, &ay);
+    b->pos(&bx, &by);
+    return (ax - bx) * (ax - bx) + (ay - by) * (ay - by) <= range * range;
+}
+
+class GridTimer : public TimerHandler {
+protected:
+    virtual void expire(Event *e) {
+	grid_build();
+	resched(GRID_INTERVAL);
+    }
+} grid_timer;
+
+/* Radio */
+
+void LinkLayer::recv(Packet *p, Handler *h)
+{
+    hdr_cmn *ch = HDR_CMN(p);
+    hdr_ip *ih = HDR_IP(p);
+    double tx_time = (ch->size() + MAC_HDR_LEN) * 8.0 / bandwidth;
+
+    if (ch->ptype() == PT_AODVUU) {
+	int type = HDR_AODVUU(p)->type;
+
+	if (type == AODV_RREP && ih->daddr() == (nsaddr_t) AODV_BROADCAST)
+	    type = AODV_HELLO;
+	if (type >= 0 && type <= AODV_RREP_ACK)
+	    res.ctrl_tx[type]++;
+	res.ctrl_bytes += ch->size();
+    } else if (DATA_PACKET(ch->ptype()))
+	res.data_tx++;
+
+    if (ch->next_hop_ == 0 || ch->next_hop_ == IP_BROADCAST) {
+	int x, y;
+
+	for (y = node_->gy - 1; y <= node_->gy + 1; y++) {
+	    if (y < 0 || y >= grid_h)
+		continue;
+	    for (x = node_->gx - 1; x <= node_->gx + 1; x++) {
+		std::vector<SimNode *> &c = grid[y * grid_w + x];
+		unsigned int i;
+
+		if (x < 0 || x >= grid_w)
+		    continue;
+		for (i = 0; i < c.size(); i++) {
+		    if (c[i] == node_ || !in_range(node_, c[i]))
+			continue;
+		    if (loss > 0 && Random::uniform() < loss) {
+			res.mac_lost++;
+			continue;
+		    }
+		    Scheduler::instance().schedule(&c[i]->rx, p->copy(),
+						   tx_time);
+		}
+	    }
+	}
+	Packet::free(p);
+	return;
+    }
+
+    SimNode *nh = node_by_addr(ch->next_hop_);
+    int tries = 1;
+
+    /* Unicast is retried like the 802.11 MAC does, and the link layer
+       reports a failure only when all attempts are lost. */
+    if (nh && in_range(node_, nh)) {
+	while (loss > 0 && Random::uniform() < loss) {
+	    if (++tries > MAC_RETRIES)
+		break;
+	}
+	if (tries <= MAC_RETRIES) {
+	    Scheduler::instance().schedule(&nh->rx, p, tries * tx_time);
+	    return;
+	}
+	tries = MAC_RETRIES;
+    }
+    res.link_breaks++;
+
+    if (ch->xmit_failure_) {
+	/* Tell the agent after the time spent retrying */
+	Scheduler::instance().schedule(&feedback, p, tries * tx_time);
+    } else
+	sink.recv(p, DROP_MAC_RETRY_COUNT_EXCEEDED);
+}
+
+void Receiver::recv(Packet *p, Handler *h)
+{
+    hdr_cmn *ch = HDR_CMN(p);
+
+    ch->direction() = hdr_cmn::UP;
+    ch->num_forwards()++;
+    node_->agent->recv(p, 0);
+}
+
+void Sink::recv(Packet *p, Handler *h)
+{
+    hdr_cmn *ch = HDR_CMN(p);
+
+    if (DATA_PACKET(ch->ptype())) {
+	res.data_recv++;
+	res.delay_sum += now() - ch->timestamp();
+	res.hops_sum += ch->num_forwards();
+    }
+    Packet::free(p);
+}
+
+void Sink::recv(Packet *p, const char *why)
+{
+    int i;
+
+    if (!why)
+	why = "-";
+
+    for (i = 0; i < MAX_DROP_REASONS; i++) {
+	if (!res.drop_why[i])
+	    res.drop_why[i] = why;
+	if (strcmp(res.drop_why[i], why) == 0) {
+	    res.drops[i]++;
+	    break;
+	}
+    }
+    Packet::free(p);
+}
+
+/* Mobility */
+
+void MoveTimer::expire(Event *e)
+{
+    double speed = min_speed + Random::uniform() * (max_speed - min_speed);
+
+    /* Random waypoint: go to a new point, then pause */
+    node_->setdest(Random::uniform() * area_x, Random::uniform() * area_y,
+		   speed);
+    resched(node_->t1 - node_->t0 + pause_time);
+}
+
+struct MoveEvent {
+    double time;
+    int node;
+    double x, y, speed;
+};
+
+static std::vector<MoveEvent> trace;
+
+class TraceTimer : public TimerHandler {
+public:
+    TraceTimer() : next_(0) {}
+protected:
+    virtual void expire(Event *e) {
+	while (next_ < trace.size() && trace[next_].time <= now()) {
+	    MoveEvent &m = trace[next_++];
+	    nodes[m.node]->setdest(m.x, m.y, m.speed);
+	}
+	if (next_ < trace.size())
+	    resched(trace[next_].time - now());
+    }
+private:
+    unsigned int next_;
+} trace_timer;
+
+static bool move_cmp(const MoveEvent &a, const MoveEvent &b)
+{
+    return a.time < b.time;
+}
+
+/* Reads an ns-2 movement file, as written by setdest. Returns the
+   highest speed found, or -1 on error. */
+static double movement_read(const char *file)
+{
+    FILE *f;
+    char line[256];
+    double max = 0;
+    int lineno = 0;
+
+    if (!(f = fopen(file, "r"))) {
+	perror(file);
+	return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+	MoveEvent m;
+	char c;
+	double v;
+
+	lineno++;
+
+	if (sscanf(line, " $node_(%d) set %c_ %lf", &m.node, &c, &v) == 3) {
+	    if (m.node < 0 || m.node >= nnodes)
+		continue;
+	    if (c == 'X')
+		nodes[m.node]->x0 = v;
+	    else if (c == 'Y')
+		nodes[m.node]->y0 = v;
+	} else if (sscanf(line, " $ns_ at %lf \"$node_(%d) setdest %lf %lf %lf",
+			  &m.time, &m.node, &m.x, &m.y, &m.speed) == 5) {
+	    if (m.node < 0 || m.node >= nnodes)
+		continue;
+	    if (m.speed > max)
+		max = m.speed;
+	    trace.push_back(m);
+	} else if (line[0] != '#' && line[0] != '\n' &&
+		   !strstr(line, "$god_")) {
+	    fprintf(stderr, "%s:%d: unknown movement command\n", file,
+		    lineno);
+	}
+    }
+    fclose(f);
+    std::stable_sort(trace.begin(), trace.end(), move_cmp);
+    return max;
+}
+
+/* Traffic */
+
+class Flow : public TimerHandler {
+public:
+    Flow(SimNode *src, SimNode *dst, double stop)
+    : src_(src), dst_(dst), stop_(stop) {}
+protected:
+    virtual void expire(Event *e);
+private:
+    SimNode *src_, *dst_;
+    double stop_;
+};
+
+void Flow::expire(Event *e)
+{
+    Packet *p = Packet::alloc();
+    hdr_cmn *ch = HDR_CMN(p);
+    hdr_ip *ih = HDR_IP(p);
+
+    ch->ptype() = PT_CBR;
+    ch->size() = pkt_size;
+    ch->uid() = Packet::uidcnt_++;
+    ch->timestamp() = now();
+    ch->direction() = hdr_cmn::DOWN;
+    ch->num_forwards() = 0;
+    ih->saddr() = src_->addr;
+    ih->daddr() = dst_->addr;
+    ih->sport() = 0;
+    ih->dport() = 0;
+    ih->ttl() = 32;
+
+    res.data_sent++;
+    src_->agent->recv(p, 0);
+
+    if (now() + 1.0 / rate < stop_)
+	resched(1.0 / rate);
+}
+
+static std::vector<Flow *> flows;
+static std::vector<nsaddr_t> flow_dsts;
+
+/* Routing loop check. Every LOOP_INTERVAL, the next hops of all nodes
+   towards each flow destination are followed from every node, and each
+   node whose path runs into a circle instead of reaching the
+   destination counts once. */
+class LoopTimer : public TimerHandler {
+protected:
+    virtual void expire(Event *e);
+} loop_timer;
+
+void LoopTimer::expire(Event *e)
+{
+    std::vector<int> seen(nnodes + 1, -1);
+    unsigned int d;
+    int i, mark = 0;
+
+    for (d = 0; d < flow_dsts.size(); d++) {
+	for (i = 0; i < nnodes; i++, mark++) {
+	    nsaddr_t a = nodes[i]->addr;
+
+	    while (a != flow_dsts[d] && seen[a] != mark) {
+		seen[a] = mark;
+		a = node_by_addr(a)->agent->nextHop(flow_dsts[d]);
+		if (!node_by_addr(a))
+		    break;
+	    }
+	    if (node_by_addr(a) && a != flow_dsts[d])
+		res.rt_loops++;
+	}
+    }
+    resched(LOOP_INTERVAL);
+}
+
+/* Setup */
+
+static int agent_cmd(AODVUU *a, const char *cmd, const char *arg)
+{
+    const char *argv[] = { "agent", cmd, arg, 0 };
+
+    return a->command(arg ? 3 : 2, argv);
+}
+
+static int set_option(char *opt)
+{
+    char *val = strchr(opt, '=');
+    char name[64];
+    unsigned int i;
+
+    if (!val)
+	return -1;
+    *val++ = '\0';
+
+    /* The trailing underscore of the Tcl name is optional */
+    snprintf(name, sizeof(name), "%s%s", opt,
+	     opt[strlen(opt) - 1] == '_' ? "" : "_");
+
+    for (i = 0; i < sizeof(aodvuu_defaults) / sizeof(aodvuu_defaults[0]);
+	 i++) {
+	if (strcmp(aodvuu_defaults[i].name, name) == 0) {
+	    TclObject::set_default(name, atoi(val));
+	    return 0;
+	}
+    }
+    return -1;
+}
+
+static void usage(const char *progname, int status)
+{
+    fprintf(stderr,
+	    "Usage: %s [-n NODES] [-t SECONDS] [-s SEED] [-r RANGE]\n"
+	    "       [-x WIDTH -y HEIGHT | -d DEGREE] [-l LOSS] [-b BPS]\n"
+	    "       [-m SPEED [-p PAUSE] | -M MOVEMENT_FILE]\n"
+	    "       [-f FLOWS] [-R PKTS_PER_SEC] [-S BYTES] [-o OPTION=VALUE]...\n"
+	    "       [-L LOG_DIR]\n\n"
+	    "-n  Number of nodes (default %d)\n"
+	    "-t  Simulated time in seconds (default %.0f)\n"
+	    "-s  Random seed (default %lu)\n"
+	    "-r  Radio range in meters (default %.0f)\n"
+	    "-x  Area width, -y area height in meters. The default is a\n"
+	    "    square giving -d neighbors per node on average (default %.0f)\n"
+	    "-l  Loss probability per link layer transmission (default 0)\n"
+	    "-b  Link bandwidth in bits per second (default %.0f)\n"
+	    "-m  Random waypoint with speeds up to SPEED m/s, -p pause in\n"
+	    "    seconds (default %.0f). Nodes are static by default\n"
+	    "-M  Read node movement from an ns-2 setdest file\n"
+	    "-f  Number of CBR flows (default %d)\n"
+	    "-R  Packets per second per flow (default %.0f)\n"
+	    "-S  Data packet size (default %d)\n"
+	    "-o  Set an AODV-UU option, using the ns-2 name, e.g.\n"
+	    "    -o expanding_ring_search=0\n"
+	    "-L  Directory for the per-node log files (default .)\n",
+	    progname, nnodes, sim_time, seed, range, degree, bandwidth,
+	    pause_time, nflows, rate, pkt_size);
+    exit(status);
+}
+
+int main(int argc, char **argv)
+{
+    struct timespec ts0, ts1;
+    unsigned long events;
+    double wall, max_move = 0;
+    unsigned int i;
+    char buf[PATH_MAX];
+    int opt;
+
+    for (i = 0; i < sizeof(aodvuu_defaults) / sizeof(aodvuu_defaults[0]);
+	 i++)
+	TclObject::set_default(aodvuu_defaults[i].name,
+			       aodvuu_defaults[i].value);
+
+    while ((opt = getopt(argc, argv, "n:t:s:r:x:y:d:l:b:m:p:M:f:R:S:o:L:h"))
+	   != -1) {
+	switch (opt) {
+	case 'n':
+	    nnodes = atoi(optarg);
+	    break;
+	case 't':
+	    sim_time = atof(optarg);
+	    break;
+	case 's':
+	    seed = strtoul(optarg, NULL, 0);
+	    break;
+	case 'r':
+	    range = atof(optarg);
+	    break;
+	case 'x':
+	    area_x = atof(optarg);
+	    break;
+	case 'y':
+	    area_y = atof(optarg);
+	    break;
+	case 'd':
+	    degree = atof(optarg);
+	    break;
+	case 'l':
+	    loss = atof(optarg);
+	    break;
+	case 'b':
+	    bandwidth = atof(optarg);
+	    break;
+	case 'm':
+	    max_speed = atof(optarg);
+	    break;
+	case 'p':
+	    pause_time = atof(optarg);
+	    break;
+	case 'M':
+	    movement_file = optarg;
+	    break;
+	case 'f':
+	    nflows = atoi(optarg);
+	    break;
+	case 'R':
+	    rate = atof(optarg);
+	    break;
+	case 'S':
+	    pkt_size = atoi(optarg);
+	    break;
+	case 'o':
+	    if (set_option(optarg) < 0) {
+		fprintf(stderr, "Unknown option setting %s\n", optarg);
+		exit(1);
+	    }
+	    break;
+	case 'L':
+	    log_dir = optarg;
+	    break;
+	case 'h':
+	    usage(argv[0], 0);
+	default:
+	    usage(argv[0], 1);
+	}
+    }
+
+    if (nnodes < 2 || nflows < 0 || sim_time <= 0 || range <= 0 || rate <= 0 ||
+	bandwidth <= 0 || loss < 0 || loss >= 1 || degree <= 0)
+	usage(argv[0], 1);
+
+    if (area_x <= 0 || area_y <= 0)
+	area_x = area_y = sqrt(nnodes * M_PI * range * range / degree);
+    if (min_speed > max_speed)
+	min_speed = max_speed;
+
+    Random::seed(seed);
+    TclObject::enter("_sink", &sink);
+
+    for (i = 0; i < (unsigned int) nnodes; i++) {
+	SimNode *n = new SimNode(i);
+
+	n->addr = i + 1;
+	n->agent = new AODVUU(n->addr);
+	n->x0 = Random::uniform() * area_x;
+	n->y0 = Random::uniform() * area_y;
+	nodes.push_back(n);
+    }
+
+    if (movement_file && (max_move = movement_read(movement_file)) < 0)
+	exit(1);
+
+    for (i = 0; i < nodes.size(); i++) {
+	SimNode *n = nodes[i];
+
+	sprintf(buf, "_o%u", i);
+	TclObject::enter(buf, &n->ll);
+	sprintf(buf, "%d", n->addr);
+	agent_cmd(n->agent, "addr", buf);
+	if (log_dir) {
+	    snprintf(buf, sizeof(buf), "%s/" AODV_LOG_PATH_PREFIX, log_dir);
+	    if (agent_cmd(n->agent, "log-prefix", buf) != TCL_OK)
+		exit(1);
+	}
+	sprintf(buf, "_o%u", i);
+	agent_cmd(n->agent, "add-ll", buf);
+	agent_cmd(n->agent, "target", "_sink");
+	agent_cmd(n->agent, "drop-target", "_sink");
+	agent_cmd(n->agent, "start", 0);
+    }
+
+    if (!movement_file && max_speed > 0) {
+	max_move = max_speed;
+	for (i = 0; i < nodes.size(); i++)
+	    nodes[i]->move.sched(Random::uniform() * pause_time);
+    } else if (trace.size())
+	trace_timer.sched(trace[0].time);
+
+    cell = range + 2 * max_move * GRID_INTERVAL;
+    grid_w = (int) ceil(area_x / cell);
+    grid_h = (int) ceil(area_y / cell);
+    if (grid_w < 1)
+	grid_w = 1;
+    if (grid_h < 1)
+	grid_h = 1;
+    grid.resize(grid_w * grid_h);
+    grid_build();
+    if (max_move > 0)
+	grid_timer.sched(GRID_INTERVAL);
+
+    for (i = 0; i < (unsigned int) nflows; i++) {
+	SimNode *src = nodes[Random::integer(nnodes)];
+	SimNode *dst;
+	Flow *f;
+
+	do
+	    dst = nodes[Random::integer(nnodes)];
+	while (dst == src);
+
+	f = new Flow(src, dst, sim_time);
+	f->sched(1.0 + Random::uniform() * (sim_time / 10 < 10 ?
+					   sim_time / 10 : 10));
+	flows.push_back(f);
+	flow_dsts.push_back(dst->addr);
+    }
+    if (nflows)
+	loop_timer.sched(LOOP_INTERVAL);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts0);
+    events = Scheduler::instance().run(sim_time);
+    clock_gettime(CLOCK_MONOTONIC, &ts1);
+    wall = (ts1.tv_sec - ts0.tv_sec) + (ts1.tv_nsec - ts0.tv_nsec) / 1e9;
+
+    unsigned long ctrl = 0;
+
+    for (i = 0; i < 5; i++)
+	ctrl += res.ctrl_tx[i];
+
+    printf("nodes %d\n", nnodes);
+    printf("area %.0fx%.0f\n", area_x, area_y);
+    printf("sim_time %.3f\n", sim_time);
+    printf("seed %lu\n", seed);
+    printf("wall_time %.3f\n", wall);
+    printf("events %lu\n", events);
+    printf("events_per_sec %.0f\n", wall > 0 ? events / wall : 0);
+    printf("speedup %.1f\n", wall > 0 ? sim_time / wall : 0);
+    printf("data_sent %lu\n", res.data_sent);
+    printf("data_recv %lu\n", res.data_recv);
+    printf("pdr %.4f\n", res.data_sent ?
+	   (double) res.data_recv / res.data_sent : 0);
+    printf("delay_ms %.3f\n", res.data_recv ?
+	   res.delay_sum / res.data_recv * 1000 : 0);
+    printf("hops %.3f\n", res.data_recv ?
+	   (double) res.hops_sum / res.data_recv : 0);
+    printf("data_tx %lu\n", res.data_tx);
+    printf("ctrl_tx %lu\n", ctrl);
+    for (i = 0; i < 5; i++)
+	printf("ctrl_tx_%s %lu\n", ctrl_names[i], res.ctrl_tx[i]);
+    printf("ctrl_bytes %lu\n", res.ctrl_bytes);
+    printf("nrl %.4f\n", res.data_recv ? (double) ctrl / res.data_recv : 0);
+    printf("mac_lost %lu\n", res.mac_lost);
+    printf("link_breaks %lu\n", res.link_breaks);
+    printf("rt_loops %lu\n", res.rt_loops);
+    for (i = 0; i < MAX_DROP_REASONS && res.drop_why[i]; i++)
+	printf("drop_%s %lu\n", res.drop_why[i], res.drops[i]);
+
+    return 0;
+}
@@ -0,0 +1,791 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+
+/* aodv-sweep: runs a matrix of aodv-sim scenarios on all cores.
+ *
+ * The matrix file has one parameter per line, a name followed by the
+ * values to try:
+ *
+ *   # TTL_START against network size
+ *   nodes      50 100 200
+ *   ttl_start  1 2 3
+ *   speed      10
+ *   ratelimit  0 1
+ *   reps       5
+ *
+ * Every combination is run "reps" times (default 1). Names that are not
+ * aodv-sim options are passed as "-o name=value". Run r of every
+ * combination gets seed "seed" + r, so scenarios are compared on the
+ * same random node placements, movements and flows.
+ *
+ * "check" lines turn a matrix into a regression test. Each compares a
+ * metric, aggregated over the runs that succeeded, with a number or
+ * with another metric, optionally scaled or offset:
+ *
+ *   check max:rt_loops == 0
+ *   check pdr{preemptive_repair=1} >= pdr{preemptive_repair=0} - 0.01
+ *
+ * The aggregate is mean (the default), min or max, and the braces
+ * select the runs with the given parameter values. The operators are
+ * <, <=, >, >=, == and !=, and the right hand side may be followed by
+ * "+ N", "- N" or "* N". A failed check makes the exit status 3.
+ *
+ * Runs are handed out round robin to one queue per worker. A worker
+ * takes its own runs from the back of its queue and, when it has none
+ * left, steals from the front of the others. Each run writes to its own
+ * directory (stdout, stderr and any per-node logs), and when all are
+ * done the metrics are merged into one tab separated file with a
+ * column per parameter and metric. */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+/* Parameters that map to aodv-sim options */
+static const struct {
+    const char *name;
+    const char *flag;
+} sim_params[] = {
+    { "nodes", "-n" },
+    { "time", "-t" },
+    { "range", "-r" },
+    { "width", "-x" },
+    { "height", "-y" },
+    { "degree", "-d" },
+    { "loss", "-l" },
+    { "bandwidth", "-b" },
+    { "speed", "-m" },
+    { "pause", "-p" },
+    { "movement", "-M" },
+    { "flows", "-f" },
+    { "rate", "-R" },
+    { "size", "-S" },
+};
+
+struct Param {
+    string name;
+    vector<string> values;
+};
+
+struct Run {
+    int id;
+    int rep;
+    unsigned long seed;
+    vector<string> values;	/* One per parameter */
+    string dir;
+    vector<string> args;
+    int status;
+    double wall;
+    vector<std::pair<string, string> > metrics;
+};
+
+struct Operand {
+    int is_num;
+    double num;
+    string agg;
+    string metric;
+    vector<std::pair<string, string> > where;
+};
+
+struct Check {
+    string text;
+    int lineno;
+    Operand lhs;
+    string op;
+    Operand rhs;
+    char arith;		/* '+', '-', '*' or 0 */
+    double n;
+};
+
+struct Worker {
+    std::mutex lock;
+    std::deque<Run *> runs;
+};
+
+static vector<Param> params;
+static vector<Run> runs;
+static vector<Check> checks;
+static vector<Worker *> workers;
+static int reps = 1;
+static unsigned long base_seed = 1;
+static int ndone;
+static std::mutex print_lock;
+
+static int param_index(const string &name)
+{
+    unsigned int i;
+
+    for (i = 0; i < params.size(); i++)
+	if (params[i].name == name)
+	    return i;
+    return -1;
+}
+
+static double now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Parses a number or [agg:]metric[{param=value,...}] */
+static int operand_parse(const char *s, Operand *o)
+{
+    const char *colon, *brace;
+    char *end;
+
+    o->num = strtod(s, &end);
+    if (end != s && *end == '\0') {
+	o->is_num = 1;
+	return 0;
+    }
+    o->is_num = 0;
+
+    colon = strchr(s, ':');
+    brace = strchr(s, '{');
+    if (colon && (!brace || colon < brace)) {
+	o->agg = string(s, colon - s);
+	s = colon + 1;
+    } else
+	o->agg = "mean";
+
+    if (o->agg != "mean" && o->agg != "min" && o->agg != "max")
+	return -1;
+
+    if (!(brace = strchr(s, '{'))) {
+	o->metric = s;
+	return o->metric.empty() ? -1 : 0;
+    }
+    o->metric = string(s, brace - s);
+    if (o->metric.empty() || s[strlen(s) - 1] != '}')
+	return -1;
+
+    string w(brace + 1, s + strlen(s) - 1);
+    size_t pos = 0;
+
+    while (pos <= w.size()) {
+	size_t comma = w.find(',', pos), eq;
+
+	if (comma == string::npos)
+	    comma = w.size();
+	string item = w.substr(pos, comma - pos);
+
+	if ((eq = item.find('=')) == string::npos || eq == 0)
+	    return -1;
+	o->where.push_back(std::make_pair(item.substr(0, eq),
+					  item.substr(eq + 1)));
+	pos = comma + 1;
+    }
+    return 0;
+}
+
+/* Parses the tokens after "check" */
+static int check_parse(char **tok, int ntok, Check *c)
+{
+    static const char *ops[] = { "<", "<=", ">", ">=", "==", "!=" };
+    unsigned int i;
+    char *end;
+
+    if (ntok != 3 && ntok != 5)
+	return -1;
+    if (operand_parse(tok[0], &c->lhs) < 0 ||
+	operand_parse(tok[2], &c->rhs) < 0)
+	return -1;
+
+    c->op = tok[1];
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++)
+	if (c->op == ops[i])
+	    break;
+    if (i == sizeof(ops) / sizeof(ops[0]))
+	return -1;
+
+    c->arith = 0;
+    c->n = 0;
+    if (ntok == 5) {
+	if (strlen(tok[3]) != 1 || !strchr("+-*", tok[3][0]))
+	    return -1;
+	c->arith = tok[3][0];
+	c->n = strtod(tok[4], &end);
+	if (end == tok[4] || *end != '\0')
+	    return -1;
+    }
+    for (i = 0; i < (unsigned int) ntok; i++)
+	c->text += string(i ? " " : "") + tok[i];
+    return 0;
+}
+
+static int matrix_read(const char *file)
+{
+    FILE *f;
+    char line[1024];
+    int lineno = 0;
+    unsigned int i, j, k;
+
+    if (!(f = fopen(file, "r"))) {
+	perror(file);
+	return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+	char *tok, *save;
+	Param p;
+
+	lineno++;
+
+	if ((tok = strchr(line, '#')))
+	    *tok = '\0';
+	if (!(tok = strtok_r(line, " \t\r\n=", &save)))
+	    continue;
+	p.name = tok;
+
+	if (p.name == "check") {
+	    char *args[8];
+	    int n = 0;
+	    Check c;
+
+	    while (n < 8 && (args[n] = strtok_r(NULL, " \t\r\n", &save)))
+		n++;
+	    if (check_parse(args, n, &c) < 0) {
+		fprintf(stderr, "%s:%d: bad check\n", file, lineno);
+		fclose(f);
+		return -1;
+	    }
+	    c.lineno = lineno;
+	    checks.push_back(c);
+	    continue;
+	}
+	while ((tok = strtok_r(NULL, " \t\r\n", &save)))
+	    if (strcmp(tok, "=") != 0)
+		p.values.push_back(tok);
+
+	if (p.values.empty()) {
+	    fprintf(stderr, "%s:%d: no values for %s\n", file, lineno,
+		    p.name.c_str());
+	    fclose(f);
+	    return -1;
+	}
+	if (p.name == "reps" || p.name == "seed") {
+	    if (p.values.size() != 1) {
+		fprintf(stderr, "%s:%d: %s takes one value\n", file, lineno,
+			p.name.c_str());
+		fclose(f);
+		return -1;
+	    }
+	    if (p.name == "reps")
+		reps = atoi(p.values[0].c_str());
+	    else
+		base_seed = strtoul(p.values[0].c_str(), NULL, 0);
+	    continue;
+	}
+	params.push_back(p);
+    }
+    fclose(f);
+
+    if (reps < 1) {
+	fprintf(stderr, "%s: reps must be at least 1\n", file);
+	return -1;
+    }
+    /* Checks may only select on parameters of the matrix */
+    for (i = 0; i < checks.size(); i++) {
+	const Operand *o[2] = { &checks[i].lhs, &checks[i].rhs };
+
+	for (j = 0; j < 2; j++) {
+	    for (k = 0; k < o[j]->where.size(); k++) {
+		if (param_index(o[j]->where[k].first) < 0) {
+		    fprintf(stderr, "%s:%d: unknown parameter %s\n", file,
+			    checks[i].lineno, o[j]->where[k].first.c_str());
+		    return -1;
+		}
+	    }
+	}
+    }
+    return 0;
+}
+
+/* Expands the matrix. The first parameter varies slowest, and the
+   repetitions of a combination are next to each other. */
+static void runs_build(const char *sim, const char *outdir)
+{
+    vector<unsigned int> idx(params.size(), 0);
+    char buf[PATH_MAX];
+
+    for (;;) {
+	int r;
+	int i;
+
+	for (r = 0; r < reps; r++) {
+	    Run run;
+	    unsigned int k, j;
+
+	    run.id = runs.size();
+	    run.rep = r;
+	    run.seed = base_seed + r;
+	    run.status = -1;
+	    run.wall = 0;
+	    snprintf(buf, sizeof(buf), "%s/run-%04d", outdir, run.id);
+	    run.dir = buf;
+
+	    run.args.push_back(sim);
+	    for (k = 0; k < params.size(); k++) {
+		const string &v = params[k].values[idx[k]];
+
+		run.values.push_back(v);
+
+		for (j = 0; j < sizeof(sim_params) / sizeof(sim_params[0]);
+		     j++)
+		    if (params[k].name == sim_params[j].name)
+			break;
+
+		if (j < sizeof(sim_params) / sizeof(sim_params[0])) {
+		    run.args.push_back(sim_params[j].flag);
+		    run.args.push_back(v);
+		} else {
+		    run.args.push_back("-o");
+		    run.args.push_back(params[k].name + "=" + v);
+		}
+	    }
+	    snprintf(buf, sizeof(buf), "%lu", run.seed);
+	    run.args.push_back("-s");
+	    run.args.push_back(buf);
+	    run.args.push_back("-L");
+	    run.args.push_back(run.dir);
+	    runs.push_back(run);
+	}
+
+	/* Next combination */
+	for (i = params.size() - 1; i >= 0; i--) {
+	    if (++idx[i] < params[i].values.size())
+		break;
+	    idx[i] = 0;
+	}
+	if (i < 0)
+	    break;
+    }
+}
+
+static Run *run_next(unsigned int self)
+{
+    unsigned int i;
+    Run *run;
+
+    {
+	std::lock_guard<std::mutex> l(workers[self]->lock);
+
+	if (!workers[self]->runs.empty()) {
+	    run = workers[self]->runs.back();
+	    workers[self]->runs.pop_back();
+	    return run;
+	}
+    }
+    /* Out of work, steal the oldest run of someone else */
+    for (i = 1; i < workers.size(); i++) {
+	Worker *w = workers[(self + i) % workers.size()];
+	std::lock_guard<std::mutex> l(w->lock);
+
+	if (!w->runs.empty()) {
+	    run = w->runs.front();
+	    w->runs.pop_front();
+	    return run;
+	}
+    }
+    return 0;
+}
+
+static void metrics_read(Run *run)
+{
+    string file = run->dir + "/out";
+    char line[256], name[128], value[128];
+    FILE *f;
+
+    if (!(f = fopen(file.c_str(), "r")))
+	return;
+
+    while (fgets(line, sizeof(line), f))
+	if (sscanf(line, "%127s %127s", name, value) == 2)
+	    run->metrics.push_back(std::make_pair(name, value));
+    fclose(f);
+}
+
+static void run_exec(Run *run)
+{
+    string out = run->dir + "/out", err = run->dir + "/err";
+    vector<char *> argv;
+    unsigned int i;
+    double start;
+    pid_t pid;
+    int status;
+
+    /* Only async signal safe calls are allowed in the child of a
+       threaded process, so everything is prepared here. */
+    for (i = 0; i < run->args.size(); i++)
+	argv.push_back((char *) run->args[i].c_str());
+    argv.push_back(NULL);
+
+    start = now();
+
+    if ((pid = fork()) < 0) {
+	perror("fork");
+	return;
+    }
+    if (pid == 0) {
+	int fd;
+
+	if ((fd = open(out.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+	    _exit(126);
+	dup2(fd, 1);
+	close(fd);
+	if ((fd = open(err.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0)
+	    _exit(126);
+	dup2(fd, 2);
+	close(fd);
+	execv(argv[0], &argv[0]);
+	_exit(127);
+    }
+    while (waitpid(pid, &status, 0) < 0) {
+	if (errno != EINTR) {
+	    perror("waitpid");
+	    return;
+	}
+    }
+    run->wall = now() - start;
+    run->status = WIFEXITED(status) ? WEXITSTATUS(status) :
+	128 + WTERMSIG(status);
+
+    if (run->status == 0)
+	metrics_read(run);
+}
+
+static void worker_main(unsigned int self)
+{
+    Run *run;
+
+    while ((run = run_next(self))) {
+	run_exec(run);
+
+	std::lock_guard<std::mutex> l(print_lock);
+	ndone++;
+	if (run->status == 0)
+	    fprintf(stderr, "[%d/%u] %s %.1f s\n", ndone,
+		    (unsigned int) runs.size(), run->dir.c_str(), run->wall);
+	else
+	    fprintf(stderr, "[%d/%u] %s FAILED (%d), see %s/err\n", ndone,
+		    (unsigned int) runs.size(), run->dir.c_str(), run->status,
+		    run->dir.c_str());
+    }
+}
+
+/* Writes one row per run. The metric columns are all metrics seen in
+   any run, in the order aodv-sim prints them; a run without a metric
+   (or a failed run) has "NA" there. */
+static int results_write(const char *file)
+{
+    vector<string> cols;
+    unsigned int i, j, k;
+    FILE *f;
+
+    cols.push_back("run");
+    cols.push_back("rep");
+    cols.push_back("seed");
+    for (i = 0; i < params.size(); i++)
+	cols.push_back(params[i].name);
+    cols.push_back("status");
+
+    unsigned int nfixed = cols.size();
+
+    for (i = 0; i < runs.size(); i++) {
+	for (j = 0; j < runs[i].metrics.size(); j++) {
+	    const string &m = runs[i].metrics[j].first;
+
+	    for (k = 0; k < cols.size(); k++)
+		if (cols[k] == m)
+		    break;
+	    if (k == cols.size())
+		cols.push_back(m);
+	}
+    }
+
+    if (!(f = fopen(file, "w"))) {
+	perror(file);
+	return -1;
+    }
+    for (k = 0; k < cols.size(); k++)
+	fprintf(f, "%s%c", cols[k].c_str(), k + 1 < cols.size() ? '\t' : '\n');
+
+    for (i = 0; i < runs.size(); i++) {
+	Run &r = runs[i];
+
+	fprintf(f, "%d\t%d\t%lu\t", r.id, r.rep, r.seed);
+	for (k = 0; k < r.values.size(); k++)
+	    fprintf(f, "%s\t", r.values[k].c_str());
+	fprintf(f, "%d", r.status);
+
+	for (k = nfixed; k < cols.size(); k++) {
+	    const char *v = "NA";
+
+	    for (j = 0; j < r.metrics.size(); j++) {
+		if (r.metrics[j].first == cols[k]) {
+		    v = r.metrics[j].second.c_str();
+		    break;
+		}
+	    }
+	    fprintf(f, "\t%s", v);
+	}
+	fprintf(f, "\n");
+    }
+    fclose(f);
+    return 0;
+}
+
+/* Aggregates a metric over the successful runs that match the
+   selection. Returns -1 if no such run has the metric. */
+static int operand_eval(const Operand &o, double *val)
+{
+    double sum = 0, x;
+    unsigned int i, j, n = 0;
+
+    if (o.is_num) {
+	*val = o.num;
+	return 0;
+    }
+    for (i = 0; i < runs.size(); i++) {
+	const Run &r = runs[i];
+
+	if (r.status != 0)
+	    continue;
+	for (j = 0; j < o.where.size(); j++)
+	    if (r.values[param_index(o.where[j].first)] != o.where[j].second)
+		break;
+	if (j < o.where.size())
+	    continue;
+	for (j = 0; j < r.metrics.size(); j++)
+	    if (r.metrics[j].first == o.metric)
+		break;
+	if (j == r.metrics.size())
+	    continue;
+
+	x = strtod(r.metrics[j].second.c_str(), NULL);
+
+	if (n == 0 || (o.agg == "min" && x < *val) ||
+	    (o.agg == "max" && x > *val))
+	    *val = x;
+	sum += x;
+	n++;
+    }
+    if (n == 0)
+	return -1;
+    if (o.agg == "mean")
+	*val = sum / n;
+    return 0;
+}
+
+/* Prints the outcome of every check and returns the number that
+   failed */
+static int checks_run(void)
+{
+    unsigned int i;
+    int nfailed = 0;
+
+    for (i = 0; i < checks.size(); i++) {
+	const Check &c = checks[i];
+	double l, r;
+	int ok;
+
+	if (operand_eval(c.lhs, &l) < 0 || operand_eval(c.rhs, &r) < 0) {
+	    printf("check %s: FAILED (no runs with the metric)\n",
+		   c.text.c_str());
+	    nfailed++;
+	    continue;
+	}
+	if (c.arith == '+')
+	    r += c.n;
+	else if (c.arith == '-')
+	    r -= c.n;
+	else if (c.arith == '*')
+	    r *= c.n;
+
+	if (c.op == "<")
+	    ok = l < r;
+	else if (c.op == "<=")
+	    ok = l <= r;
+	else if (c.op == ">")
+	    ok = l > r;
+	else if (c.op == ">=")
+	    ok = l >= r;
+	else if (c.op == "==")
+	    ok = l == r;
+	else
+	    ok = l != r;
+
+	printf("check %s: %s (%g %s %g)\n", c.text.c_str(),
+	       ok ? "ok" : "FAILED", l, c.op.c_str(), r);
+	if (!ok)
+	    nfailed++;
+    }
+    return nfailed;
+}
+
+static void usage(const char *progname, int status)
+{
+    fprintf(stderr,
+	    "Usage: %s [-j JOBS] [-d OUTDIR] [-x SIM] [-n] MATRIX\n\n"
+	    "-j  Number of simulations to run at once (default: one per CPU)\n"
+	    "-d  Output directory (default sweep). Each run gets a run-NNNN\n"
+	    "    directory in it, and the merged metrics go to results.tsv\n"
+	    "-x  Simulator to run (default aodv-sim next to this program)\n"
+	    "-n  Only print the runs\n\n"
+	    "Exits with 2 if a run failed and 3 if a check failed\n",
+	    progname);
+    exit(status);
+}
+
+int main(int argc, char **argv)
+{
+    const char *outdir = "sweep";
+    char sim[PATH_MAX];
+    int njobs = 0, dry_run = 0;
+    unsigned int i, j;
+    double start;
+    int opt, nfailed = 0, nchecks_failed;
+    ssize_t len;
+
+    /* Default to the aodv-sim in our own directory */
+    if ((len = readlink("/proc/self/exe", sim, sizeof(sim) - 1)) > 0) {
+	sim[len] = '\0';
+	if (strrchr(sim, '/'))
+	    strcpy(strrchr(sim, '/') + 1, "aodv-sim");
+    } else
+	strcpy(sim, "aodv-sim");
+
+    while ((opt = getopt(argc, argv, "j:d:x:nh")) != -1) {
+	switch (opt) {
+	case 'j':
+	    njobs = atoi(optarg);
+	    break;
+	case 'd':
+	    outdir = optarg;
+	    break;
+	case 'x':
+	    if (strlen(optarg) >= sizeof(sim))
+		usage(argv[0], 1);
+	    strcpy(sim, optarg);
+	    break;
+	case 'n':
+	    dry_run = 1;
+	    break;
+	case 'h':
+	    usage(argv[0], 0);
+	default:
+	    usage(argv[0], 1);
+	}
+    }
+    if (optind != argc - 1)
+	usage(argv[0], 1);
+
+    if (njobs <= 0 && (njobs = sysconf(_SC_NPROCESSORS_ONLN)) <= 0)
+	njobs = 1;
+
+    if (matrix_read(argv[optind]) < 0)
+	exit(1);
+
+    runs_build(sim, outdir);
+
+    if (dry_run) {
+	for (i = 0; i < runs.size(); i++) {
+	    for (j = 0; j < runs[i].args.size(); j++)
+		printf("%s%c", runs[i].args[j].c_str(),
+		       j + 1 < runs[i].args.size() ? ' ' : '\n');
+	}
+	return 0;
+    }
+
+    if (access(sim, X_OK) < 0) {
+	perror(sim);
+	exit(1);
+    }
+    if (mkdir(outdir, 0755) < 0 && errno != EEXIST) {
+	perror(outdir);
+	exit(1);
+    }
+    for (i = 0; i < runs.size(); i++) {
+	if (mkdir(runs[i].dir.c_str(), 0755) < 0 && errno != EEXIST) {
+	    perror(runs[i].dir.c_str());
+	    exit(1);
+	}
+    }
+
+    if ((unsigned int) njobs > runs.size())
+	njobs = runs.size();
+
+    for (i = 0; i < (unsigned int) njobs; i++)
+	workers.push_back(new Worker);
+    for (i = 0; i < runs.size(); i++)
+	workers[i % njobs]->runs.push_back(&runs[i]);
+
+    fprintf(stderr, "%u runs on %d workers\n", (unsigned int) runs.size(),
+	    njobs);
+
+    start = now();
+    {
+	vector<std::thread> threads;
+
+	for (i = 0; i < (unsigned int) njobs; i++)
+	    threads.push_back(std::thread(worker_main, i));
+	for (i = 0; i < threads.size(); i++)
+	    threads[i].join();
+    }
+
+    string results = string(outdir) + "/results.tsv";
+
+    if (results_write(results.c_str()) < 0)
+	exit(1);
+
+    for (i = 0; i < runs.size(); i++)
+	if (runs[i].status != 0)
+	    nfailed++;
+
+    fprintf(stderr, "Done in %.1f s, %d failed. Results in %s\n",
+	    now() - start, nfailed, results.c_str());
+
+    nchecks_failed = checks_run();
+
+    if (nfailed)
+	return 2;
+    return nchecks_failed ? 3 : 0;
+}
@@ -0,0 +1,355 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* Implementation of the ns-2 stand-in, see ns/ns-shim.h */
+
+#include <map>
+#include <string>
+
+#include "ns/ns-shim.h"
+#include "ns/common/encap.h"
+
+int Packet::hdrlen_ = 0;
+int Packet::uidcnt_ = 0;
+Packet *Packet::free_ = 0;
+
+int hdr_cmn::offset_;
+int hdr_ip::offset_;
+int hdr_encap::offset_;
+
+static class CommonHeaderClass : public PacketHeaderClass {
+public:
+    CommonHeaderClass() : PacketHeaderClass("PacketHeader/Common",
+					    sizeof(hdr_cmn)) {
+	bind_offset(&hdr_cmn::offset_);
+    }
+} class_cmnhdr;
+
+static class IPHeaderClass : public PacketHeaderClass {
+public:
+    IPHeaderClass() : PacketHeaderClass("PacketHeader/IP", sizeof(hdr_ip)) {
+	bind_offset(&hdr_ip::offset_);
+    }
+} class_iphdr;
+
+static class EncapHeaderClass : public PacketHeaderClass {
+public:
+    EncapHeaderClass() : PacketHeaderClass("PacketHeader/Encap",
+					   sizeof(hdr_encap)) {
+	bind_offset(&hdr_encap::offset_);
+    }
+} class_encaphdr;
+
+/* Headers are 8 byte aligned in the packet */
+void PacketHeaderClass::bind_offset(int *off)
+{
+    *off = Packet::hdrlen_;
+    Packet::hdrlen_ += (hdrlen_ + 7) & ~7;
+}
+
+/* Scheduler */
+
+Scheduler &Scheduler::instance()
+{
+    static Scheduler s;
+    return s;
+}
+
+void Scheduler::schedule(Handler *h, Event *e, double delay)
+{
+    assert(e->pos_ < 0 && delay >= 0);
+
+    if (n_ == max_) {
+	max_ = max_ ? max_ * 2 : 1024;
+	heap_ = (Event **) realloc(heap_, max_ * sizeof(Event *));
+	if (!heap_) {
+	    fprintf(stderr, "Scheduler: out of memory\n");
+	    exit(-1);
+	}
+    }
+    e->handler_ = h;
+    e->time_ = clock_ + delay;
+    e->uid_ = uid_++;
+    place(e, n_++);
+    up(e->pos_);
+}
+
+void Scheduler::cancel(Event *e)
+{
+    int i = e->pos_;
+
+    if (i < 0)
+	return;
+
+    e->pos_ = -1;
+
+    if (i == --n_)
+	return;
+
+    place(heap_[n_], i);
+    up(i);
+    down(i);
+}
+
+void Scheduler::up(int i)
+{
+    Event *e = heap_[i];
+
+    while (i > 0 && before(e, heap_[(i - 1) / 2])) {
+	place(heap_[(i - 1) / 2], i);
+	i = (i - 1) / 2;
+    }
+    place(e, i);
+}
+
+void Scheduler::down(int i)
+{
+    Event *e = heap_[i];
+    int c;
+
+    while ((c = 2 * i + 1) < n_) {
+	if (c + 1 < n_ && before(heap_[c + 1], heap_[c]))
+	    c++;
+	if (!before(heap_[c], e))
+	    break;
+	place(heap_[c], i);
+	i = c;
+    }
+    place(e, i);
+}
+
+unsigned long Scheduler::run(double until)
+{
+    unsigned long n = 0;
+
+    while (n_ > 0 && heap_[0]->time_ <= until) {
+	Event *e = heap_[0];
+
+	cancel(e);
+	clock_ = e->time_;
+	e->handler_->handle(e);
+	n++;
+    }
+    if (clock_ < until)
+	clock_ = until;
+
+    return n;
+}
+
+void Scheduler::reset()
+{
+    while (n_ > 0)
+	cancel(heap_[0]);
+    clock_ = 0;
+    uid_ = 0;
+}
+
+/* Timers */
+
+void TimerHandler::sched(double delay)
+{
+    assert(status_ != TIMER_PENDING);
+    Scheduler::instance().schedule(this, &event_, delay);
+    status_ = TIMER_PENDING;
+}
+
+void TimerHandler::resched(double delay)
+{
+    if (status_ == TIMER_PENDING)
+	Scheduler::instance().cancel(&event_);
+    status_ = TIMER_IDLE;
+    sched(delay);
+}
+
+void TimerHandler::cancel()
+{
+    if (status_ == TIMER_PENDING)
+	Scheduler::instance().cancel(&event_);
+    status_ = TIMER_IDLE;
+}
+
+void TimerHandler::handle(Event *e)
+{
+    status_ = TIMER_HANDLING;
+    expire(e);
+    if (status_ == TIMER_HANDLING)
+	status_ = TIMER_IDLE;
+}
+
+/* Packets. Freed packets are kept for reuse. */
+
+Packet *Packet::alloc()
+{
+    Packet *p = free_;
+
+    if (p) {
+	free_ = p->next_;
+	p->next_ = 0;
+    } else {
+	p = new Packet;
+	if (!(p->bits_ = (unsigned char *) malloc(hdrlen_))) {
+	    fprintf(stderr, "Packet: out of memory\n");
+	    exit(-1);
+	}
+    }
+    memset(p->bits_, 0, hdrlen_);
+    p->pos_ = -1;
+    p->uid_ = 0;
+    return p;
+}
+
+void Packet::free(Packet *p)
+{
+    assert(p->pos_ < 0);
+    p->next_ = free_;
+    free_ = p;
+}
+
+Packet *Packet::copy() const
+{
+    Packet *p = alloc();
+
+    memcpy(p->bits_, bits_, hdrlen_);
+    return p;
+}
+
+/* Tcl */
+
+static std::map<std::string, int> &tcl_defaults()
+{
+    static std::map<std::string, int> m;
+    return m;
+}
+
+static std::map<std::string, TclObject *> &tcl_objects()
+{
+    static std::map<std::string, TclObject *> m;
+    return m;
+}
+
+void TclObject::bind(const char *name, int *var)
+{
+    if (!get_default(name, var)) {
+	fprintf(stderr, "warning: no default value for %s\n", name);
+	*var = 0;
+    }
+}
+
+void TclObject::set_default(const char *name, int value)
+{
+    tcl_defaults()[name] = value;
+}
+
+int TclObject::get_default(const char *name, int *value)
+{
+    std::map<std::string, int>::iterator i = tcl_defaults().find(name);
+
+    if (i == tcl_defaults().end())
+	return 0;
+    *value = i->second;
+    return 1;
+}
+
+TclObject *TclObject::lookup(const char *name)
+{
+    std::map<std::string, TclObject *>::iterator i =
+	tcl_objects().find(name);
+
+    return i == tcl_objects().end() ? 0 : i->second;
+}
+
+void TclObject::enter(const char *name, TclObject *obj)
+{
+    tcl_objects()[name] = obj;
+}
+
+Address &Address::instance()
+{
+    static Address a;
+    return a;
+}
+
+/* 64 bit xorshift, seeded with Random::seed() */
+static unsigned long long rng_state = 88172645463325252ULL;
+
+void Random::seed(unsigned long s)
+{
+    rng_state = s * 2685821657736338717ULL + 88172645463325252ULL;
+    if (!rng_state)
+	rng_state = 1;
+}
+
+double Random::uniform()
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (rng_state >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/* Objects */
+
+int Connector::command(int argc, const char *const *argv)
+{
+    if (argc == 3) {
+	TclObject *obj = lookup(argv[2]);
+
+	if (!obj)
+	    return TCL_ERROR;
+	if (strcmp(argv[1], "target") == 0) {
+	    target_ = (NsObject *) obj;
+	    return TCL_OK;
+	}
+	if (strcmp(argv[1], "drop-target") == 0) {
+	    drop_ = (NsObject *) obj;
+	    return TCL_OK;
+	}
+    }
+    return TclObject::command(argc, argv);
+}
+
+void Connector::drop(Packet *p, const char *why)
+{
+    if (drop_)
+	drop_->recv(p, why);
+    else
+	Packet::free(p);
+}
+
+Packet *Agent::allocpkt() const
+{
+    Packet *p = Packet::alloc();
+    hdr_cmn *ch = HDR_CMN(p);
+    hdr_ip *ih = HDR_IP(p);
+
+    ch->ptype() = type_;
+    ch->size() = size_;
+    ch->uid() = Packet::uidcnt_++;
+    ch->timestamp() = Scheduler::instance().clock();
+    ih->saddr() = here_.addr_;
+    ih->sport() = here_.port_;
+    ih->daddr() = dst_.addr_;
+    ih->dport() = dst_.port_;
+    ih->ttl() = 32;
+
+    return p;
+}
@@ -0,0 +1,23 @@
+/* ns-2 header, see ns-shim.h */
+#ifndef _NS_COMMON_ENCAP_H
+#define _NS_COMMON_ENCAP_H
+
+#include "../ns-shim.h"
+
+/* IP in IP encapsulation, used for Internet gateway traffic */
+struct hdr_encap {
+    Packet *p_;
+
+    static int offset_;
+    inline static hdr_encap *access(const Packet * p) {
+	return (hdr_encap *) p->access(offset_);
+    }
+    void encap(Packet * p) { p_ = p; }
+    Packet *decap() {
+	Packet *p = p_;
+	p_ = 0;
+	return p;
+    }
+};
+
+#endif
@@ -0,0 +1,7 @@
+/* ns-2 header, see ns-shim.h */
+#ifndef _NS_COMMON_PACKET_H
+#define _NS_COMMON_PACKET_H
+
+#include "../ns-shim.h"
+
+#endif
@@ -0,0 +1,354 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* A minimal stand-in for the parts of ns-2 that the NS_PORT build of
+ * AODV-UU uses: packets and their headers, the scheduler, timers,
+ * agents and the few Tcl hooks of the agent class. It is enough to
+ * compile ns-2/aodv-uu.cc and the protocol sources unchanged and run
+ * them in aodv-sim, without an ns-2 tree.
+ *
+ * Class and method names follow ns-2 2.x, but only what AODV-UU
+ * touches is there. */
+
+#ifndef _NS_SHIM_H
+#define _NS_SHIM_H
+
+#include <sys/types.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+typedef int32_t nsaddr_t;
+
+#define TCL_OK    0
+#define TCL_ERROR 1
+
+#define IP_BROADCAST ((nsaddr_t) 0xffffffff)
+#define IP_HDR_LEN   20
+#define RT_PORT      255
+
+#define NS_AF_NONE  0
+#define NS_AF_ILINK 1
+#define NS_AF_INET  2
+
+enum packet_t {
+    PT_TCP,
+    PT_UDP,
+    PT_CBR,
+    PT_PING,
+    PT_AODVUU,
+    PT_ENCAPSULATED,
+    PT_NTYPE
+};
+
+#define DATA_PACKET(t) ((t) == PT_TCP || (t) == PT_UDP || (t) == PT_CBR)
+
+/* Drop reasons, as in ns-2's cmu-trace.h */
+#define DROP_END_OF_SIMULATION "END"
+#define DROP_MAC_PACKET_ERROR  "ERR"
+#define DROP_MAC_RETRY_COUNT_EXCEEDED "RET"
+#define DROP_RTR_NO_ROUTE      "NRTE"
+#define DROP_RTR_ROUTE_LOOP    "LOOP"
+#define DROP_RTR_TTL           "TTL"
+#define DROP_RTR_QFULL         "IFQ"
+#define DROP_RTR_QTIMEOUT      "TOUT"
+#define DROP_RTR_MAC_CALLBACK  "CBK"
+#define DROP_IFQ_QFULL         "IFQ"
+
+class Handler;
+class Packet;
+class TclObject;
+
+/* Scheduler */
+
+class Event {
+public:
+    Event() : time_(0), uid_(0), pos_(-1), handler_(0) {}
+    double time_;
+    unsigned long uid_;		/* Orders events at the same time */
+    int pos_;			/* Index in the heap, -1 if not queued */
+    Handler *handler_;
+};
+
+class Handler {
+public:
+    virtual ~Handler() {}
+    virtual void handle(Event *e) = 0;
+};
+
+/* Binary heap of events, ordered by time and then by when they were
+   scheduled. */
+class Scheduler {
+public:
+    static Scheduler &instance();
+    void schedule(Handler *h, Event *e, double delay);
+    void cancel(Event *e);
+    double clock() const { return clock_; }
+    /* Run events until the queue is empty or the time is past until.
+       Returns the number of events run. */
+    unsigned long run(double until);
+    void reset();
+    int size() const { return n_; }
+
+private:
+    Scheduler() : clock_(0), uid_(0), heap_(0), n_(0), max_(0) {}
+    void up(int i);
+    void down(int i);
+    void place(Event *e, int i) { heap_[i] = e; e->pos_ = i; }
+    bool before(Event *a, Event *b) const {
+	return a->time_ < b->time_ ||
+	    (a->time_ == b->time_ && a->uid_ < b->uid_);
+    }
+
+    double clock_;
+    unsigned long uid_;
+    Event **heap_;
+    int n_, max_;
+};
+
+class TimerHandler : public Handler {
+public:
+    enum TimerStatus { TIMER_IDLE, TIMER_PENDING, TIMER_HANDLING };
+
+    TimerHandler() : status_(TIMER_IDLE) {}
+    virtual ~TimerHandler() { cancel(); }
+    void sched(double delay);
+    void resched(double delay);
+    void cancel();
+    int status() const { return status_; }
+
+protected:
+    virtual void expire(Event *e) = 0;
+    virtual void handle(Event *e);
+    int status_;
+    Event event_;
+};
+
+/* Packets */
+
+class Packet : public Event {
+public:
+    unsigned char *access(int off) const {
+	assert(off >= 0);
+	return &bits_[off];
+    }
+    static Packet *alloc();
+    static void free(Packet *p);
+    Packet *copy() const;
+
+    static int hdrlen_;		/* Grows as header classes register */
+    static int uidcnt_;
+
+private:
+    Packet() : bits_(0), next_(0) {}
+    unsigned char *bits_;
+    Packet *next_;		/* Free list */
+    static Packet *free_;
+};
+
+struct hdr_cmn {
+    enum dir_t { DOWN = -1, NONE = 0, UP = 1 };
+
+    packet_t ptype_;
+    int size_;
+    int uid_;
+    double ts_;
+    dir_t direction_;
+    nsaddr_t prev_hop_;
+    nsaddr_t next_hop_;
+    int addr_type_;
+    int num_forwards_;
+    int iface_;
+    int error_;
+    void (*xmit_failure_) (Packet *, void *);
+    void *xmit_failure_data_;
+
+    static int offset_;
+    inline static hdr_cmn *access(const Packet * p) {
+	return (hdr_cmn *) p->access(offset_);
+    }
+
+    packet_t & ptype() { return ptype_; }
+    int &size() { return size_; }
+    int &uid() { return uid_; }
+    double &timestamp() { return ts_; }
+    dir_t & direction() { return direction_; }
+    nsaddr_t & prev_hop() { return prev_hop_; }
+    nsaddr_t & next_hop() { return next_hop_; }
+    int &addr_type() { return addr_type_; }
+    int &num_forwards() { return num_forwards_; }
+    int &iface() { return iface_; }
+    int &error() { return error_; }
+};
+
+struct hdr_ip {
+    nsaddr_t saddr_;
+    nsaddr_t daddr_;
+    int sport_;
+    int dport_;
+    int ttl_;
+
+    static int offset_;
+    inline static hdr_ip *access(const Packet * p) {
+	return (hdr_ip *) p->access(offset_);
+    }
+
+    nsaddr_t & saddr() { return saddr_; }
+    nsaddr_t & daddr() { return daddr_; }
+    int &sport() { return sport_; }
+    int &dport() { return dport_; }
+    int &ttl() { return ttl_; }
+};
+
+#define HDR_CMN(p) (hdr_cmn::access(p))
+#define HDR_IP(p)  (hdr_ip::access(p))
+
+/* Tcl */
+
+class TclObject {
+public:
+    virtual ~TclObject() {}
+    virtual int command(int argc, const char *const *argv) {
+	return TCL_ERROR;
+    }
+    /* Bound variables start out with the class default, see
+       set_default(). */
+    void bind(const char *name, int *var);
+    static void set_default(const char *name, int value);
+    static int get_default(const char *name, int *value);
+    static TclObject *lookup(const char *name);
+    static void enter(const char *name, TclObject * obj);
+};
+
+class TclClass {
+public:
+    TclClass(const char *classname) {}
+    virtual ~TclClass() {}
+    virtual TclObject *create(int argc, const char *const *argv) = 0;
+};
+
+class PacketHeaderClass : public TclClass {
+public:
+    PacketHeaderClass(const char *classname, int hdrlen)
+    : TclClass(classname), hdrlen_(hdrlen) {}
+    virtual TclObject *create(int argc, const char *const *argv) {
+	return 0;
+    }
+protected:
+    void bind_offset(int *off);
+    int hdrlen_;
+};
+
+class Address {
+public:
+    static Address &instance();
+    nsaddr_t str2addr(const char *str) const {
+	return (nsaddr_t) strtol(str, NULL, 0);
+    }
+    /* Addressing is flat, there are no subnets */
+    char *get_subnetaddr(nsaddr_t addr) const {
+	return 0;
+    }
+};
+
+class Random {
+public:
+    static void seed(unsigned long s);
+    static double uniform();
+    static double uniform(double a, double b) {
+	return a + (b - a) * uniform();
+    }
+    static int integer(int k) {
+	return (int) (uniform() * k);
+    }
+};
+
+/* Network objects */
+
+class NsObject : public TclObject, public Handler {
+public:
+    virtual void recv(Packet * p, Handler * h = 0) = 0;
+    /* Dropped packets, with the reason */
+    virtual void recv(Packet * p, const char *why) {
+	Packet::free(p);
+    }
+    virtual void handle(Event *e) {
+	recv((Packet *) e);
+    }
+};
+
+class Connector : public NsObject {
+public:
+    Connector() : target_(0), drop_(0) {}
+    virtual void recv(Packet * p, Handler * h = 0) {
+	target_->recv(p, h);
+    }
+    virtual int command(int argc, const char *const *argv);
+    void drop(Packet * p, const char *why = 0);
+
+protected:
+    NsObject *target_;
+    NsObject *drop_;
+};
+
+struct ns_addr_t {
+    nsaddr_t addr_;
+    int port_;
+};
+
+class Agent : public Connector {
+public:
+    Agent(packet_t pt) : type_(pt), size_(0) {
+	memset(&here_, 0, sizeof(here_));
+	memset(&dst_, 0, sizeof(dst_));
+    }
+    virtual void recv(Packet * p, Handler * h) {
+	Packet::free(p);
+    }
+    nsaddr_t & addr() { return here_.addr_; }
+    int &port() { return here_.port_; }
+    nsaddr_t & daddr() { return dst_.addr_; }
+    int &dport() { return dst_.port_; }
+
+protected:
+    Packet *allocpkt() const;
+
+    ns_addr_t here_;
+    ns_addr_t dst_;
+    packet_t type_;
+    int size_;
+};
+
+class MobileNode : public TclObject {
+};
+
+/* Interface queue. The simulator has none, so there is nothing to
+   filter. */
+class PriQueue : public Connector {
+public:
+    Packet *filter(nsaddr_t addr) { return 0; }
+    void filter(int (*filter) (Packet *, void *), void *data) {}
+    int length() { return 0; }
+};
+
+#endif				/* _NS_SHIM_H */
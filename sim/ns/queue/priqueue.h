@@ -0,0 +1,7 @@
+/* ns-2 header, see ns-shim.h */
+#ifndef _NS_QUEUE_PRIQUEUE_H
+#define _NS_QUEUE_PRIQUEUE_H
+
+#include "../ns-shim.h"
+
+#endif
@@ -0,0 +1,7 @@
+/* ns-2 header, see ns-shim.h */
+#ifndef _NS_TRACE_CMU_TRACE_H
+#define _NS_TRACE_CMU_TRACE_H
+
+#include "../ns-shim.h"
+
+#endif
@@ -0,0 +1,143 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+
+#include "defs.h"
+#include "debug.h"
+#include "timer_queue.h"
+#include "routing_table.h"
+#include "seek_list.h"
+#include "stats.h"
+
+extern struct disc_lat disc_lat;
+
+struct aodv_stats *aodv_stats = NULL;
+
+static struct timer stats_timer;
+
+/* Refresh the parts of the segment that are not counters */
+static void stats_sync(void *arg)
+{
+    struct timeval now;
+    int i, n = 0;
+
+    gettimeofday(&now, NULL);
+
+    stats_write_begin();
+
+    aodv_stats->sync_sec = now.tv_sec;
+    aodv_stats->sync_usec = now.tv_usec;
+    aodv_stats->rt_entries = rt_tbl.num_entries;
+    aodv_stats->rt_active = rt_tbl.num_active;
+    aodv_stats->seek_entries = seek_list_count();
+    aodv_stats->timers = timer_queue_len();
+    memcpy(&aodv_stats->disc_lat, &disc_lat, sizeof(disc_lat));
+
+    for (i = 0; i < RT_TABLESIZE; i++) {
+	list_t *pos;
+	list_foreach(pos, &rt_tbl.tbl[i]) {
+	    rt_table_t *rt = (rt_table_t *) pos;
+	    struct stats_rt *s;
+
+	    if (n == STATS_RT_MAX)
+		break;
+
+	    s = &aodv_stats->rt[n++];
+	    s->dest_addr = rt->dest_addr.s_addr;
+	    s->next_hop = rt->next_hop.s_addr;
+	    s->dest_seqno = rt->dest_seqno;
+	    s->hcnt = rt->hcnt;
+	    s->state = rt->state;
+	    s->flags = rt->flags;
+	}
+    }
+    aodv_stats->rt_count = n;
+
+    stats_write_end();
+
+    timer_set_timeout(&stats_timer, STATS_INTERVAL);
+}
+
+int stats_init(void)
+{
+    struct aodv_stats *s;
+    int fd;
+
+    fd = shm_open(AODV_STATS_SHM, O_RDWR | O_CREAT | O_TRUNC,
+		  S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+    if (fd < 0) {
+	alog(LOG_WARNING, errno, __FUNCTION__,
+	     "Could not create shared memory statistics");
+	return -1;
+    }
+
+    if (ftruncate(fd, sizeof(struct aodv_stats)) < 0) {
+	alog(LOG_WARNING, errno, __FUNCTION__,
+	     "Could not size shared memory statistics");
+	close(fd);
+	shm_unlink(AODV_STATS_SHM);
+	return -1;
+    }
+
+    s = mmap(NULL, sizeof(struct aodv_stats), PROT_READ | PROT_WRITE,
+	     MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (s == MAP_FAILED) {
+	alog(LOG_WARNING, errno, __FUNCTION__,
+	     "Could not map shared memory statistics");
+	shm_unlink(AODV_STATS_SHM);
+	return -1;
+    }
+
+    /* The segment is zero filled, the magic goes last so that readers
+       do not pick it up half initialized. */
+    s->version = AODV_STATS_VERSION;
+    s->size = sizeof(struct aodv_stats);
+    s->pid = getpid();
+    __sync_synchronize();
+    memcpy(s->magic, AODV_STATS_MAGIC, sizeof(AODV_STATS_MAGIC));
+
+    aodv_stats = s;
+
+    timer_init(&stats_timer, stats_sync, NULL);
+    stats_sync(NULL);
+
+    return 0;
+}
+
+void stats_cleanup(void)
+{
+    if (!aodv_stats)
+	return;
+
+    timer_remove(&stats_timer);
+    munmap(aodv_stats, sizeof(struct aodv_stats));
+    shm_unlink(AODV_STATS_SHM);
+
+    aodv_stats = NULL;
+}
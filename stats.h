@@ -0,0 +1,119 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+#ifndef _STATS_H
+#define _STATS_H
+
+#include "seek_list.h"
+
+/* Live statistics in shared memory.
+ *
+ * The daemon publishes its counters and a copy of the routing table in
+ * a POSIX shared memory segment that other processes can map read
+ * only. Writers bump seq before and after every change, so seq is odd
+ * while an update is in progress. A reader copies the segment and
+ * retries if seq was odd or changed meanwhile (a seqlock). Both sides
+ * use full memory barriers, compiler barriers alone let weakly ordered
+ * CPUs reorder the data stores around seq. */
+
+#define AODV_STATS_SHM "/aodvd-stats"
+#define AODV_STATS_MAGIC "AODVSTA"
+#define AODV_STATS_VERSION 3
+#define STATS_RT_MAX 1024	/* Routes mirrored, the rest are left out */
+#define STATS_INTERVAL 1000	/* msecs between table syncs */
+
+/* Message classes */
+#define STATS_RREQ     0
+#define STATS_RREP     1
+#define STATS_RERR     2
+#define STATS_RREP_ACK 3
+#define STATS_HELLO    4
+#define STATS_NTYPES   5
+
+struct stats_msg {
+    u_int32_t rx;
+    u_int32_t tx;
+    u_int32_t dropped;		/* Not sent, or thrown away on receive */
+    u_int32_t ratelimited;	/* Delayed by the rate limiter */
+    u_int32_t duplicate;	/* Already seen RREQs */
+};
+
+struct stats_rt {
+    u_int32_t dest_addr;	/* Network byte order */
+    u_int32_t next_hop;
+    u_int32_t dest_seqno;
+    u_int8_t hcnt;
+    u_int8_t state;
+    u_int16_t flags;
+};
+
+struct aodv_stats {
+    char magic[8];
+    u_int32_t version;
+    u_int32_t size;
+    volatile u_int32_t seq;
+    u_int32_t pid;
+    u_int32_t sync_sec;		/* Time of the last table sync */
+    u_int32_t sync_usec;
+    struct stats_msg msg[STATS_NTYPES];
+    u_int32_t rt_entries;
+    u_int32_t rt_active;
+    u_int32_t seek_entries;	/* Route discoveries in progress */
+    u_int32_t timers;		/* Timer queue depth */
+    struct disc_lat disc_lat;	/* Route discovery latency */
+    u_int32_t rt_count;
+    struct stats_rt rt[STATS_RT_MAX];
+};
+
+/* Message class of an AODV message type */
+#define STATS_TYPE(t) ((t) - 1)
+
+#ifdef NS_PORT
+#define STATS_INC(type, field) ((void) (type))
+#else
+extern struct aodv_stats *aodv_stats;
+
+int stats_init(void);
+void stats_cleanup(void);
+
+static inline void stats_write_begin(void)
+{
+    aodv_stats->seq++;
+    __sync_synchronize();
+}
+
+static inline void stats_write_end(void)
+{
+    __sync_synchronize();
+    aodv_stats->seq++;
+}
+
+#define STATS_INC(type, field)						\
+	do {								\
+		if (aodv_stats && (unsigned) (type) < STATS_NTYPES) {	\
+			stats_write_begin();				\
+			aodv_stats->msg[type].field++;			\
+			stats_write_end();				\
+		}							\
+	} while (0)
+#endif				/* NS_PORT */
+
+#endif				/* _STATS_H */
@@ -0,0 +1,360 @@
+#!/bin/bash
+#
+# Multi-node AODV-UU testbed on network namespaces.
+#
+# Every node is a namespace with a bridge (wl0) that aodvd runs on.
+# Links are veth pairs between the bridges of two nodes. The bridge
+# ports are isolated from each other, so a node only hears its direct
+# neighbors, like on a radio channel. They do not learn addresses
+# either, so unicast frames reach all neighbors and can be overheard
+# (see aodvd -p). Loss and delay per link are set with netem.
+#
+# By default aodvd runs with its user space data path (-U), so kaodv
+# is not needed. kaodv only works in the initial namespace, and -K is
+# only useful with a kaodv that has been made namespace aware.
+#
+# Usage: aodv-testbed.sh [-K] [-d OUTDIR] [-b BINDIR] [-o "AODVD OPTS"] SCENARIO
+#
+# Scenario commands, one per line, # starts a comment:
+#
+#   nodes N                   Create nodes 1..N (10.10.0.1 ...)
+#   link A B                  Connect A and B
+#   chain | full | grid W     Connect all nodes in a line, fully or in
+#                             a grid W nodes wide
+#   netem A B ARGS...         Set netem ARGS on the link, both ways
+#   opts ARGS...              Add ARGS to the aodvd options
+#   start                     Start aodvd on all nodes
+#   wait SECS                 Let the scenario run
+#   down A B | up A B         Take a link down or up
+#   flow SRC DST PPS LEN SECS Start a UDP flow from SRC to DST
+#   check flow F METRIC OP V  Check a result at the end, e.g.
+#   check node N METRIC OP V  "check flow 1 pdr >= 0.9"
+#
+# At the end the flow results and the aodvd statistics of each node
+# are collected in OUTDIR and summarized on stdout. Flow metrics are
+# pdr and those in the flow-F.tx and .rx files, node metrics are
+# ctrl_tx and, with "-p -r N", passive_learned, passive_used and
+# passive_seeded. OP is <, <=, >, >=, == or !=. The exit status is 3
+# if a check failed. OUTDIR is replaced on every run, but only if it
+# is empty or was created by an earlier run.
+
+PREFIX=aodvtb
+BINDIR=$(cd "$(dirname "$0")/.." && pwd)
+OUTDIR=testbed-out
+AODVD_OPTS="-D -S -l"
+USERSPACE=-U
+
+NODES=0
+LINKS=""
+FLOWS=0
+PIDS=""
+FLOW_PIDS=""
+NETEM_WARNED=0
+CHECKS=""
+
+die()
+{
+    echo "aodv-testbed: $*" >&2
+    exit 1
+}
+
+ns()
+{
+    echo "$PREFIX-$1"
+}
+
+addr()
+{
+    echo "10.10.0.$1"
+}
+
+teardown()
+{
+    local n pid
+
+    for pid in $FLOW_PIDS $PIDS; do
+	kill $pid 2>/dev/null
+    done
+    wait 2>/dev/null
+
+    for n in $(seq 1 $NODES); do
+	ip netns del $(ns $n) 2>/dev/null
+    done
+}
+
+add_node()
+{
+    local n=$1 ns=$(ns $1)
+
+    [ $n -le 250 ] || die "at most 250 nodes"
+
+    ip netns add $ns || die "could not create namespace $ns"
+    ip -n $ns link set lo up
+    ip -n $ns link add wl0 type bridge
+    ip -n $ns addr add $(addr $n)/24 dev wl0
+    ip -n $ns link set wl0 up
+    ip netns exec $ns sysctl -q -w net.ipv6.conf.all.disable_ipv6=1
+    ip netns exec $ns sysctl -q -w net.ipv4.conf.all.rp_filter=0
+    ip netns exec $ns sysctl -q -w net.ipv4.conf.default.rp_filter=0
+    mkdir -p "$OUTDIR/node-$n"
+}
+
+add_link()
+{
+    local a=$1 b=$2
+
+    [ $a -ne $b ] && [ $a -le $NODES ] && [ $b -le $NODES ] ||
+	die "bad link $a $b"
+
+    ip link add v$a-$b netns $(ns $a) type veth peer name v$b-$a \
+	netns $(ns $b) || die "could not create link $a $b"
+
+    for end in "$a $b" "$b $a"; do
+	set -- $end
+	ip -n $(ns $1) link set v$1-$2 master wl0
+	ip -n $(ns $1) link set v$1-$2 up
+	bridge -n $(ns $1) link set dev v$1-$2 isolated on learning off
+    done
+    LINKS="$LINKS $a-$b"
+}
+
+set_link()
+{
+    ip -n $(ns $1) link set v$1-$2 $3 &&
+	ip -n $(ns $2) link set v$2-$1 $3 || die "no link $1 $2"
+    echo "$(date +%T) link $1 $2 $3"
+}
+
+set_netem()
+{
+    local a=$1 b=$2
+    shift 2
+
+    for end in "$a $b" "$b $a"; do
+	set -- $end
+	if ! tc -n $(ns $1) qdisc replace dev v$1-$2 root netem "$@" \
+	    2>/dev/null; then
+	    [ $NETEM_WARNED -eq 1 ] ||
+		echo "aodv-testbed: netem not available, links are ideal" >&2
+	    NETEM_WARNED=1
+	    return
+	fi
+    done
+}
+
+start_aodvd()
+{
+    local n dir
+
+    for n in $(seq 1 $NODES); do
+	dir=$(cd "$OUTDIR/node-$n" && pwd)
+	# Private /dev/shm and /var/log, so that the statistics and logs
+	# of the nodes do not collide. "ip netns exec" already runs us in
+	# a mount namespace of our own.
+	ip netns exec $(ns $n) sh -c "mount -t tmpfs tmpfs /dev/shm &&
+	    mount --bind '$dir' /var/log &&
+	    exec $BINDIR/aodvd $USERSPACE $AODVD_OPTS -i wl0" \
+	    > "$OUTDIR/node-$n/aodvd.out" 2>&1 &
+	PIDS="$PIDS $!"
+    done
+    sleep 1
+
+    for pid in $PIDS; do
+	kill -0 $pid 2>/dev/null ||
+	    die "aodvd did not start, see $OUTDIR/node-*/aodvd.out"
+    done
+}
+
+start_flow()
+{
+    local src=$1 dst=$2 pps=$3 len=$4 secs=$5 port f
+
+    FLOWS=$((FLOWS + 1))
+    f="$OUTDIR/flow-$FLOWS"
+    port=$((5000 + FLOWS))
+    echo "$src $dst $pps $len $secs" > "$f.conf"
+
+    # The receiver waits a little longer for packets still in flight
+    ip netns exec $(ns $dst) $BINDIR/testbed/udpflow -R -p $port \
+	-t $(awk "BEGIN { print $secs + 2 }") > "$f.rx" &
+    FLOW_PIDS="$FLOW_PIDS $!"
+    ip netns exec $(ns $src) $BINDIR/testbed/udpflow -s $(addr $dst) \
+	-p $port -r $pps -l $len -t $secs > "$f.tx" &
+    FLOW_PIDS="$FLOW_PIDS $!"
+    echo "$(date +%T) flow $FLOWS $src -> $dst"
+}
+
+# Control messages sent by a node, from the aodv-stat table
+ctrl_tx()
+{
+    awk '$1 ~ /^(RREQ|RREP|RERR|RREP_ACK|HELLO)$/ { s += $3 }
+	END { print s + 0 }' "$1"
+}
+
+get()
+{
+    awk -v k=$1 '$1 == k { print $2 }' "$2"
+}
+
+summary()
+{
+    local n f pids ctrl=0 c
+
+    for pid in $FLOW_PIDS; do
+	wait $pid
+    done
+    FLOW_PIDS=""
+
+    for n in $(seq 1 $NODES); do
+	nsenter -t $(echo $PIDS | cut -d' ' -f$n) -m -n \
+	    $BINDIR/aodv-stat -r > "$OUTDIR/node-$n/stat.txt" 2>&1
+	c=$(ctrl_tx "$OUTDIR/node-$n/stat.txt")
+	ctrl=$((ctrl + c))
+    done
+
+    printf "%-5s %-4s %-4s %8s %8s %10s %10s %10s %10s\n" flow src dst \
+	tx rx kbps delay_ms max_ms first_ms
+    for f in $(seq 1 $FLOWS); do
+	f="$OUTDIR/flow-$f"
+	set -- $(cat "$f.conf")
+	printf "%-5s %-4s %-4s %8s %8s %10s %10s %10s %10s\n" \
+	    ${f##*-} $1 $2 $(get tx_packets "$f.tx") $(get rx_packets "$f.rx") \
+	    $(get throughput_kbps "$f.rx") $(get delay_avg_ms "$f.rx") \
+	    $(get delay_max_ms "$f.rx") $(get first_delay_ms "$f.rx")
+    done
+    echo "ctrl_tx $ctrl"
+    echo "Per node statistics are in $OUTDIR/node-*/stat.txt"
+}
+
+add_check()
+{
+    [ $# -eq 5 ] && { [ "$1" = flow ] || [ "$1" = node ]; } ||
+	die "bad check $*"
+    case $4 in
+    "<"|"<="|">"|">="|"=="|"!=") ;;
+    *) die "bad check operator $4" ;;
+    esac
+    CHECKS="$CHECKS$*
+"
+}
+
+flow_metric()
+{
+    local f="$OUTDIR/flow-$1" tx rx
+
+    [ -r "$f.conf" ] || return
+    if [ $2 = pdr ]; then
+	tx=$(get tx_packets "$f.tx")
+	rx=$(get rx_packets "$f.rx")
+	[ -n "$tx" ] && [ -n "$rx" ] &&
+	    awk "BEGIN { print $tx ? $rx / $tx : 0 }"
+    else
+	get $2 "$f.rx"
+	get $2 "$f.tx"
+    fi
+}
+
+node_metric()
+{
+    local d="$OUTDIR/node-$1" i
+
+    case $2 in
+    ctrl_tx) [ -r "$d/stat.txt" ] && ctrl_tx "$d/stat.txt" ;;
+    passive_learned) i=1 ;;
+    passive_used) i=2 ;;
+    passive_seeded) i=3 ;;
+    esac
+    # The last routing table dump has the totals
+    [ -n "$i" ] && [ -r "$d/aodvd.rtlog" ] &&
+	awk -v i=$i '/^# Overheard routes/ { split($NF, v, "/") }
+	    END { if (length(v)) print v[i] }' "$d/aodvd.rtlog"
+}
+
+run_checks()
+{
+    local failed=0 kind id metric op val v
+
+    while read -r kind id metric op val; do
+	[ -n "$kind" ] || continue
+	if [ $kind = flow ]; then
+	    v=$(flow_metric $id $metric | head -1)
+	else
+	    v=$(node_metric $id $metric)
+	fi
+	if [ -n "$v" ] && awk "BEGIN { exit !($v $op $val) }"; then
+	    echo "check $kind $id $metric $op $val: ok ($v)"
+	else
+	    echo "check $kind $id $metric $op $val: FAILED (${v:-no value})"
+	    failed=1
+	fi
+    done <<EOF
+$CHECKS
+EOF
+    return $failed
+}
+
+while getopts "Kd:b:o:h" opt; do
+    case $opt in
+    K) USERSPACE="" ;;
+    d) OUTDIR=$OPTARG ;;
+    b) BINDIR=$OPTARG ;;
+    o) AODVD_OPTS=$OPTARG ;;
+    *) sed -n '2,/^$/s/^# \?//p' $0; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+
+[ $# -eq 1 ] && [ -r "$1" ] || die "no scenario, try -h"
+[ $(id -u) -eq 0 ] || die "must be root"
+[ -x $BINDIR/aodvd ] || die "no aodvd in $BINDIR, run make"
+[ -x $BINDIR/testbed/udpflow ] || die "no udpflow, run make testbed"
+
+# Only ever remove an output directory that we created ourselves
+if [ -f "$OUTDIR/.aodv-testbed" ]; then
+    rm -rf "$OUTDIR"
+elif [ -e "$OUTDIR" ] && [ -n "$(ls -A "$OUTDIR" 2>/dev/null)" ]; then
+    die "$OUTDIR exists and is not a testbed output directory"
+fi
+mkdir -p "$OUTDIR" && touch "$OUTDIR/.aodv-testbed" ||
+    die "could not create $OUTDIR"
+trap teardown EXIT
+
+while read -r cmd args; do
+    set -- $args
+    case $cmd in
+    ""|\#*) ;;
+    nodes)
+	for n in $(seq $((NODES + 1)) $1); do
+	    add_node $n
+	done
+	NODES=$1 ;;
+    link) add_link $1 $2 ;;
+    chain)
+	for n in $(seq 2 $NODES); do
+	    add_link $((n - 1)) $n
+	done ;;
+    full)
+	for a in $(seq 1 $NODES); do
+	    for b in $(seq $((a + 1)) $NODES); do
+		add_link $a $b
+	    done
+	done ;;
+    grid)
+	for n in $(seq 1 $NODES); do
+	    [ $((n % $1)) -ne 0 ] && [ $n -lt $NODES ] &&
+		add_link $n $((n + 1))
+	    [ $((n + $1)) -le $NODES ] && add_link $n $((n + $1))
+	done ;;
+    netem) set_netem "$@" ;;
+    opts) AODVD_OPTS="$AODVD_OPTS $args" ;;
+    check) add_check "$@" ;;
+    start) start_aodvd ;;
+    wait) sleep $1 ;;
+    down|up) set_link $1 $2 $cmd ;;
+    flow) start_flow "$@" ;;
+    *) die "unknown command $cmd" ;;
+    esac
+done < "$1"
+
+summary
+run_checks || exit 3
@@ -0,0 +1,233 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* UDP test traffic for the namespace testbed.
+ *
+ * The sender puts a sequence number, the send time and the time the
+ * flow started in every packet. All namespaces share CLOCK_MONOTONIC,
+ * so the receiver can compute one way delays directly. The delay of
+ * the first packet that arrives includes the route discovery, which
+ * is what first_delay_ms reports. Results are printed as "name value"
+ * lines. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#define UDPFLOW_MAGIC 0x41554446
+#define UDPFLOW_PORT 5001
+#define UDPFLOW_MAXLEN 1472
+
+struct udpflow_hdr {
+    u_int32_t magic;
+    u_int32_t seq;
+    u_int64_t send_ns;
+    u_int64_t start_ns;
+};
+
+static u_int64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (u_int64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int sender(struct in_addr dst, int port, int pps, int len,
+		  double secs)
+{
+    char buf[UDPFLOW_MAXLEN];
+    struct udpflow_hdr *h = (struct udpflow_hdr *) buf;
+    struct sockaddr_in sin;
+    u_int64_t start, next, ival;
+    u_int32_t seq = 0;
+    int sock;
+
+    if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+	perror("socket");
+	return 1;
+    }
+    memset(buf, 0, sizeof(buf));
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    sin.sin_addr = dst;
+
+    ival = 1000000000ULL / pps;
+    start = next = now_ns();
+
+    while (next - start < (u_int64_t) (secs * 1e9)) {
+	u_int64_t t = now_ns();
+	struct timespec ts;
+
+	if (t < next) {
+	    ts.tv_sec = (next - t) / 1000000000ULL;
+	    ts.tv_nsec = (next - t) % 1000000000ULL;
+	    nanosleep(&ts, NULL);
+	}
+	h->magic = htonl(UDPFLOW_MAGIC);
+	h->seq = htonl(seq++);
+	h->send_ns = now_ns();
+	h->start_ns = start;
+
+	/* Errors are expected while there is no route */
+	sendto(sock, buf, len, 0, (struct sockaddr *) &sin, sizeof(sin));
+	next += ival;
+    }
+    close(sock);
+
+    printf("tx_packets %u\n", seq);
+    printf("tx_bytes %llu\n", (unsigned long long) seq * len);
+    return 0;
+}
+
+static int receiver(int port, double secs)
+{
+    char buf[UDPFLOW_MAXLEN];
+    struct udpflow_hdr *h = (struct udpflow_hdr *) buf;
+    struct sockaddr_in sin;
+    struct timeval tv;
+    u_int64_t end, t, d, first_rx = 0, last_rx = 0, sum = 0, max = 0;
+    u_int64_t first_delay = 0, bytes = 0;
+    u_int32_t rx = 0, max_seq = 0;
+    int sock, len;
+
+    if ((sock = socket(AF_INET, SOCK_DGRAM, 0)) < 0) {
+	perror("socket");
+	return 1;
+    }
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port);
+    sin.sin_addr.s_addr = INADDR_ANY;
+
+    if (bind(sock, (struct sockaddr *) &sin, sizeof(sin)) < 0) {
+	perror("bind");
+	return 1;
+    }
+    tv.tv_sec = 0;
+    tv.tv_usec = 100000;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    end = now_ns() + (u_int64_t) (secs * 1e9);
+
+    while ((t = now_ns()) < end) {
+	len = recv(sock, buf, sizeof(buf), 0);
+
+	if (len < (int) sizeof(struct udpflow_hdr) ||
+	    ntohl(h->magic) != UDPFLOW_MAGIC)
+	    continue;
+
+	t = now_ns();
+	d = t - h->send_ns;
+
+	if (!rx) {
+	    first_rx = t;
+	    first_delay = t - h->start_ns;
+	}
+	last_rx = t;
+	rx++;
+	bytes += len;
+	sum += d;
+	if (d > max)
+	    max = d;
+	if (ntohl(h->seq) > max_seq)
+	    max_seq = ntohl(h->seq);
+    }
+    close(sock);
+
+    printf("rx_packets %u\n", rx);
+    printf("rx_bytes %llu\n", (unsigned long long) bytes);
+    if (!rx)
+	return 0;
+    printf("lost %u\n", max_seq + 1 - rx);
+    printf("throughput_kbps %.1f\n", last_rx > first_rx ?
+	   bytes * 8 / ((last_rx - first_rx) / 1e6) : 0.0);
+    printf("delay_avg_ms %.3f\n", sum / (double) rx / 1e6);
+    printf("delay_max_ms %.3f\n", max / 1e6);
+    printf("first_delay_ms %.3f\n", first_delay / 1e6);
+    return 0;
+}
+
+static void usage(char *progname)
+{
+    fprintf(stderr, "Usage: %s -s DEST [-r PPS] [-l LEN] [-t SECS] [-p PORT]\n"
+	    "       %s -R [-t SECS] [-p PORT]\n\n"
+	    "-s DEST  Send to DEST.\n"
+	    "-R       Receive and print statistics after SECS.\n"
+	    "-r PPS   Packets per second (default 10).\n"
+	    "-l LEN   Payload length (default 512).\n"
+	    "-t SECS  Duration (default 10).\n"
+	    "-p PORT  UDP port (default %d).\n", progname, progname,
+	    UDPFLOW_PORT);
+    exit(1);
+}
+
+int main(int argc, char **argv)
+{
+    struct in_addr dst;
+    int opt, recv_mode = 0, send_mode = 0, pps = 10, len = 512;
+    int port = UDPFLOW_PORT;
+    double secs = 10;
+
+    while ((opt = getopt(argc, argv, "s:Rr:l:t:p:h")) != -1) {
+	switch (opt) {
+	case 's':
+	    if (!inet_aton(optarg, &dst))
+		usage(argv[0]);
+	    send_mode = 1;
+	    break;
+	case 'R':
+	    recv_mode = 1;
+	    break;
+	case 'r':
+	    pps = atoi(optarg);
+	    break;
+	case 'l':
+	    len = atoi(optarg);
+	    break;
+	case 't':
+	    secs = atof(optarg);
+	    break;
+	case 'p':
+	    port = atoi(optarg);
+	    break;
+	default:
+	    usage(argv[0]);
+	}
+    }
+    if (send_mode == recv_mode || pps <= 0 || secs <= 0 ||
+	len < (int) sizeof(struct udpflow_hdr) || len > UDPFLOW_MAXLEN)
+	usage(argv[0]);
+
+    if (send_mode)
+	return sender(dst, port, pps, len, secs);
+    return receiver(port, secs);
+}
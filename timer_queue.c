@@ -118,19 +118,15 @@ NS_STATIC void NS_CLASS timer_add(struct timer *t)
     printf("New timer added!\n");
 #endif
 
-    /* Base case when queue is empty: */
-    if (list_empty(&TQ)) {
-	list_add(&TQ, &t->l);
-    } else {
-
-	list_foreach(pos, &TQ) {
-	    struct timer *curr = (struct timer *) pos;
-	    if (timeval_diff(&t->timeout, &curr->timeout) < 0) {
-		break;
-	    }
-	}
-	list_add(pos->prev, &t->l);
+    /* Most timers are set to a fixed interval from now, so they
+       usually belong at the end of the queue. Search from the back and
+       insert after the last timer that does not expire later. */
+    list_foreach_reverse(pos, &TQ) {
+	struct timer *curr = (struct timer *) pos;
+	if (timeval_diff(&t->timeout, &curr->timeout) >= 0)
+	    break;
     }
+    list_add(pos, &t->l);
 
 #ifdef DEBUG_TIMER_QUEUE
     printTQ(&TQ);
@@ -138,6 +134,17 @@ NS_STATIC void NS_CLASS timer_add(struct timer *t)
     return;
 }
 
+int NS_CLASS timer_queue_len()
+{
+    list_t *pos;
+    int n = 0;
+
+    list_foreach(pos, &TQ)
+	n++;
+
+    return n;
+}
+
 int NS_CLASS timer_remove(struct timer *t)
 {
     int res = 1;
@@ -74,6 +74,7 @@ static inline int timeval_add_msec(struct timeval *t, unsigned long msec)
 #ifndef NS_NO_DECLARATIONS
 void timer_queue_init();
 int timer_remove(struct timer *t);
+int timer_queue_len();
 void timer_set_timeout(struct timer *t, long msec);
 int timer_timeout_now(struct timer *t);
 struct timeval *timer_age_queue();
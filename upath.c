@@ -0,0 +1,437 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+
+/* User space data path.
+ *
+ * Normally kaodv hooks into netfilter to queue packets while a route
+ * is discovered, to refresh route lifetimes on use and to ask for
+ * RERRs. Where the module cannot be loaded (containers, network
+ * namespaces, kernels it does not build for) the daemon can do the
+ * same from user space:
+ *
+ * - A tun device is routed the two halves of each AODV subnet. These
+ *   are more specific than the connected route, but less specific
+ *   than the /32 routes the daemon installs, so only packets without
+ *   an AODV route end up on the tun. Locally generated ones are queued
+ *   and trigger a route discovery, forwarded ones get a RERR, or a
+ *   local repair if the route is being repaired.
+ *
+ * - A packet socket watches data packets on the AODV interfaces and
+ *   refreshes the routes they use, like ROUTE_UPDATE from kaodv.
+ *
+ * Queued packets are sent again through a raw socket when the route
+ * is added. Gateway tunneling is not available in this mode. */
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+#include <linux/if_packet.h>
+#include <linux/filter.h>
+#include <linux/rtnetlink.h>
+
+#include "defs.h"
+#include "debug.h"
+#include "list.h"
+#include "params.h"
+#include "upath.h"
+#include "nl.h"
+#include "routing_table.h"
+#include "aodv_rreq.h"
+
+struct upath_pkt {
+    list_t l;
+    struct in_addr dest_addr;
+    int len;
+    unsigned char data[0];
+};
+
+static LIST(upath_queue);
+static int upath_qlen = 0;
+
+static int tun_fd = -1;
+static int tun_ifindex = 0;
+static int raw_sock = -1;
+static int snoop_sock = -1;
+
+#define UPATH_BUFSIZE 65535
+
+/* Non-AODV IP packets, host and outgoing only. Only the addresses
+   are needed, so the packet is cut after the IP header. Outgoing
+   packets are only seen by ETH_P_ALL sockets, so the protocol is
+   checked here. */
+static struct sock_filter upath_filter[] = {
+    BPF_STMT(BPF_LD | BPF_H | BPF_ABS, SKF_AD_OFF + SKF_AD_PROTOCOL),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_P_IP, 0, 11),
+    BPF_STMT(BPF_LD | BPF_W | BPF_ABS, SKF_AD_OFF + SKF_AD_PKTTYPE),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_HOST, 1, 0),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, PACKET_OUTGOING, 0, 8),
+    BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 9),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, 0, 5),
+    BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 6),
+    BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1fff, 3, 0),
+    BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+    BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),
+    BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, AODV_PORT, 1, 0),
+    BPF_STMT(BPF_RET | BPF_K, sizeof(struct iphdr)),
+    BPF_STMT(BPF_RET | BPF_K, 0),
+};
+
+static int upath_is_local(struct in_addr addr)
+{
+    int i;
+
+    for (i = 0; i < MAX_NR_INTERFACES; i++)
+	if (DEV_NR(i).enabled && DEV_NR(i).ipaddr.s_addr == addr.s_addr)
+	    return 1;
+    return 0;
+}
+
+/* Hand a packet back to the IP stack. The TTL is decremented so that
+   a packet can not circle between the tun and us for ever if the
+   kernel route is missing. */
+static void upath_send(unsigned char *data, int len, struct in_addr dest_addr)
+{
+    struct iphdr *ip = (struct iphdr *) data;
+    struct sockaddr_in dst;
+
+    if (ip->ttl <= 1) {
+	DEBUG(LOG_DEBUG, 0, "TTL expired for %s", ip_to_str(dest_addr));
+	return;
+    }
+    ip->ttl--;
+
+    memset(&dst, 0, sizeof(dst));
+    dst.sin_family = AF_INET;
+    dst.sin_addr = dest_addr;
+
+    if (sendto(raw_sock, data, len, 0, (struct sockaddr *) &dst,
+	       sizeof(dst)) < 0)
+	DEBUG(LOG_DEBUG, errno, "Could not send packet to %s",
+	      ip_to_str(dest_addr));
+}
+
+static void upath_queue_pkt(unsigned char *data, int len,
+			    struct in_addr dest_addr)
+{
+    struct upath_pkt *p;
+
+    if (upath_qlen >= UPATH_QUEUE_MAX) {
+	DEBUG(LOG_DEBUG, 0, "Queue full, dropping packet for %s",
+	      ip_to_str(dest_addr));
+	return;
+    }
+
+    p = (struct upath_pkt *) malloc(sizeof(struct upath_pkt) + len);
+
+    if (!p) {
+	alog(LOG_WARNING, 0, __FUNCTION__, "Malloc failed!");
+	return;
+    }
+    p->dest_addr = dest_addr;
+    p->len = len;
+    memcpy(p->data, data, len);
+
+    list_add_tail(&upath_queue, &p->l);
+    upath_qlen++;
+}
+
+/* Packets the kernel had no route for */
+static void upath_tun_callback(int fd)
+{
+    unsigned char buf[UPATH_BUFSIZE];
+    struct iphdr *ip = (struct iphdr *) buf;
+    struct in_addr dest_addr, src_addr;
+    rt_table_t *fwd_rt;
+    int len;
+
+    len = read(fd, buf, sizeof(buf));
+
+    if (len < (int) sizeof(struct iphdr) || ip->version != 4)
+	return;
+
+    dest_addr.s_addr = ip->daddr;
+    src_addr.s_addr = ip->saddr;
+
+    fwd_rt = rt_table_find(dest_addr);
+
+    /* The route was added while the packet was on its way */
+    if (fwd_rt && fwd_rt->state == VALID) {
+	upath_send(buf, len, dest_addr);
+	return;
+    }
+
+    if (upath_is_local(src_addr)) {
+	upath_queue_pkt(buf, len, dest_addr);
+	rreq_route_discovery(dest_addr, 0, NULL);
+    } else if (fwd_rt && (fwd_rt->flags & RT_REPAIR)) {
+	upath_queue_pkt(buf, len, dest_addr);
+	rreq_local_repair(fwd_rt, src_addr, NULL);
+    } else
+	nl_send_rerr_unsolicited(dest_addr, src_addr,
+				 fwd_rt ? fwd_rt->ifindex : DEV_NR(0).ifindex);
+}
+
+/* A route is fresh if it was refreshed less than UPATH_REFRESH msecs
+   ago, or if there is nothing to refresh. */
+static int upath_fresh(rt_table_t * rt, struct timeval *now)
+{
+    if (!rt || rt->state != VALID || !rt->rt_timer.used)
+	return 1;
+
+    return timeval_diff(&rt->rt_timer.timeout, now) >
+	ACTIVE_ROUTE_TIMEOUT - UPATH_REFRESH;
+}
+
+/* Data packets sent or received on the AODV interfaces */
+static void upath_snoop_callback(int fd)
+{
+    unsigned char buf[sizeof(struct iphdr)];
+    struct iphdr *ip = (struct iphdr *) buf;
+    struct sockaddr_ll sll;
+    socklen_t sll_len = sizeof(sll);
+    struct in_addr dest_addr, src_addr;
+    struct timeval now;
+    rt_table_t *fwd_rt, *rev_rt;
+    int len;
+
+    len = recvfrom(fd, buf, sizeof(buf), 0, (struct sockaddr *) &sll,
+		   &sll_len);
+
+    if (len < (int) sizeof(struct iphdr) ||
+	ifindex2devindex(sll.sll_ifindex) == MAX_NR_INTERFACES)
+	return;
+
+    dest_addr.s_addr = ip->daddr;
+    src_addr.s_addr = ip->saddr;
+
+    if (dest_addr.s_addr == AODV_BROADCAST ||
+	dest_addr.s_addr == DEV_IFINDEX(sll.sll_ifindex).broadcast.s_addr ||
+	IN_MULTICAST(ntohl(dest_addr.s_addr)))
+	return;
+
+    fwd_rt = rt_table_find(dest_addr);
+    rev_rt = rt_table_find(src_addr);
+
+    gettimeofday(&now, NULL);
+
+    if (upath_fresh(fwd_rt, &now) && upath_fresh(rev_rt, &now))
+	return;
+
+    rt_table_update_route_timeouts(fwd_rt, rev_rt);
+}
+
+static int upath_tun_open(void)
+{
+    struct ifreq ifr;
+    int sock;
+
+    tun_fd = open("/dev/net/tun", O_RDWR);
+
+    if (tun_fd < 0) {
+	alog(LOG_ERR, errno, __FUNCTION__, "Could not open /dev/net/tun");
+	return -1;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TUN | IFF_NO_PI;
+    strncpy(ifr.ifr_name, UPATH_IFNAME, IFNAMSIZ - 1);
+
+    if (ioctl(tun_fd, TUNSETIFF, &ifr) < 0) {
+	alog(LOG_ERR, errno, __FUNCTION__, "Could not create %s",
+	     UPATH_IFNAME);
+	return -1;
+    }
+
+    sock = socket(AF_INET, SOCK_DGRAM, 0);
+
+    if (sock < 0)
+	return -1;
+
+    if (ioctl(sock, SIOCGIFINDEX, &ifr) < 0) {
+	close(sock);
+	return -1;
+    }
+    tun_ifindex = ifr.ifr_ifindex;
+
+    if (ioctl(sock, SIOCGIFFLAGS, &ifr) < 0) {
+	close(sock);
+	return -1;
+    }
+    ifr.ifr_flags |= IFF_UP;
+
+    if (ioctl(sock, SIOCSIFFLAGS, &ifr) < 0) {
+	alog(LOG_ERR, errno, __FUNCTION__, "Could not bring up %s",
+	     UPATH_IFNAME);
+	close(sock);
+	return -1;
+    }
+    close(sock);
+    return 0;
+}
+
+/* Route both halves of the subnet of each AODV interface to the tun */
+static int upath_add_subnet_routes(void)
+{
+    struct in_addr net, mask;
+    u_int32_t m, half;
+    int i, j;
+
+    for (i = 0; i < MAX_NR_INTERFACES; i++) {
+	if (!DEV_NR(i).enabled)
+	    continue;
+
+	m = ntohl(DEV_NR(i).netmask.s_addr);
+	half = (~m + 1) >> 1;	/* Highest host bit */
+
+	if (half < 2) {
+	    alog(LOG_ERR, 0, __FUNCTION__,
+		 "%s needs a subnet of at least 4 addresses",
+		 DEV_NR(i).ifname);
+	    return -1;
+	}
+	mask.s_addr = htonl(m | half);
+
+	for (j = 0; j < 2; j++) {
+	    net.s_addr = htonl((ntohl(DEV_NR(i).ipaddr.s_addr) & m) |
+			       (j ? half : 0));
+
+	    if (nl_kern_route(RTM_NEWROUTE, NLM_F_CREATE, AF_INET,
+			      tun_ifindex, &net, &net, &mask, 0) < 0) {
+		alog(LOG_ERR, 0, __FUNCTION__, "Could not route %s to %s",
+		     ip_to_str(net), UPATH_IFNAME);
+		return -1;
+	    }
+	}
+    }
+    return 0;
+}
+
+int upath_init(void)
+{
+    struct sock_fprog fprog;
+
+    if (upath_tun_open() < 0 || upath_add_subnet_routes() < 0)
+	exit(-1);
+
+    raw_sock = socket(AF_INET, SOCK_RAW, IPPROTO_RAW);
+
+    if (raw_sock < 0) {
+	alog(LOG_ERR, errno, __FUNCTION__, "Could not open raw socket");
+	exit(-1);
+    }
+
+    snoop_sock = socket(PF_PACKET, SOCK_DGRAM, htons(ETH_P_ALL));
+
+    if (snoop_sock < 0) {
+	alog(LOG_ERR, errno, __FUNCTION__, "Could not open packet socket");
+	exit(-1);
+    }
+
+    fprog.len = sizeof(upath_filter) / sizeof(upath_filter[0]);
+    fprog.filter = upath_filter;
+
+    if (setsockopt(snoop_sock, SOL_SOCKET, SO_ATTACH_FILTER,
+		   &fprog, sizeof(fprog)) < 0) {
+	alog(LOG_ERR, errno, __FUNCTION__, "Could not attach filter");
+	exit(-1);
+    }
+
+    if (attach_callback_func(tun_fd, upath_tun_callback) < 0 ||
+	attach_callback_func(snoop_sock, upath_snoop_callback) < 0) {
+	alog(LOG_ERR, 0, __FUNCTION__, "Could not attach callback.");
+	exit(-1);
+    }
+
+    alog(LOG_NOTICE, 0, __FUNCTION__, "User space data path on %s",
+	 UPATH_IFNAME);
+    return 0;
+}
+
+void upath_cleanup(void)
+{
+    list_t *pos, *tmp;
+
+    list_foreach_safe(pos, tmp, &upath_queue) {
+	list_detach(pos);
+	free(pos);
+    }
+    upath_qlen = 0;
+
+    /* The subnet routes go away with the tun device */
+    if (tun_fd >= 0)
+	close(tun_fd);
+    if (raw_sock >= 0)
+	close(raw_sock);
+    if (snoop_sock >= 0)
+	close(snoop_sock);
+
+    tun_fd = raw_sock = snoop_sock = -1;
+}
+
+void upath_route_added(struct in_addr dest_addr)
+{
+    list_t *pos, *tmp;
+    int n = 0;
+
+    list_foreach_safe(pos, tmp, &upath_queue) {
+	struct upath_pkt *p = (struct upath_pkt *) pos;
+
+	if (p->dest_addr.s_addr != dest_addr.s_addr)
+	    continue;
+
+	list_detach(pos);
+	upath_qlen--;
+	upath_send(p->data, p->len, dest_addr);
+	free(p);
+	n++;
+    }
+    if (n)
+	DEBUG(LOG_DEBUG, 0, "Sent %d queued packets to %s", n,
+	      ip_to_str(dest_addr));
+}
+
+void upath_no_route(struct in_addr dest_addr)
+{
+    list_t *pos, *tmp;
+    int n = 0;
+
+    list_foreach_safe(pos, tmp, &upath_queue) {
+	struct upath_pkt *p = (struct upath_pkt *) pos;
+
+	if (p->dest_addr.s_addr != dest_addr.s_addr)
+	    continue;
+
+	list_detach(pos);
+	upath_qlen--;
+	free(p);
+	n++;
+    }
+    if (n)
+	DEBUG(LOG_DEBUG, 0, "Dropped %d queued packets to %s", n,
+	      ip_to_str(dest_addr));
+}
@@ -0,0 +1,44 @@
+/*****************************************************************************
+ *
+ * Copyright (C) 2026 agent.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ * Author: agent, <agent@local>
+ *
+ *****************************************************************************/
+#ifndef _UPATH_H
+#define _UPATH_H
+
+#include "defs.h"
+
+#define UPATH_IFNAME "aodv0"
+
+/* Packets waiting for a route discovery, same default as kaodv */
+#define UPATH_QUEUE_MAX 1024
+
+/* Data packets only refresh a route when it has been idle for this
+   many msecs, so that busy flows do not touch the timer queue for
+   every packet. */
+#define UPATH_REFRESH 100
+
+extern int userspace_path;
+
+int upath_init(void);
+void upath_cleanup(void);
+void upath_route_added(struct in_addr dest_addr);
+void upath_no_route(struct in_addr dest_addr);
+
+#endif				/* _UPATH_H */